@@ -0,0 +1,215 @@
+
+#ifndef ASYNC_IO_HPP
+#define ASYNC_IO_HPP
+
+
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <cassert>
+#include <sys/types.h>
+
+
+namespace cuttlefish
+{
+
+// =============================================================================
+// A positional read or write request to a file, serviced asynchronously by
+// `Async_IO`. The memory of the request must remain valid until it has been
+// waited on.
+class IO_Request
+{
+    friend class Async_IO;
+
+private:
+
+    // States of a request.
+    enum State : uint8_t
+    {
+        idle,       // No I/O is pending, and the result of the last one has been collected.
+        pending,    // The I/O has been issued and is yet to complete.
+        done,       // The I/O has completed successfully.
+        failed,     // The I/O has failed.
+    };
+
+    int fd; // Descriptor of the file.
+    char* buf;  // Memory to read into or write from.
+    std::size_t bytes;  // Number of bytes to transfer.
+    off_t off;  // Byte-offset into the file.
+    bool is_write;  // Whether the request is a write.
+    std::size_t transferred;    // Number of bytes transferred so far.
+
+    std::atomic<uint8_t> state; // State of the request.
+
+
+public:
+
+    // Constructs an idle request.
+    IO_Request():
+          fd(-1)
+        , buf(nullptr)
+        , bytes(0)
+        , off(0)
+        , is_write(false)
+        , transferred(0)
+        , state(idle)
+    {}
+
+    // Moves the idle request `rhs`.
+    IO_Request(IO_Request&& rhs):
+          fd(rhs.fd)
+        , buf(rhs.buf)
+        , bytes(rhs.bytes)
+        , off(rhs.off)
+        , is_write(rhs.is_write)
+        , transferred(rhs.transferred)
+        , state(rhs.state.load(std::memory_order_acquire))
+    {
+        assert(state == idle);
+    }
+
+    IO_Request(const IO_Request&) = delete;
+    IO_Request& operator=(const IO_Request&) = delete;
+    IO_Request& operator=(IO_Request&&) = delete;
+
+    // Returns whether the result of the request is yet to be collected.
+    bool in_flight() const { return state.load(std::memory_order_acquire) != idle; }
+};
+
+
+// =============================================================================
+// Process-wide asynchronous positional file-I/O service. The requests are
+// serviced with `io_uring` if the build has it (`CF_IO_URING`) and the kernel
+// allows it; otherwise, by a pool of I/O threads issuing blocking `pread`s and
+// `pwrite`s. Requests from multiple threads can be issued concurrently.
+class Async_IO
+{
+    class Backend;
+    class Thread_Pool_Backend;
+    class IO_Uring_Backend;
+
+private:
+
+    static constexpr std::size_t min_thread_count = 4;  // Minimum number of I/O threads of the thread-pool backend.
+
+    std::mutex done_mtx;    // Mutex guarding the completions of the requests.
+    std::condition_variable done_cv;    // Condition variable to notify the completions of the requests.
+
+    std::unique_ptr<Backend> backend;   // The servicing backend; declared last so that it is shut down first.
+
+
+    Async_IO();
+
+    // Issues the idle request `r` for transferring `bytes` bytes between `buf`
+    // and byte-offset `off` of the file with descriptor `fd`. `is_write`
+    // denotes whether it is a write.
+    void issue(IO_Request& r, int fd, char* buf, std::size_t bytes, off_t off, bool is_write);
+
+    // Marks the request `r` complete, with success iff `ok` is `true`.
+    void complete(IO_Request& r, bool ok);
+
+    // Services the request `r` synchronously; returns `true` iff it succeeds.
+    static bool service(IO_Request& r);
+
+public:
+
+    ~Async_IO();
+
+    Async_IO(const Async_IO&) = delete;
+    Async_IO& operator=(const Async_IO&) = delete;
+
+    // Returns the I/O service.
+    static Async_IO& get();
+
+    // Returns the name of the servicing backend.
+    const char* backend_name() const;
+
+    // Issues writing `bytes` bytes from `buf` to byte-offset `off` of the file
+    // with descriptor `fd`, tracked with the idle request `r`.
+    void write(IO_Request& r, int fd, const void* buf, std::size_t bytes, off_t off);
+
+    // Issues reading `bytes` bytes into `buf` from byte-offset `off` of the
+    // file with descriptor `fd`, tracked with the idle request `r`. The file
+    // should have all the bytes.
+    void read(IO_Request& r, int fd, void* buf, std::size_t bytes, off_t off);
+
+    // Waits for the request `r` to complete, and returns `true` iff it
+    // succeeded. `r` is idle afterwards. Returns `true` immediately if `r` is
+    // already idle.
+    bool wait(IO_Request& r);
+};
+
+
+// =============================================================================
+// A double-buffered appending writer to a file. A write is issued
+// asynchronously and the writer returns once the previous one has completed,
+// so that the caller can fill its next buffer while the last one is being
+// written: the memory of a write is to be kept intact until the next write
+// returns, or the writer is synced.
+class Async_Writer
+{
+private:
+
+    std::string path_;  // Path to the file.
+    int fd; // Descriptor of the file.
+    off_t off;  // Byte-offset for the next write, i.e. the size of the file once synced.
+
+    IO_Request req[2];  // Requests of the last two writes.
+    uint8_t cur;    // Index of the request for the next write.
+
+
+public:
+
+    // Constructs a placeholder writer.
+    Async_Writer();
+
+    // Constructs a writer to the file at `path`, opened per `open`.
+    Async_Writer(const std::string& path, off_t resume_off = -1);
+
+    Async_Writer(Async_Writer&& rhs);
+
+    Async_Writer(const Async_Writer&) = delete;
+    Async_Writer& operator=(const Async_Writer&) = delete;
+    Async_Writer& operator=(Async_Writer&&) = delete;
+
+    ~Async_Writer();
+
+    // Returns the path to the file.
+    const std::string& path() const { return path_; }
+
+    // Opens the file at `path` for the writer, which should not have a file
+    // open. If `resume_off` is negative, the file is truncated; otherwise the
+    // writes resume at byte-offset `resume_off`, dropping any content past it.
+    void open(const std::string& path, off_t resume_off = -1);
+
+    // Returns whether the file is open.
+    bool is_open() const { return fd >= 0; }
+
+    // Returns the number of bytes issued to the file.
+    auto bytes() const { return static_cast<std::size_t>(off); }
+
+    // Issues writing `bytes` bytes from `buf` at the end of the file, and
+    // returns once the previous write has completed.
+    void write(const void* buf, std::size_t bytes);
+
+    // Waits for all the issued writes to complete.
+    void sync();
+
+    // Syncs the writer and moves its end to the beginning of the file. The
+    // file content is not truncated.
+    void rewind();
+
+    // Syncs and closes the file.
+    void close();
+};
+
+}
+
+
+
+#endif
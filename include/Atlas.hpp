@@ -30,13 +30,10 @@ private:
     typedef typename Super_Kmer_Chunk<Colored_>::label_unit_t label_unit_t;
 
 
-    static constexpr uint64_t atlas_count_ = 128;   // Number of subgraph atlases.
-    static constexpr uint64_t graph_per_atlas_ = 128;    // Number of subgraphs per atlas.
-    static constexpr uint64_t graph_count_ = atlas_count_ * graph_per_atlas_;   // Number of subgraphs.
-
-
     const std::string path_;    // Directory of the external-memory bucket.
 
+    const uint64_t graph_per_atlas_;    // Number of subgraphs in the atlas; it needs to be a power of 2.
+
     uint64_t size_; // Number of super k-mers in the atlas. It's not necessarily correct before closing it.
 
     typedef Super_Kmer_Chunk<Colored_> chunk_t;
@@ -51,8 +48,7 @@ private:
     Spin_Lock chunk_lock;   // Lock to the chunk.
     Spin_Lock flush_lock;   // Lock to the flush buffer.
 
-    // Byte-capacity of the chunk of each subgraph in the atlas: 64KB.
-    static constexpr std::size_t subgraph_chunk_cap_bytes = 64 * 1024;
+    const std::size_t subgraph_chunk_cap;   // Capacity of the super k-mer chunk of each subgraph in the atlas.
     std::vector<Super_Kmer_Bucket<Colored_>> subgraph;  // Subgraphs in the atlas.
 
     std::vector<uint32_t> src_hist; // Frequency histogram of super k-mer sources currently in the chunk.
@@ -67,26 +63,23 @@ private:
 
 public:
 
-    // Returns the number of subgraph atlases.
-    static constexpr auto atlas_count() { return atlas_count_; }
-
-    // Returns the number of subgraphs per atlas.
-    static constexpr auto graph_per_atlas() { return graph_per_atlas_; }
-
-    // Returns the number of subgraphs.
-    static constexpr auto graph_count() { return graph_count_; }
+    // Maximum factor by which the super chunk buffer may overgrow its soft
+    // capacity, while its flush-buffer is still being flushed.
+    static constexpr std::size_t max_chunk_growth = 2;
 
-    // Returns the atlas-ID of the `g`'th subgraph.
-    static auto atlas_ID(const uint64_t g) { return g >> log_2(graph_per_atlas()); }
+    // Returns the number of subgraphs in the atlas.
+    auto graph_per_atlas() const { return graph_per_atlas_; }
 
-    // Returns the graph-ID of the `g`'th subgraph within its atlas.
-    static auto graph_ID(const uint64_t g) { return g & (graph_per_atlas() - 1); }
+    // Returns the graph-ID within the atlas of the `g`'th subgraph.
+    auto graph_ID(const uint64_t g) const { return g & (graph_per_atlas_ - 1); }
 
     // Constructs a super k-mer atlas for `k`-mers and `l`-minimizers, at
-    // external-memory path-prefix `path`. The super chunk buffer of the atlas
-    // will have a soft capacity of `chunk_cap` and each worker-local buffer
-    // will have a hard capacity of `chunk_cap_per_w`.
-    Atlas(uint16_t k, uint16_t l, const std::string& path, std::size_t chunk_cap, std::size_t chunk_cap_per_w);
+    // external-memory path-prefix `path`, with `graph_per_atlas` subgraphs.
+    // The super chunk buffer of the atlas will have a soft capacity of
+    // `chunk_cap`, each worker-local buffer will have a hard capacity of
+    // `chunk_cap_per_w`, and the chunk of each subgraph will have a capacity
+    // of `subgraph_chunk_cap`.
+    Atlas(uint16_t k, uint16_t l, const std::string& path, uint64_t graph_per_atlas, std::size_t chunk_cap, std::size_t chunk_cap_per_w, std::size_t subgraph_chunk_cap);
 
     Atlas(Atlas&&);
 
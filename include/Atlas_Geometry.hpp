@@ -0,0 +1,72 @@
+#ifndef ATLAS_GEOMETRY_HPP
+#define ATLAS_GEOMETRY_HPP
+
+
+
+#include "utility.hpp"
+
+#include <cstdint>
+#include <cstddef>
+
+
+namespace cuttlefish
+{
+
+// =============================================================================
+// Geometry of the subgraph atlases of a de Bruijn graph: the number of atlases
+// and the number of subgraphs per atlas, both powers of 2. The `g`'th subgraph
+// is the `graph_ID(g)`'th subgraph of the `atlas_ID(g)`'th atlas.
+class Atlas_Geometry
+{
+private:
+
+    static constexpr uint64_t min_graph_count = 256;    // Minimum number of subgraphs chosen automatically.
+    static constexpr uint64_t max_graph_count_ = 1lu << 16; // Maximum number of subgraphs, as super k-mers carry 16-bit graph-IDs.
+    static constexpr uint64_t graph_per_worker = 32;    // Minimum number of subgraphs per worker, for load-balance.
+    static constexpr uint64_t input_bytes_per_graph = 1024 * 1024;  // Approximate input bytes per subgraph, chosen automatically.
+    static constexpr uint64_t min_atlas_count = 16; // Minimum number of atlases chosen automatically.
+    static constexpr uint64_t max_atlas_count = 128;    // Maximum number of atlases chosen automatically.
+
+    uint64_t atlas_count_;  // Number of subgraph atlases.
+    uint64_t graph_per_atlas_;  // Number of subgraphs per atlas.
+    uint64_t log_graph_per_atlas;   // Base-2 logarithm of the number of subgraphs per atlas.
+
+
+public:
+
+    // Constructs the geometry of `atlas_count` atlases with `graph_per_atlas`
+    // subgraphs each.
+    Atlas_Geometry(uint64_t atlas_count, uint64_t graph_per_atlas);
+
+    // Returns a geometry with `graph_count` subgraphs for `worker_count`
+    // workers. If `graph_count` is `0`, then the subgraph count is chosen
+    // per the input size `input_bytes` and the worker count.
+    static Atlas_Geometry choose(uint64_t graph_count, uint64_t input_bytes, std::size_t worker_count);
+
+    // Returns the maximum supported number of subgraphs.
+    static constexpr auto max_graph_count() { return max_graph_count_; }
+
+    // Returns the number of subgraph atlases.
+    auto atlas_count() const { return atlas_count_; }
+
+    // Returns the number of subgraphs per atlas.
+    auto graph_per_atlas() const { return graph_per_atlas_; }
+
+    // Returns the number of subgraphs.
+    auto graph_count() const { return atlas_count_ * graph_per_atlas_; }
+
+    // Returns the atlas-ID of the `g`'th subgraph.
+    auto atlas_ID(const uint64_t g) const { return g >> log_graph_per_atlas; }
+
+    // Returns the graph-ID of the `g`'th subgraph within its atlas.
+    auto graph_ID(const uint64_t g) const { return g & (graph_per_atlas_ - 1); }
+
+    // Returns the subgraph-ID for a minimizer with 64-bit hash value `h`.
+    auto graph_of(const uint64_t h) const { return h & (graph_count() - 1); }
+};
+
+}
+
+
+
+#endif
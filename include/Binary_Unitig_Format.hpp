@@ -0,0 +1,118 @@
+
+#ifndef BINARY_UNITIG_FORMAT_HPP
+#define BINARY_UNITIG_FORMAT_HPP
+
+
+
+#include "Color_Encoding.hpp"
+#include "DNA_Utility.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <cassert>
+
+
+namespace cuttlefish
+{
+
+// =============================================================================
+// Binary format of the compacted de Bruijn graph output, designed to be
+// memory-mapped. The file is a sequence of unitig-records, followed by an
+// index of the records and a footer, with every part 8-byte aligned:
+//
+// - record: the label length `len` and the color count `color_c` as 64-bit
+//   words; the label packed with 2 bits per base, base `i` at bits
+//   `[2(i mod 4), 2(i mod 4) + 2)` of byte `i / 4` (A: 0, C: 1, G: 2, T: 3),
+//   zero-padded to a multiple of 8 bytes; and `color_c` color-runs as 64-bit
+//   `Unitig_Color` encodings.
+// - index: the `count + 1` byte-offsets of the records, the last one being
+//   that of the index itself.
+// - footer: a `Footer` structure.
+//
+// All the words are in the native byte-order of the producer.
+class Binary_Unitig_Format
+{
+public:
+
+    static constexpr char magic[8] = {'C', 'F', '3', 'U', 'B', 'I', 'N', '\0'}; // Identifier of the format.
+    static constexpr uint32_t version = 1;  // Version of the format.
+
+    // Trailing meta-information of a binary unitig file.
+    struct Footer
+    {
+        char magic[8];  // Identifier of the format.
+        uint32_t version;   // Version of the format.
+        uint16_t k; // k-mer length of the de Bruijn graph.
+        uint8_t colored;    // Whether the records have colors.
+        uint8_t pad;
+        uint64_t count; // Number of records.
+        uint64_t idx_off;   // Byte-offset of the index.
+    };
+
+    static_assert(sizeof(Footer) == 32);
+    static_assert(sizeof(Unitig_Color) == sizeof(uint64_t));
+
+
+    // Returns the byte-size of the packed label of a `len`-length sequence,
+    // including its padding.
+    static constexpr std::size_t packed_size(const std::size_t len) { return ((len + 31) / 32) * 8; }
+
+    // Returns the byte-size of the record of a `len`-length sequence with
+    // `color_c` color-runs.
+    static constexpr std::size_t record_size(const std::size_t len, const std::size_t color_c) { return 2 * sizeof(uint64_t) + packed_size(len) + color_c * sizeof(uint64_t); }
+
+    // Appends a record to `buf` for the sequence `seq` concatenated with the
+    // sequence `seq_add`, with the `color_c` color-runs at `color`.
+    static void append_record(std::string& buf, const std::string_view& seq, const std::string_view& seq_add, const Unitig_Color* color, std::size_t color_c);
+
+    // Decodes the `len`-length packed label `packed` into `seq`.
+    static void unpack(const uint8_t* packed, std::size_t len, char* seq);
+
+    // Appends the index and the footer to the binary unitig file at `path`,
+    // having records of `k`-mers, with colors iff `colored` is `true`.
+    static void finalize(const std::string& path, uint16_t k, bool colored);
+};
+
+
+inline void Binary_Unitig_Format::append_record(std::string& buf, const std::string_view& seq, const std::string_view& seq_add, const Unitig_Color* const color, const std::size_t color_c)
+{
+    const uint64_t len = seq.size() + seq_add.size();
+    const uint64_t c_c = color_c;
+    const auto beg = buf.size();
+    buf.resize(beg + record_size(len, color_c));
+
+    auto p = buf.data() + beg;
+    std::memcpy(p, &len, sizeof(len)), p += sizeof(len);
+    std::memcpy(p, &c_c, sizeof(c_c)), p += sizeof(c_c);
+
+    auto const packed = reinterpret_cast<uint8_t*>(p);
+    std::memset(packed, 0, packed_size(len));
+    std::size_t i = 0;
+    for(const auto* s : {&seq, &seq_add})
+        for(const char b : *s)
+        {
+            assert(DNA_Utility::map_base(b) < DNA::N);
+            packed[i >> 2] |= DNA_Utility::map_base(b) << ((i & 3) << 1);
+            i++;
+        }
+
+    p += packed_size(len);
+    if(color_c > 0)
+        std::memcpy(p, color, color_c * sizeof(Unitig_Color));
+}
+
+
+inline void Binary_Unitig_Format::unpack(const uint8_t* const packed, const std::size_t len, char* const seq)
+{
+    for(std::size_t i = 0; i < len; ++i)
+        seq[i] = DNA_Utility::map_char(DNA::Base((packed[i >> 2] >> ((i & 3) << 1)) & 0b11));
+}
+
+}
+
+
+
+#endif
@@ -0,0 +1,87 @@
+
+#ifndef BINARY_UNITIG_READER_HPP
+#define BINARY_UNITIG_READER_HPP
+
+
+
+#include "Binary_Unitig_Format.hpp"
+#include "Color_Encoding.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <cassert>
+
+
+namespace cuttlefish
+{
+
+// =============================================================================
+// Read-only view of a binary unitig file, memory-mapped. The records can be
+// accessed randomly, and from multiple threads concurrently.
+class Binary_Unitig_Reader
+{
+private:
+
+    const std::string path_;    // Path to the file.
+    std::size_t sz; // Size of the file in bytes.
+    const char* base;   // Beginning of the mapped file.
+    Binary_Unitig_Format::Footer footer;    // Footer of the file.
+    const uint64_t* idx;    // Index of the records.
+
+
+    // Returns the beginning of the `i`'th record.
+    const char* record(const std::size_t i) const { assert(i < size()); return base + idx[i]; }
+
+    // Returns the `w`'th 64-bit word of the `i`'th record.
+    uint64_t word(const std::size_t i, const std::size_t w) const { uint64_t v; std::memcpy(&v, record(i) + w * sizeof(v), sizeof(v)); return v; }
+
+
+public:
+
+    // Maps the binary unitig file at `path`.
+    Binary_Unitig_Reader(const std::string& path);
+
+    Binary_Unitig_Reader(const Binary_Unitig_Reader&) = delete;
+    Binary_Unitig_Reader& operator=(const Binary_Unitig_Reader&) = delete;
+
+    ~Binary_Unitig_Reader();
+
+    // Returns the k-mer length of the de Bruijn graph.
+    uint16_t k() const { return footer.k; }
+
+    // Returns whether the records have colors.
+    bool colored() const { return footer.colored; }
+
+    // Returns the number of records, i.e. unitigs.
+    std::size_t size() const { return footer.count; }
+
+    // Returns the length of the label of the `i`'th unitig.
+    std::size_t length(const std::size_t i) const { return word(i, 0); }
+
+    // Returns the count of the color-runs of the `i`'th unitig.
+    std::size_t color_count(const std::size_t i) const { return word(i, 1); }
+
+    // Returns the 2-bit packed label of the `i`'th unitig.
+    const uint8_t* packed_label(const std::size_t i) const { return reinterpret_cast<const uint8_t*>(record(i) + 2 * sizeof(uint64_t)); }
+
+    // Decodes the label of the `i`'th unitig into `seq`.
+    void label(const std::size_t i, std::string& seq) const;
+
+    // Returns the color-runs of the `i`'th unitig.
+    const Unitig_Color* color(const std::size_t i) const { return reinterpret_cast<const Unitig_Color*>(packed_label(i) + Binary_Unitig_Format::packed_size(length(i))); }
+};
+
+
+inline void Binary_Unitig_Reader::label(const std::size_t i, std::string& seq) const
+{
+    seq.resize(length(i));
+    Binary_Unitig_Format::unpack(packed_label(i), seq.size(), seq.data());
+}
+
+}
+
+
+
+#endif
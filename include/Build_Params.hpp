@@ -31,6 +31,9 @@ private:
     const std::size_t vertex_part_count_;   // Number of vertex-partitions in the discontinuity graph; needs to be a power of 2.
     const std::size_t lmtig_bucket_count_;  // Number of buckets storing literal locally-maximal unitigs.
     const std::size_t gmtig_bucket_count_;  // Number of buckets storing literal globally-maximal unitigs.
+    const bool resume_; // Whether to checkpoint the construction phases, and resume an interrupted construction from its last completed phase.
+    const bool positional_output_;  // Whether to write the maximal unitigs in parallel to their pre-computed positions in the output file.
+    const bool gzip_output_;    // Whether to compress the output in the BGZF format.
     const std::string vertex_db_path_;  // Path to the KMC database containing the vertices (canonical k-mers).
     const std::string edge_db_path_;    // Path to the KMC database containing the edges (canonical (k + 1)-mers).
     const uint16_t thread_count_;    // Number of threads to work with.
@@ -39,7 +42,7 @@ private:
     const bool idx_;    // Whether to construct a k-mer index of the de Bruijn graph.
     const uint16_t min_len_;    // Length of the l-minimizers used in the k-mer index.
     const std::string output_file_path_;    // Path to the output file.
-    const std::optional<cuttlefish::Output_Format> output_format_;  // Output format (0: FASTA, 1: GFAv1, 2: GFAv2, 3: GFA-reduced).
+    const std::optional<cuttlefish::Output_Format> output_format_;  // Output format (0: FASTA, 1: GFAv1, 2: GFAv2, 3: GFA-reduced, 4: binary).
     const bool track_short_seqs_;   // Whether to track input sequences shorter than `k` bases.
     const bool poly_n_stretch_; // Whether to include tiles in GFA-reduced output that track the polyN stretches in the input.
     const std::string working_dir_path_;    // Path to the working directory (for temporary files).
@@ -71,6 +74,9 @@ public:
                     std::size_t vertex_part_count,
                     std::size_t lmtig_bucket_count,
                     std::size_t gmtig_bucket_count,
+                    bool resume,
+                    bool positional_output,
+                    bool gzip_output,
                     const std::string& vertex_db_path,
                     const std::string& edge_db_path,
                     uint16_t thread_count,
@@ -110,7 +116,8 @@ public:
     // Returns the frequency cutoff for the (k + 1)-mers (for short-reads set input).
     auto cutoff() const { return cutoff_.value_or(is_read_graph() ? cuttlefish::_default::CUTOFF_FREQ_READS : cuttlefish::_default::CUTOFF_FREQ_REFS); }
 
-    // Returns the number of subgraphs the original de Bruijn graph is broken into.
+    // Returns the number of subgraphs the original de Bruijn graph is broken into;
+    // `0` denotes that it is to be chosen at runtime.
     auto subgraph_count() const { return subgraph_count_; }
 
     // Returns the number of vertex-partitions in the discontinuity graph.
@@ -122,6 +129,17 @@ public:
     // Returns the number of buckets storing literal globally-maximal unitigs.
     auto gmtig_bucket_count() const { return gmtig_bucket_count_; }
 
+    // Returns whether to checkpoint the construction phases, and resume an
+    // interrupted construction from its last completed phase.
+    auto resume() const { return resume_; }
+
+    // Returns whether to write the maximal unitigs in parallel to their pre-
+    // computed positions in the output file.
+    auto positional_output() const { return positional_output_; }
+
+    // Returns whether to compress the output in the BGZF format.
+    auto gzip_output() const { return gzip_output_; }
+
     // Returns the path to the vertex database.
     const auto& vertex_db_path() const { return vertex_db_path_; }
 
@@ -134,6 +152,9 @@ public:
     // Returns the soft maximum memory limit (in GB).
     auto max_memory() const { return max_memory_.value_or(cuttlefish::_default::MAX_MEMORY); }
 
+    // Returns whether a maximum memory limit is explicitly specified.
+    bool max_memory_specified() const { return max_memory_.has_value(); }
+
     // Returns whether strict memory limit restriction is specified.
     auto strict_memory() const { return strict_memory_; }
 
@@ -147,7 +168,7 @@ public:
     auto output_prefix() const { return output_file_path_; }
 
     // Returns the path to the output file.
-    auto output_file_path() const { return output_file_path_ + output_file_ext(); }
+    auto output_file_path() const { return output_file_path_ + output_file_ext() + (gzip_output_ ? cuttlefish::file_ext::gzip_ext : ""); }
 
     // Returns the output format.
     auto output_format() const { return output_format_.value_or(cuttlefish::_default::OP_FORMAT); }
@@ -6,7 +6,10 @@
 
 #include "Spin_Lock.hpp"
 #include "Async_Logger_Wrapper.hpp"
+#include "Streaming_File_Sink.hpp"
 #include "FASTA_Record.hpp"
+#include "Output_Format.hpp"
+#include "Segment_Registry.hpp"
 
 #include <cstdint>
 #include <cstddef>
@@ -14,6 +17,7 @@
 #include <fstream>
 #include <iostream>
 #include <cstdlib>
+#include <cassert>
 
 
 // A buffer class to contain contiguous characters. It flushes to a sink of
@@ -30,6 +34,8 @@ private:
 
     std::string buf;    // The character buffer.
     T_sink_& sink;  // Reference to the sink to flush the buffer content to.
+    cuttlefish::Output_Format format_;  // Format to encode the FASTA records in.
+    cuttlefish::Segment_Registry* seg_reg;  // Registry of the FASTA records as segments, for the GFA formats.
 
 
     // Ensures that the buffer has enough space for additional `append_size`
@@ -39,11 +45,16 @@ private:
     // Flushes the buffer content to the sink, and clears the buffer.
     void flush();
 
+    // Appends the FASTA record `fasta_rec` to the buffer as a GFA segment.
+    void append_segment(const FASTA_Record& fasta_rec);
+
 
 public:
 
-    // Constructs a character buffer object that would flush its content to `sink`.
-    Character_Buffer(T_sink_& sink);
+    // Constructs a character buffer object that would flush its content to
+    // `sink`. The FASTA records added are encoded in the format `format`; the
+    // GFA formats require a segment registry, set with `set_segment_registry`.
+    Character_Buffer(T_sink_& sink, cuttlefish::Output_Format format = cuttlefish::Output_Format::fa);
 
     Character_Buffer(const Character_Buffer& rhs) = default;
 
@@ -70,6 +81,22 @@ public:
     // Returns the `len`-length suffix of the buffer.
     const char* suffix(std::size_t len) const;
 
+    // Returns the format the FASTA records are encoded in.
+    cuttlefish::Output_Format format() const { return format_; }
+
+    // Returns whether the FASTA records are encoded in the binary unitig
+    // format.
+    bool binary() const { return format_ == cuttlefish::Output_Format::bin; }
+
+    // Returns whether the FASTA records are encoded as GFA segments.
+    bool gfa() const { return format_ == cuttlefish::Output_Format::gfa1 || format_ == cuttlefish::Output_Format::gfa2; }
+
+    // Sets the registry of the GFA segments to `seg_reg`.
+    void set_segment_registry(cuttlefish::Segment_Registry* seg_reg) { this->seg_reg = seg_reg; }
+
+    // Returns the registry of the GFA segments; it is `nullptr` if not set.
+    cuttlefish::Segment_Registry* segment_registry() const { return seg_reg; }
+
     // Flushes the buffer if not empty.
     void close();
 
@@ -127,9 +154,24 @@ private:
 };
 
 
+template <>
+class Character_Buffer_Flusher<Streaming_File_Sink>
+{
+    template <typename> friend class Character_Buffer;
+
+private:
+
+    // Hands over the content of `buf` to the sink `sink`; `buf` is replaced
+    // with an empty buffer in the process.
+    static void write(std::string& buf, Streaming_File_Sink& sink);
+};
+
+
 template <typename T_sink_>
-inline Character_Buffer<T_sink_>::Character_Buffer(T_sink_& sink):
-    sink(sink)
+inline Character_Buffer<T_sink_>::Character_Buffer(T_sink_& sink, const cuttlefish::Output_Format format):
+      sink(sink)
+    , format_(format)
+    , seg_reg(nullptr)
 {
     buf.reserve(cap_);
 }
@@ -148,6 +190,19 @@ template <typename T_sink_>
 template <bool Colored_>
 inline void Character_Buffer<T_sink_>::operator+=(const FASTA_Record& fasta_rec)
 {
+    if(binary())
+    {
+        ensure_space(fasta_rec.binary_size());
+        fasta_rec.append_binary(buf);
+        return;
+    }
+
+    if(gfa())
+    {
+        append_segment(fasta_rec);
+        return;
+    }
+
     if constexpr(!Colored_)
         ensure_space(fasta_rec.header_size() + 1 + fasta_rec.seq_size() + 1);   // Two extra bytes for the line-breaks.
     else
@@ -166,6 +221,14 @@ template <typename T_sink_>
 template <uint16_t k>
 inline void Character_Buffer<T_sink_>::rotate_append_cycle(const FASTA_Record& fasta_rec, const std::size_t pivot)
 {
+    if(binary() || gfa())
+    {
+        std::string label;
+        fasta_rec.template append_rotated_cycle<k>(label, pivot);
+        *this += FASTA_Record(0, label);
+        return;
+    }
+
     ensure_space(fasta_rec.header_size() + 1 + fasta_rec.seq_size() + 1);   // Two extra bytes for two line-breaks.
 
     fasta_rec.append_header(buf);   // Append the header.
@@ -175,6 +238,27 @@ inline void Character_Buffer<T_sink_>::rotate_append_cycle(const FASTA_Record& f
 }
 
 
+template <typename T_sink_>
+inline void Character_Buffer<T_sink_>::append_segment(const FASTA_Record& fasta_rec)
+{
+    assert(seg_reg != nullptr);
+    const fmt::format_int id(seg_reg->add(fasta_rec.seq(), fasta_rec.seq_add()));
+    const fmt::format_int len(fasta_rec.seq_size());
+    const auto gfa2 = (format_ == cuttlefish::Output_Format::gfa2);
+
+    ensure_space(2 + id.size() + 1 + (gfa2 ? len.size() + 1 : 0) + fasta_rec.seq_size() + 1);
+
+    buf.append("S\t");
+    buf.append(id.data(), id.size());
+    buf.push_back('\t');
+    if(gfa2)
+        buf.append(len.data(), len.size()),
+        buf.push_back('\t');
+    fasta_rec.append_seq(buf);
+    buf.push_back('\n');
+}
+
+
 template <typename T_sink_>
 inline void Character_Buffer<T_sink_>::ensure_space(const std::size_t append_size)
 {
@@ -237,4 +321,10 @@ inline void Character_Buffer_Flusher<Async_Logger_Wrapper>::write(std::string& b
 }
 
 
+inline void Character_Buffer_Flusher<Streaming_File_Sink>::write(std::string& buf, Streaming_File_Sink& sink)
+{
+    sink.submit(buf);
+}
+
+
 #endif
@@ -17,6 +17,8 @@ class Color_Coordinate
 {
     typedef uint64_t pack_t;
 
+    friend class Color_Table;
+
 private:
 
     // Flag to denote whether the corresponding color is in the process of
@@ -53,6 +55,15 @@ public:
     // Returns 40-bit packing of the color-coordinate.
     auto as_u40() const { assert(bit_pack < (pack_t(1) << 40)); return bit_pack; }
 
+    // Returns the color-coordinate with the 40-bit packing `u40`.
+    static Color_Coordinate from_u40(const pack_t u40) { assert(u40 < (pack_t(1) << 40)); Color_Coordinate c; c.bit_pack = u40; return c; }
+
+    // Returns the worker-ID of the color-coordinate.
+    pack_t w_id() const { assert(!is_in_process()); return bit_pack & (w_limit - 1); }
+
+    // Returns the index of the color-coordinate in its worker-local bucket.
+    pack_t idx() const { assert(!is_in_process()); return bit_pack >> idx_pos; }
+
     // (De)serializes the coordinate from / to the `cereal` archive `archive`.
     template <typename T_archive_> void serialize(T_archive_& archive) { archive(bit_pack); }
 };
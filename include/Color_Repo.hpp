@@ -9,6 +9,7 @@
 #include "utility.hpp"
 #include "parlay/parallel.h"
 
+#include <cstdint>
 #include <cstddef>
 #include <string>
 #include <vector>
@@ -18,31 +19,87 @@
 namespace cuttlefish
 {
 
-// External-memory repository for color-sets.
+// External-memory repository for color-sets. Each worker appends the encoded
+// color-sets it extracts to its own bucket, and a color-set is addressed by the
+// coordinate `(w, idx)`: its worker `w` and its word-offset `idx` in the
+// bucket. Once closed, the repository is finalized into a single file designed
+// to be memory-mapped, with the color-sets identified by their ranks:
+//
+// - words: the buckets of the workers concatenated in order, as 64-bit words.
+// - bases: the `worker_c + 1` word-offsets of the buckets, the last one being
+//   the total word-count.
+// - offsets: Elias-Fano encoding of the `count + 1` word-offsets of the color-
+//   sets, the last one being the total word-count.
+// - footer: a `Footer` structure.
+//
+// All the words are in the native byte-order of the producer.
 class Color_Repo
 {
     typedef Ext_Mem_Bucket<uint64_t> bucket_t;
 
+public:
+
+    static constexpr char magic[8] = {'C', 'F', '3', 'C', 'O', 'L', 'O', 'R'};  // Identifier of the format.
+    static constexpr uint32_t version = 1;  // Version of the format.
+
+    // Trailing meta-information of a finalized color-repository.
+    struct Footer
+    {
+        char magic[8];  // Identifier of the format.
+        uint32_t version;   // Version of the format.
+        uint32_t worker_c;  // Number of worker-buckets.
+        uint64_t count; // Number of color-sets.
+        uint64_t word_c;    // Number of words of the color-sets.
+        uint64_t source_c;  // Number of sources, i.e. the universe of the color-sets.
+        uint64_t ef_off;    // Byte-offset of the Elias-Fano encoded offsets.
+    };
+
+    static_assert(sizeof(Footer) == 48);
+
+    // Preferred memory in bytes per worker for its buckets before they spill
+    // to external-memory.
+    static constexpr std::size_t pref_worker_mem_bytes = 5 * 1024 * 1024;
+
 private:
 
     std::vector<Padded<bucket_t>> B;    // Worker-specific color-buckets.
+    std::vector<Padded<bucket_t>> O;    // `O[w]` contains the word-offsets of the color-sets in `B[w]`.
 
 
 public:
 
-    // Initializes the color-repository at path-prefix `path`.
-    void init(const std::string& path);
+    // Initializes the color-repository at path-prefix `path`. The buckets of
+    // each worker are kept in memory up to `worker_mem_bytes` bytes in total
+    // before they spill to external-memory.
+    void init(const std::string& path, std::size_t worker_mem_bytes = pref_worker_mem_bytes);
 
     // Returns the appropriate color-bucket for the worker.
     bucket_t& bucket();
 
+    // Adds the encoded color-set of `word_c` words at `words` to the
+    // appropriate color-bucket for the worker.
+    void add(const uint64_t* words, std::size_t word_c);
+
     // Returns the size of the color-repository in bytes.
     std::size_t bytes() const;
 
     // Closes the color-repository.
     void close();
+
+    // Finalizes the closed color-repository into the file at `path`, with the
+    // color-sets being over `source_c` sources, and removes the buckets.
+    void finalize(const std::string& path, uint64_t source_c);
 };
 
+
+inline void Color_Repo::add(const uint64_t* const words, const std::size_t word_c)
+{
+    assert(B.size() == parlay::num_workers());
+    auto& b = B[parlay::worker_id()].unwrap();
+    O[parlay::worker_id()].unwrap().add(b.size());
+    b.add(words, word_c);
+}
+
 }
 
 
@@ -0,0 +1,77 @@
+
+#ifndef COLOR_REPO_READER_HPP
+#define COLOR_REPO_READER_HPP
+
+
+
+#include "Color_Repo.hpp"
+#include "Color_Encoding.hpp"
+#include "elias_fano/sequence.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <cassert>
+
+
+namespace cuttlefish
+{
+
+// =============================================================================
+// Read-only view of a finalized color-repository, memory-mapped. The encoded
+// color-sets can be accessed randomly, and from multiple threads concurrently.
+class Color_Repo_Reader
+{
+private:
+
+    const std::string path_;    // Path to the file.
+    std::size_t sz; // Size of the file in bytes.
+    const char* base;   // Beginning of the mapped file.
+    Color_Repo::Footer footer;  // Footer of the file.
+    const uint64_t* W;  // Words of the color-sets.
+    const uint64_t* B;  // Word-offsets of the worker-buckets.
+    elias_fano::sequence<true> off; // Word-offsets of the color-sets.
+
+
+public:
+
+    // Maps the finalized color-repository at `path`.
+    Color_Repo_Reader(const std::string& path);
+
+    Color_Repo_Reader(const Color_Repo_Reader&) = delete;
+    Color_Repo_Reader& operator=(const Color_Repo_Reader&) = delete;
+
+    ~Color_Repo_Reader();
+
+    // Returns the number of color-sets.
+    std::size_t size() const { return footer.count; }
+
+    // Returns the number of sources, i.e. the universe of the color-sets.
+    std::size_t source_count() const { return footer.source_c; }
+
+    // Returns the encoded `i`'th color-set.
+    const uint64_t* words(const std::size_t i) const { assert(i < size()); return W + off.access(i); }
+
+    // Returns the word-count of the encoded `i`'th color-set.
+    std::size_t word_count(const std::size_t i) const { assert(i < size()); return off.access(i + 1) - off.access(i); }
+
+    // Returns the ID of the color-set at the coordinate `c`.
+    std::size_t id(Color_Coordinate c) const;
+};
+
+
+inline std::size_t Color_Repo_Reader::id(const Color_Coordinate c) const
+{
+    assert(c.w_id() < footer.worker_c);
+    const auto o = B[c.w_id()] + c.idx();
+    const auto r = off.next_geq(o);
+    assert(r.second == o);
+
+    return r.first;
+}
+
+}
+
+
+
+#endif
@@ -4,18 +4,13 @@
 
 
 
-// #define USE_PARLAY_HASH
-
-
 #include "Color_Encoding.hpp"
-
-#ifndef USE_PARLAY_HASH
-#include "boost/unordered/concurrent_flat_map.hpp"
-#else
-#include "parlayhash/parlay_hash/unordered_map.h"
-#endif
+#include "utility.hpp"
 
 #include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <vector>
 #include <cassert>
 
 
@@ -25,8 +20,17 @@ namespace cuttlefish
 enum class Color_Status;    // Extraction-status of a color-set.
 
 
-// Hashtable for color-sets. Keys are color-set hashes and values are color-set
-// coordinates.
+// Lock-free hashtable for color-sets. Keys are color-set hashes and values are
+// color-set coordinates.
+//
+// It is a chain of open-addressing (linear-probing) levels, where only the
+// newest level admits new keys. Keys are claimed with a CAS on their slots, and
+// their values are published afterwards. Once the newest level fills up to the
+// load-factor, a new level is added, sized per the count of the distinct
+// color-hashes observed so far; the keys are not migrated. A probe for a key
+// that reaches an empty slot in an older level freezes it, so that the key may
+// never be claimed in that level afterwards and each key has at most one slot
+// over all the levels.
 class Color_Table
 {
 
@@ -35,22 +39,87 @@ class Color_Table
 
 private:
 
-    static constexpr uint64_t map_sz_init = 64 * 1024 * 1024;   // Map has preallocated memory for 64M color-hashes.
+    // A slot of the table.
+    struct Slot
+    {
+        hash_t key; // Color-hash, or one of the markers `empty` and `frozen`.
+        uint64_t val;   // Packed color-coordinate incremented by one; 0 if not published yet.
+    };
 
-#ifndef USE_PARLAY_HASH
-    boost::unordered::concurrent_flat_map<hash_t, coord_t> M;
-#else
-    parlay::parlay_unordered_map<hash_t, coord_t> M;
-#endif
+    // A level of the table.
+    struct Level
+    {
+        Slot* T;    // The slots.
+        uint64_t cap;   // Number of slots; a power of 2.
+        uint32_t shift; // Right-shift of a multiplicative color-hash to get its home slot.
+        uint64_t base;  // Count of the color-hashes in the table when the level was added.
+    };
+
+    static constexpr hash_t empty = 0;  // Key-marker for an empty slot.
+    static constexpr hash_t frozen = 1; // Key-marker for an empty slot that may not be claimed anymore.
+
+    static constexpr double lf = 0.5;   // Load-factor of each level.
+    static constexpr uint64_t map_sz_default = 4 * 1024 * 1024; // Initial level has memory for 4M color-hashes by default.
+    static constexpr uint64_t min_level_cap = 1lu << 20;    // Minimum number of slots in a level.
+    static constexpr uint32_t max_level_c = 48; // Maximum number of levels.
+    static constexpr uint64_t sample_gap = 256; // Each worker checks the fill of the newest level at every this many claims.
+
+    Level L[max_level_c];   // The levels.
+    std::atomic_uint32_t level_c;   // Number of levels.
+    std::atomic_flag growing = ATOMIC_FLAG_INIT;    // Whether a level is being added.
+    std::vector<Padded<uint64_t>> claim_c;  // `claim_c[w]` is the count of color-hashes claimed by worker `w`.
+
+
+    // Returns the key for the color-hash `h`. Hashes colliding with the key-
+    // markers are aliased to others; for 64-bit hashes this is as likely as any
+    // other hash-collision.
+    static hash_t key_of(const hash_t h) { return h < 2 ? h + 2 : h; }
+
+    // Returns the home slot of the key `key` in the level `lev`.
+    static uint64_t home(const hash_t key, const Level& lev) { return (key * 0x9E3779B97F4A7C15) >> lev.shift; }
+
+    // Returns the coordinate published at the slot `s`, waiting for it to be
+    // published if required.
+    static Color_Coordinate read(const Slot& s);
+
+    // Adds a new level with `cap` slots, where `base` color-hashes are in the
+    // table. Not thread-safe.
+    void add_level(uint64_t cap, uint64_t base);
+
+    // Adds a new level if the table currently has `n` levels and the newest is
+    // filled up to the load-factor, or anyway if `force` is `true`. Nothing is
+    // done if some other worker is adding a level.
+    void grow(uint32_t n, bool force);
+
+    // Waits until the table has more than `n` levels, adding one if required.
+    void await_level(uint32_t n);
+
+    // Counts a color-hash claimed by worker `w` in the level with index `l`.
+    void count_claim(uint64_t w, uint32_t l);
+
+    // Returns the slot of the key `key`, which must be in the table.
+    const Slot& find(hash_t key) const;
 
 public:
 
-    // Constructs an empty color-table.
-    Color_Table();
+    // Constructs an empty color-table with preallocated memory for `cap`
+    // color-hashes.
+    Color_Table(uint64_t cap = map_sz_default);
+
+    Color_Table(const Color_Table&) = delete;
+    Color_Table& operator=(const Color_Table&) = delete;
+
+    ~Color_Table();
 
-    // Returns the size of the table. NB: work is proportional to the size of
-    // the table if `parlayhash` is used.
-    auto size() { return M.size(); }
+    // Returns the default number of color-hashes with preallocated memory.
+    static constexpr auto default_capacity() { return map_sz_default; }
+
+    // Returns an estimate of the memory in bytes used per color-hash in the
+    // table, including the load-factor slack.
+    static constexpr std::size_t bytes_per_entry() { return static_cast<std::size_t>(sizeof(Slot) / lf); }
+
+    // Returns the size of the table.
+    uint64_t size() const;
 
     // Marks that the color with hash `h` is in the process of extraction by
     // the `w`'th worker, if a corresponding entry for `h` does not already
@@ -76,85 +145,120 @@ enum class Color_Status
 };
 
 
-inline Color_Status Color_Table::mark_in_process(const hash_t h, const uint64_t w, Color_Coordinate& c)
+inline Color_Coordinate Color_Table::read(const Slot& s)
 {
-    typedef Color_Status status_t;
-
-#ifndef USE_PARLAY_HASH
-
-    const auto r =  M.emplace_or_cvisit(h, Color_Coordinate(w), [&](const auto& p)
-                    {
-                        c = p.second;
-                    });
+    uint64_t v;
+    while((v = __atomic_load_n(&s.val, __ATOMIC_ACQUIRE)) == 0)
+        ;
 
-    return r ? status_t::undiscovered : (c.is_in_process() ? status_t::in_process : status_t::discovered);
+    Color_Coordinate c;
+    c.bit_pack = v - 1;
+    return c;
+}
 
-#else
 
-    const auto r = M.Insert(h, Color_Coordinate(w));
-    c = (r.value_or(c));
+inline void Color_Table::count_claim(const uint64_t w, const uint32_t l)
+{
+    assert(w < claim_c.size());
 
-    return !r ? status_t::undiscovered : (c.is_in_process() ? status_t::in_process : status_t::discovered);
+    // Only the worker `w` updates its counter; others may only read it.
+    auto& c = claim_c[w].unwrap();
+    const auto c_new = c + 1;
+    __atomic_store_n(&c, c_new, __ATOMIC_RELAXED);
 
-#endif
+    if(c_new % sample_gap == 0)
+        grow(l + 1, false);
 }
 
 
-inline bool Color_Table::update_if_in_process(const hash_t h, const Color_Coordinate c)
+inline Color_Status Color_Table::mark_in_process(const hash_t h, const uint64_t w, Color_Coordinate& c)
 {
-    bool was_in_process = false;
+    typedef Color_Status status_t;
 
-#ifndef USE_PARLAY_HASH
+    const auto key = key_of(h);
+    for(uint32_t l = 0; ; ++l)
+    {
+        const auto& lev = L[l];
+        const auto mask = lev.cap - 1;
+        for(uint64_t p = 0, i = home(key, lev); p < lev.cap; ++p, i = (i + 1) & mask)
+        {
+            auto& s = lev.T[i];
+            auto k = __atomic_load_n(&s.key, __ATOMIC_ACQUIRE);
+            if(k == empty)
+            {
+                // Only the newest level admits the key; the slot is frozen otherwise.
+                const bool newest = (l + 1 == level_c.load(std::memory_order_acquire));
+                if(__atomic_compare_exchange_n(&s.key, &k, newest ? key : frozen, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+                {
+                    if(!newest)
+                        break;
+
+                    __atomic_store_n(&s.val, Color_Coordinate(w).bit_pack + 1, __ATOMIC_RELEASE);
+                    count_claim(w, l);
+                    return status_t::undiscovered;
+                }
+
+                // `k` is the key that won the slot.
+            }
+
+            if(k == key)
+            {
+                c = read(s);
+                return c.is_in_process() ? status_t::in_process : status_t::discovered;
+            }
+
+            if(k == frozen)
+                break;
+        }
+
+        // The key is not in this level and may not be claimed in it anymore.
+        await_level(l + 1);
+    }
+}
 
-    const auto r =  M.visit(h, [&](auto& p)
-                    {
-                        auto& color = p.second;
-                        was_in_process = color.is_in_process();
-                        color = (was_in_process ? c : color);
-                    });
-#else
 
-    const auto r =  M.Upsert(h, [&](const auto& cur_c)
-                    {
-                        assert(cur_c);
-                        was_in_process = cur_c->is_in_process();
-                        return was_in_process ? c : *cur_c;
-                    });
+inline const Color_Table::Slot& Color_Table::find(const hash_t key) const
+{
+    const auto n = level_c.load(std::memory_order_acquire);
+    for(uint32_t l = 0; l < n; ++l)
+    {
+        const auto& lev = L[l];
+        const auto mask = lev.cap - 1;
+        for(uint64_t p = 0, i = home(key, lev); p < lev.cap; ++p, i = (i + 1) & mask)
+        {
+            const auto k = __atomic_load_n(&lev.T[i].key, __ATOMIC_ACQUIRE);
+            if(k == key)
+                return lev.T[i];
+
+            if(k == empty || k == frozen)
+                break;
+        }
+    }
+
+    assert(false);
+    return L[0].T[0];
+}
 
-#endif
 
-    assert(r); (void)r;
+inline bool Color_Table::update_if_in_process(const hash_t h, const Color_Coordinate c)
+{
+    auto& s = const_cast<Slot&>(find(key_of(h)));
+    auto v = read(s).bit_pack + 1;
+    while(((v - 1) & Color_Coordinate::in_process))
+        if(__atomic_compare_exchange_n(&s.val, &v, c.bit_pack + 1, false, __ATOMIC_RELEASE, __ATOMIC_ACQUIRE))
+            return true;
 
-    return was_in_process;
+    return false;
 }
 
 
 inline Color_Coordinate Color_Table::get(const hash_t h)
 {
-#ifndef USE_PARLAY_HASH
-
-    assert(M.contains(h));
-
-    Color_Coordinate c;
-    const auto r =  M.cvisit(h, [&](const auto& p)
-                    {
-                        c = p.second;
-                    });
-    assert(r); (void)r;
-    return c;
-
-#else
-
-    const auto c = M.Find(h);
-    assert(c);
-
-    return *c;
-
-#endif
+    return read(find(key_of(h)));
 }
 
 }
 
 
 
-#endif
\ No newline at end of file
+#endif
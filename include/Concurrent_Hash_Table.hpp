@@ -4,11 +4,11 @@
 
 
 
-#include "Spin_Lock.hpp"
 #include "utility.hpp"
 #include "xxHash/xxhash.h"
 #include "parlay/parallel.h"
 
+#include <cstdint>
 #include <cstddef>
 #include <vector>
 #include <cstring>
@@ -16,55 +16,103 @@
 #include <cstdlib>
 #include <algorithm>
 #include <cmath>
+#include <limits>
+#include <type_traits>
+#include <atomic>
+#include <cassert>
 
 namespace cuttlefish
 {
 
 // =============================================================================
+// A concurrent linear-probing hash table. Each slot is stamped with the epoch
+// of its entry, and the table is cleared in constant time by moving to a new
+// epoch. The stamp also holds the lock-bit of the slot, so that a probe touches
+// only the slot itself.
+//
+// The table grows on demand: a key is probed for in a bounded window of slots,
+// and if the window is full, in the next of a sequence of overflow levels of
+// doubling capacities, allocated as they are first required. Entries are never
+// moved while in the table, so value-pointers stay valid till the next clear,
+// which releases the overflow levels.
 template <typename T_key_, typename T_val_, typename T_hasher_>
 class Concurrent_Hash_Table
 {
     class Iterator;
     friend class Iterator;
 
-    static constexpr bool atomic_read = (sizeof(T_key_) <= 8);  // Whether reads are atomic. TODO: do it based on arch.
-
 private:
 
     struct Key_Val_Pair
     {
+        uint32_t stamp; // Epoch of the entry at the higher 31 bits, and the lock-bit at the lowest bit.
         T_key_ key;
         T_val_ val;
     };
 
     static constexpr double lf_default = 0.75;   // Default maximum load-factor supported.
-
-    T_key_ empty_key_;  // The empty key; currently it's set to all 1-bits.
+    static constexpr uint32_t lock_bit = 1; // Lock-bit of the slot-stamps.
+    static constexpr uint32_t max_epoch = std::numeric_limits<uint32_t>::max() >> 1;  // Maximum epoch of the table.
+    static constexpr std::size_t probe_window = 32;     // Maximum number of slots probed for a key in a level.
+    static constexpr std::size_t max_overflow_c = 40;   // Maximum number of overflow levels.
 
     const T_hasher_ hash;   // The hasher object.
 
-    const std::size_t capacity_;    // True capacity of the table; adjusted to be a power of 2.
-    const std::size_t idx_wrapper_mask; // Bitmask to wrap indexing into the table.
+    const double lf;    // Maximum load-factor supported.
+    std::size_t capacity_;  // True capacity of the table; adjusted to be a power of 2.
+    std::size_t active_cap; // Capacity of the prefix of the table in use; a power of 2.
 
-    Key_Val_Pair* const T;  // The flat table of key-value collection.
+    Key_Val_Pair* T;    // The flat table of key-value collection.
     // std::size_t size_;  // Number of elements in the table. Probably not usable cheaply with concurrency.
 
-    mutable std::vector<Spin_Lock> lock;    // Locks for atomic storing of key-value entries.
-    // TODO: experiment moving the spin-lock to the key-value structure for seemingly better cache-behavior.
+    std::atomic<Key_Val_Pair*> overflow[max_overflow_c];  // Overflow levels; the `i`'th one has `active_cap << i` slots.
+
+    uint32_t epoch; // Current epoch of the table; a slot is occupied iff it is stamped with this.
+
+    // Returns the slots of level `l` of the table, with its capacity in `cap`;
+    // level 0 is the active prefix of the table. Returns `nullptr` if the
+    // level is not allocated.
+    Key_Val_Pair* level(std::size_t l, std::size_t& cap) const;
+
+    // Returns the slots of the overflow level `l`, allocating it if required.
+    Key_Val_Pair* add_overflow_level(std::size_t l);
+
+    // Releases the overflow levels.
+    void free_overflow();
+
+    // Returns the number of slots in the active prefix and the overflow levels.
+    std::size_t slot_count() const;
+
+    // Returns the slot at index `idx` of the concatenation of the active prefix
+    // and the overflow levels.
+    Key_Val_Pair& slot(std::size_t idx) const;
+
+    // Returns the stamp of the slot `s` once it is not locked.
+    static uint32_t stable_stamp(const Key_Val_Pair& s);
+
+    // Returns whether a slot with stamp `stamp` is occupied.
+    bool occupied(uint32_t stamp) const { return (stamp >> 1) == epoch; }
+
+    // Tries to lock the slot `s` having the unlocked stamp `stamp`. Returns
+    // `true` iff it succeeds.
+    static bool try_lock(Key_Val_Pair& s, uint32_t stamp);
 
-    // Maps the hash value `h` to an index into the table.
-    std::size_t hash_to_idx(std::size_t h) const { return h & idx_wrapper_mask; }
+    // Locks the slot `s`.
+    static void lock(Key_Val_Pair& s);
 
-    // Returns the next (wrapped) index for `i`.
-    std::size_t next_index(std::size_t i) const { return hash_to_idx(i + 1); }
+    // Unlocks the slot `s`, stamping it occupied.
+    void unlock(Key_Val_Pair& s) const;
 
-    // Atomically compare-and-swaps the memory location `ptr`'s value to
-    // `new_key` from `old_key`. Returns `true` iff this succeeds.
-    static bool CAS(T_key_* ptr, T_key_ old_key, T_key_ new_key);
+    // Inserts the key `key` with value `val` into the table if it is absent,
+    // and returns `true` iff the key is inserted. If `key` exists, its value
+    // is passed to `on_existing`—with the slot locked, unless it is `nullptr`.
+    template <typename T_f_> bool insert_with(T_key_ key, T_val_ val, T_f_ on_existing);
 
-    // Returns the memory-equivalent value of `val` in type `T_to`.
-    template <typename T_to_, typename T_from_>
-    static T_to_ pun_type(const T_from_ val) { return *reinterpret_cast<const T_to_*>(&val); }
+    // Moves the table to a new epoch.
+    void advance_epoch();
+
+    // Allocates the table and resets all its slot-stamps.
+    void allocate_table();
 
     // Returns a 64-bit signature of the key-set of the hash table if
     // `hash_key_set_` is true. Otherwise returns a 64-bit signature of the
@@ -79,33 +127,46 @@ public:
     // hash the keys in the table.
     Concurrent_Hash_Table(std::size_t max_n, double load_factor = lf_default, T_hasher_ hasher = T_hasher_());
 
-    ~Concurrent_Hash_Table() { deallocate(T); }
+    ~Concurrent_Hash_Table() { free_overflow(); deallocate(T); }
+
+    Concurrent_Hash_Table(const Concurrent_Hash_Table&) = delete;
+    Concurrent_Hash_Table& operator=(const Concurrent_Hash_Table&) = delete;
 
-    // T_key_ empty_key() const { return empty_key_; }
+    // Returns the size in bytes of a table supporting upto `max_n` elements
+    // with a maximum load-factor of `load_factor`, without overflow levels.
+    static std::size_t bytes(std::size_t max_n, double load_factor = lf_default);
 
-    // Returns the capacity of the hash table.
+    // Returns the capacity of the hash table, excluding its overflow levels.
     std::size_t capacity() const { return capacity_; }
 
-    // Clears the hash table.
-    // TODO: consider whether a generic empty-key might be required in our particular use-cases ever or not.
+    // Returns the resident set size of the hash table.
+    std::size_t RSS() const { return (capacity_ + slot_count() - active_cap) * sizeof(Key_Val_Pair); }
+
+    // Returns the capacity of the prefix of the table in use.
+    std::size_t active_capacity() const { return active_cap; }
+
+    // Clears the hash table, and releases its overflow levels. It takes
+    // constant time otherwise, save for once every `2^31 - 1` clears, when the
+    // slot-stamps are reset.
     void clear();
 
-    // Inserts the key `key` with value `val` into the table. Returns `false` if
-    // the key already exists in the table. Otherwise returns `true` iff the
-    // insertion succeeds, i.e. free space was found for the insertion.
+    // Clears the hash table, and restricts it to the smallest prefix that
+    // supports `max_n` elements at the maximum load-factor; more elements go
+    // to the overflow levels. The table is grown if it is smaller than that.
+    void clear(std::size_t max_n);
+
+    // Inserts the key `key` with value `val` into the table. Returns `false`
+    // iff the key already exists in the table.
     bool insert(T_key_ key, T_val_ val);
 
-    // Inserts the key `key` with value `val` into the table. Returns `false` if
-    // the key already exists in the table; and in that case, the address of the
-    // existing value for the key is stored in `val_add`. Otherwise returns
-    // `true` iff the insertion succeeds, i.e. free space was found for the
-    // insertion.
+    // Inserts the key `key` with value `val` into the table. Returns `false`
+    // iff the key already exists in the table; and in that case, the address
+    // of the existing value for the key is stored in `val_add`.
     bool insert(T_key_ key, T_val_ val, T_val_*& val_add);
 
-    // Inserts the key `key` with value `val` into the table. Returns `false` if
-    // the key already exists in the table; and in that case, the existing value
-    // associated to `key` is overwritten with `val`. Otherwise returns `true`
-    // iff the insertion succeeds, i.e. free space was found for the insertion.
+    // Inserts the key `key` with value `val` into the table. Returns `false`
+    // iff the key already exists in the table; and in that case, the existing
+    // value associated to `key` is overwritten with `val`.
     bool insert_or_assign(T_key_ key, T_val_ val);
 
     // Searches for `key` in the table and returns the address of the value
@@ -165,24 +226,97 @@ public:
 
 template <typename T_key_, typename T_val_, typename T_hasher_>
 inline Concurrent_Hash_Table<T_key_, T_val_, T_hasher_>::Concurrent_Hash_Table(const std::size_t max_n, const double load_factor, const T_hasher_ hasher):
-      empty_key_()
-    , hash(hasher)
-    , capacity_(ceil_pow_2(static_cast<std::size_t>(std::ceil(max_n / load_factor))))
-    , idx_wrapper_mask(capacity_ - 1)
-    , T(allocate<Key_Val_Pair>(capacity_))
-    , lock(capacity_)
+      hash(hasher)
+    , lf(load_factor)
+    , capacity_(ceil_pow_2(std::max(static_cast<std::size_t>(std::ceil(max_n / load_factor)), 1lu)))
+    , active_cap(capacity_)
+    , T(nullptr)
 {
-    std::memset(reinterpret_cast<char*>(&empty_key_), -1, sizeof(empty_key_));
+    std::for_each(std::begin(overflow), std::end(overflow), [](auto& o){ o.store(nullptr, std::memory_order_relaxed); });
+    allocate_table();
+}
 
-    clear();
+
+template <typename T_key_, typename T_val_, typename T_hasher_>
+inline std::size_t Concurrent_Hash_Table<T_key_, T_val_, T_hasher_>::bytes(const std::size_t max_n, const double load_factor)
+{
+    return ceil_pow_2(std::max(static_cast<std::size_t>(std::ceil(max_n / load_factor)), 1lu)) * sizeof(Key_Val_Pair);
 }
 
+
 template <typename T_key_, typename T_val_, typename T_hasher_>
-inline void Concurrent_Hash_Table<T_key_, T_val_, T_hasher_>::clear()
+inline typename Concurrent_Hash_Table<T_key_, T_val_, T_hasher_>::Key_Val_Pair* Concurrent_Hash_Table<T_key_, T_val_, T_hasher_>::level(const std::size_t l, std::size_t& cap) const
+{
+    if(l == 0)
+        return cap = active_cap, T;
+
+    assert(l <= max_overflow_c);
+    cap = active_cap << (l - 1);
+    return overflow[l - 1].load(std::memory_order_acquire);
+}
+
+
+template <typename T_key_, typename T_val_, typename T_hasher_>
+inline typename Concurrent_Hash_Table<T_key_, T_val_, T_hasher_>::Key_Val_Pair* Concurrent_Hash_Table<T_key_, T_val_, T_hasher_>::add_overflow_level(const std::size_t l)
+{
+    std::size_t cap;
+    auto L = level(l, cap);
+    if(L != nullptr)
+        return L;
+
+    // The zeroed stamps are of epoch 0, and thus unoccupied.
+    auto const L_new = allocate_zeroed<Key_Val_Pair>(cap);
+    if(overflow[l - 1].compare_exchange_strong(L, L_new, std::memory_order_acq_rel))
+        return L_new;
+
+    deallocate(L_new);  // Some other worker has added the level.
+    return L;
+}
+
+
+template <typename T_key_, typename T_val_, typename T_hasher_>
+inline void Concurrent_Hash_Table<T_key_, T_val_, T_hasher_>::free_overflow()
+{
+    for(auto& o : overflow)
+        deallocate(o.load(std::memory_order_relaxed)),
+        o.store(nullptr, std::memory_order_relaxed);
+}
+
+
+template <typename T_key_, typename T_val_, typename T_hasher_>
+inline std::size_t Concurrent_Hash_Table<T_key_, T_val_, T_hasher_>::slot_count() const
+{
+    // The overflow levels are allocated in order, and double in capacity.
+    std::size_t c = active_cap;
+    for(std::size_t l = 0; l < max_overflow_c && overflow[l].load(std::memory_order_acquire) != nullptr; ++l)
+        c <<= 1;
+
+    return c;
+}
+
+
+template <typename T_key_, typename T_val_, typename T_hasher_>
+inline typename Concurrent_Hash_Table<T_key_, T_val_, T_hasher_>::Key_Val_Pair& Concurrent_Hash_Table<T_key_, T_val_, T_hasher_>::slot(std::size_t idx) const
 {
-    // TODO: try version-stamping.
+    std::size_t l = 0, cap;
+    auto L = level(l, cap);
+    while(idx >= cap)
+        idx -= cap,
+        L = level(++l, cap);
+
+    assert(L != nullptr);
+    return L[idx];
+}
+
+
+template <typename T_key_, typename T_val_, typename T_hasher_>
+inline void Concurrent_Hash_Table<T_key_, T_val_, T_hasher_>::allocate_table()
+{
+    deallocate(T);
+    T = allocate<Key_Val_Pair>(capacity_);
+
     // Straightforward way.
-    // parlay::parallel_for(0, capacity_, [&](std::size_t idx){ T[idx].key = empty_key_; });
+    // parlay::parallel_for(0, capacity_, [&](std::size_t idx){ T[idx].stamp = 0; });
 
     const auto byte_count = capacity_ * sizeof(Key_Val_Pair);
     const auto cache_line_count = byte_count / L1_CACHE_LINE_SIZE;
@@ -194,243 +328,187 @@ inline void Concurrent_Hash_Table<T_key_, T_val_, T_hasher_>::clear()
         const auto bytes_to_clear = (w_id < parlay::num_workers() - 1 ?
                                         bytes_per_w : byte_count - bytes_per_w * w_id);
 
-        std::memset(reinterpret_cast<char*>(T) + bytes_per_w * w_id, -1, bytes_to_clear);
+        std::memset(reinterpret_cast<char*>(T) + bytes_per_w * w_id, 0, bytes_to_clear);
     };
 
     parlay::parallel_for(0, parlay::num_workers(), clear_segment, 1);
+
+    epoch = 1;  // The zeroed stamps are of epoch 0.
 }
 
 
 template <typename T_key_, typename T_val_, typename T_hasher_>
-inline bool Concurrent_Hash_Table<T_key_, T_val_, T_hasher_>::insert(const T_key_ key, const T_val_ val)
+inline void Concurrent_Hash_Table<T_key_, T_val_, T_hasher_>::advance_epoch()
 {
-#ifndef NDEBUG
-    std::size_t tried_slots = 0;
-#endif
-
-    bool success = false;
-
-    for(std::size_t i = hash_to_idx(hash(key)); ; i = next_index(i))
-    {
-        assert(++tried_slots <= capacity_);
-
-    if constexpr(atomic_read)
-    {
-        if(T[i].key == empty_key_)  // TODO: check atomic-read / partial-read guarantees.
-        {
-            lock[i].lock();
-            if(T[i].key == empty_key_)
-                T[i].key = key, T[i].val = val,
-                success = true;
-            lock[i].unlock();
-
-            if(success)
-                return true;
-        }
-
-        if(T[i].key == key) // TODO: check atomic-read / partial-read guarantees.
-            return false;
-    }
+    if(epoch == max_epoch)  // Stale stamps would alias with the epochs to come.
+        allocate_table();
     else
-    {
-        lock[i].lock();
-
-        if(T[i].key == empty_key_)
-        {
-            T[i].key = key, T[i].val = val;
+        epoch++;
+}
 
-            lock[i].unlock();
-            return true;
-        }
 
-        if(T[i].key == key)
-        {
-            lock[i].unlock();
-            return false;
-        }
-
-        lock[i].unlock();
-    }
-    }
+template <typename T_key_, typename T_val_, typename T_hasher_>
+inline void Concurrent_Hash_Table<T_key_, T_val_, T_hasher_>::clear()
+{
+    free_overflow();
+    advance_epoch();
 
-    return false;
+    active_cap = capacity_;
 }
 
 
 template <typename T_key_, typename T_val_, typename T_hasher_>
-inline bool Concurrent_Hash_Table<T_key_, T_val_, T_hasher_>::insert(const T_key_ key, const T_val_ val, T_val_*& val_add)
+inline void Concurrent_Hash_Table<T_key_, T_val_, T_hasher_>::clear(const std::size_t max_n)
 {
-#ifndef NDEBUG
-    std::size_t tried_slots = 0;
-#endif
-
-    bool success = false;
+    free_overflow();
 
-    for(std::size_t i = hash_to_idx(hash(key)); ; i = next_index(i))
+    const auto cap = ceil_pow_2(std::max(static_cast<std::size_t>(std::ceil(max_n / lf)), 1lu));
+    if(cap > capacity_)
     {
-        assert(++tried_slots <= capacity_);
-
-    if constexpr(atomic_read)
-    {
-        if(T[i].key == empty_key_)  // TODO: check atomic-read / partial-read guarantees.
-        {
-            lock[i].lock();
-            if(T[i].key == empty_key_)
-                T[i].key = key, T[i].val = val,
-                success = true;
-            lock[i].unlock();
-
-            if(success)
-                return true;
-        }
-
-        if(T[i].key == key) // TODO: check atomic-read / partial-read guarantees.
-        {
-            lock[i].lock(); // Some other worker can be manipulating the value.
-            val_add = &T[i].val;
-            lock[i].unlock();
-
-            return false;
-        }
+        capacity_ = cap;
+        allocate_table();
     }
     else
-    {
-        lock[i].lock();
+        advance_epoch();
 
-        if(T[i].key == empty_key_)
-        {
-            T[i].key = key, T[i].val = val;
+    active_cap = cap;
+}
 
-            lock[i].unlock();
-            return true;
-        }
 
-        if(T[i].key == key)
-        {
-            val_add = &T[i].val;
+template <typename T_key_, typename T_val_, typename T_hasher_>
+inline uint32_t Concurrent_Hash_Table<T_key_, T_val_, T_hasher_>::stable_stamp(const Key_Val_Pair& s)
+{
+    uint32_t stamp;
+    while((stamp = __atomic_load_n(&s.stamp, __ATOMIC_ACQUIRE)) & lock_bit)
+        ;
 
-            lock[i].unlock();
-            return false;
-        }
+    return stamp;
+}
 
-        lock[i].unlock();
-    }
-    }
 
-    return false;
+template <typename T_key_, typename T_val_, typename T_hasher_>
+inline bool Concurrent_Hash_Table<T_key_, T_val_, T_hasher_>::try_lock(Key_Val_Pair& s, uint32_t stamp)
+{
+    assert(!(stamp & lock_bit));
+    return __atomic_compare_exchange_n(&s.stamp, &stamp, stamp | lock_bit, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
 }
 
 
 template <typename T_key_, typename T_val_, typename T_hasher_>
-inline bool Concurrent_Hash_Table<T_key_, T_val_, T_hasher_>::insert_or_assign(const T_key_ key, const T_val_ val)
+inline void Concurrent_Hash_Table<T_key_, T_val_, T_hasher_>::lock(Key_Val_Pair& s)
 {
-#ifndef NDEBUG
-    std::size_t tried_slots = 0;
-#endif
+    while(!try_lock(s, stable_stamp(s)))
+        ;
+}
 
-    bool success = false;
 
-    for(std::size_t i = hash_to_idx(hash(key)); ; i = next_index(i))
-    {
-        assert(++tried_slots <= capacity_);
+template <typename T_key_, typename T_val_, typename T_hasher_>
+inline void Concurrent_Hash_Table<T_key_, T_val_, T_hasher_>::unlock(Key_Val_Pair& s) const
+{
+    __atomic_store_n(&s.stamp, epoch << 1, __ATOMIC_RELEASE);
+}
+
 
-    if constexpr(atomic_read)
+template <typename T_key_, typename T_val_, typename T_hasher_>
+template <typename T_f_>
+inline bool Concurrent_Hash_Table<T_key_, T_val_, T_hasher_>::insert_with(const T_key_ key, const T_val_ val, T_f_ on_existing)
+{
+    const auto h = hash(key);
+
+    // Slots are never vacated within an epoch, so a key moves on to the next
+    // level only if its window in the current one is full for good.
+    for(std::size_t l = 0; ; ++l)
     {
-        if(T[i].key == empty_key_)  // TODO: check atomic-read / partial-read guarantees.
+        std::size_t cap;
+        auto L = level(l, cap);
+        if(L == nullptr)
+            L = add_overflow_level(l);
+        const auto mask = cap - 1;
+        const auto probe_c = std::min(probe_window, cap);
+        std::size_t i = h & mask;
+        for(std::size_t tried_slots = 0; tried_slots < probe_c; )
         {
-            lock[i].lock();
-            if(T[i].key == empty_key_)
-                T[i].key = key, T[i].val = val,
-                success = true;
-            lock[i].unlock();
+            auto& s = L[i];
+            const auto stamp = stable_stamp(s);
+            if(!occupied(stamp))
+            {
+                if(!try_lock(s, stamp)) // Some other worker is claiming the slot; it is probed again.
+                    continue;
 
-            if(success)
+                s.key = key, s.val = val;
+                unlock(s);
                 return true;
-        }
+            }
 
-        if(T[i].key == key) // TODO: check atomic-read / partial-read guarantees.
-        {
-            lock[i].lock();
-            T[i].val = val;
-            lock[i].unlock();
+            if(s.key == key)    // The key of an occupied slot is stable.
+            {
+                if constexpr(!std::is_same_v<T_f_, std::nullptr_t>)
+                {
+                    lock(s);    // Some other worker can be manipulating the value.
+                    on_existing(s.val);
+                    unlock(s);
+                }
+
+                return false;
+            }
 
-            return false;
+            i = (i + 1) & mask, tried_slots++;
         }
     }
-    else
-    {
-        lock[i].lock();
+}
 
-        if(T[i].key == empty_key_)
-        {
-            T[i].key = key, T[i].val = val;
 
-            lock[i].unlock();
-            return true;
-        }
+template <typename T_key_, typename T_val_, typename T_hasher_>
+inline bool Concurrent_Hash_Table<T_key_, T_val_, T_hasher_>::insert(const T_key_ key, const T_val_ val)
+{
+    return insert_with(key, val, nullptr);
+}
 
-        if(T[i].key == key)
-        {
-            T[i].val = val;
 
-            lock[i].unlock();
-            return false;
-        }
+template <typename T_key_, typename T_val_, typename T_hasher_>
+inline bool Concurrent_Hash_Table<T_key_, T_val_, T_hasher_>::insert(const T_key_ key, const T_val_ val, T_val_*& val_add)
+{
+    return insert_with(key, val, [&](T_val_& v){ val_add = &v; });
+}
 
-        lock[i].unlock();
-    }
-    }
 
-    return false;
+template <typename T_key_, typename T_val_, typename T_hasher_>
+inline bool Concurrent_Hash_Table<T_key_, T_val_, T_hasher_>::insert_or_assign(const T_key_ key, const T_val_ val)
+{
+    return insert_with(key, val, [&](T_val_& v){ v = val; });
 }
 
 
 template <typename T_key_, typename T_val_, typename T_hasher_>
 inline T_val_* Concurrent_Hash_Table<T_key_, T_val_, T_hasher_>::find(const T_key_ key)
 {
-#ifndef NDEBUG
-    std::size_t tried_slots = 0;
-#endif
-
-    T_val_* val_add = nullptr;
-    for(std::size_t i = hash_to_idx(hash(key)); ; i = next_index(i))
-    if constexpr(atomic_read)
+    const auto h = hash(key);
+    std::size_t cap;
+    for(std::size_t l = 0; l <= max_overflow_c; ++l)
     {
-        if(T[i].key == key) // TODO: check atomic-read / partial-read guarantees.
-        {
-            lock[i].lock(); // To ensure that some other thread is not updating this val atm—a stable value is guaranteed.
-                            // This only works correctly because in our use-case of this table, a key is accessed only twice.
-            val_add = &T[i].val;
-            lock[i].unlock();
+        auto const L = level(l, cap);
+        if(L == nullptr)
             break;
-        }
-        else if(T[i].key == empty_key_) // TODO: check atomic-read / partial-read guarantees.
-            break;
-        else
-            assert(++tried_slots <= capacity_);
-    }
-    else
-    {
-        lock[i].lock();
 
-        if(T[i].key == key)
+        const auto mask = cap - 1;
+        const auto probe_c = std::min(probe_window, cap);
+        std::size_t i = h & mask;
+        for(std::size_t tried_slots = 0; tried_slots < probe_c; ++tried_slots)
         {
-            val_add = &T[i].val;    // This only works correctly because in our use-case of this table, a key is accessed only twice.
-            lock[i].unlock();
-            break;
-        }
-        else if(T[i].key == empty_key_)
-        {
-            lock[i].unlock();
-            break;
-        }
-        else
-            assert(++tried_slots <= capacity_);
+            // Waiting out the lock ensures that some other thread is not updating the value atm—a stable value is
+            // guaranteed. This only works correctly because in our use-case of this table, a key is accessed only twice.
+            const auto stamp = stable_stamp(L[i]);
+            if(!occupied(stamp))    // The key would have been put here.
+                return nullptr;
+
+            if(L[i].key == key)
+                return &L[i].val;
 
-        lock[i].unlock();
+            i = (i + 1) & mask;
+        }
     }
 
-    return val_add;
+    return nullptr;
 }
 
 
@@ -455,32 +533,6 @@ inline bool Concurrent_Hash_Table<T_key_, T_val_, T_hasher_>::find(const T_key_
 }
 
 
-template <typename T_key_, typename T_val_, typename T_hasher_>
-inline bool Concurrent_Hash_Table<T_key_, T_val_, T_hasher_>::CAS(T_key_* const ptr, const T_key_ old_key, const T_key_ new_key)
-{
-    constexpr auto key_bytes = sizeof(T_key_);
-    static_assert(  key_bytes == 1 || key_bytes == 2 || key_bytes == 4 || key_bytes == 8 || key_bytes == 16,
-                    "Unsupported-sized keys for CAS in hash-table.");
-
-    if constexpr(sizeof(T_key_) == 1)
-        return __sync_bool_compare_and_swap(reinterpret_cast<uint8_t*>(ptr), pun_type<uint8_t>(old_key), pun_type<uint8_t>(new_key));
-
-    if constexpr(sizeof(T_key_) == 2)
-        return __sync_bool_compare_and_swap(reinterpret_cast<uint16_t*>(ptr), pun_type<uint16_t>(old_key), pun_type<uint16_t>(new_key));
-
-    if constexpr(sizeof(T_key_) == 4)
-        return __sync_bool_compare_and_swap(reinterpret_cast<uint32_t*>(ptr), pun_type<uint32_t>(old_key), pun_type<uint32_t>(new_key));
-
-    if constexpr(sizeof(T_key_) == 8)
-        return __sync_bool_compare_and_swap(reinterpret_cast<uint64_t*>(ptr), pun_type<uint64_t>(old_key), pun_type<uint64_t>(new_key));
-
-    if constexpr(sizeof(T_key_) == 16)
-        return __sync_bool_compare_and_swap(reinterpret_cast<__uint128_t*>(ptr), pun_type<__uint128_t>(old_key), pun_type<__uint128_t>(new_key));
-
-    return false;
-}
-
-
 template <typename T_key_, typename T_val_, typename T_hasher_>
 template <bool hash_key_set_>
 inline uint64_t Concurrent_Hash_Table<T_key_, T_val_, T_hasher_>::signature() const
@@ -490,16 +542,18 @@ inline uint64_t Concurrent_Hash_Table<T_key_, T_val_, T_hasher_>::signature() co
     const auto hash =
         [&](const std::size_t idx)
         {
-            if(T[idx].key != empty_key_)
+            const auto& s = slot(idx);
+            if(occupied(s.stamp))
             {
                 if constexpr(hash_key_set_)
-                    sign[parlay::worker_id()].unwrap() ^= XXH3_64bits(&T[idx].key, sizeof(T[idx].key));
+                    sign[parlay::worker_id()].unwrap() ^= XXH3_64bits(&s.key, sizeof(s.key));
                 else
-                    sign[parlay::worker_id()].unwrap() ^= XXH3_64bits(&T[idx].val, sizeof(T[idx].val));
+                    sign[parlay::worker_id()].unwrap() ^= XXH3_64bits(&s.val, sizeof(s.val));
             }
         };
 
-    parlay::parallel_for(0, capacity_, hash, capacity_ / parlay::num_workers());
+    const auto slot_c = slot_count();
+    parlay::parallel_for(0, slot_c, hash, slot_c / parlay::num_workers());
 
     return std::accumulate(sign.cbegin(), sign.cend(), 0lu, [](const uint64_t r, const Padded<uint64_t>& p_data){ return r ^ p_data.unwrap(); });
 }
@@ -509,9 +563,10 @@ template <typename T_key_, typename T_val_, typename T_hasher_>
 inline Concurrent_Hash_Table<T_key_, T_val_, T_hasher_>::Iterator::Iterator(Concurrent_Hash_Table& M, std::size_t it_count, std::size_t it_id):
       M(M)
 {
-    const auto range_sz = (M.capacity_ + it_count - 1) / it_count;
-    idx = it_id * range_sz;
-    end = std::min((it_id + 1) * range_sz, M.capacity_);
+    const auto slot_c = M.slot_count();
+    const auto range_sz = (slot_c + it_count - 1) / it_count;
+    idx = std::min(it_id * range_sz, slot_c);
+    end = std::min((it_id + 1) * range_sz, slot_c);
 }
 
 
@@ -519,12 +574,15 @@ template <typename T_key_, typename T_val_, typename T_hasher_>
 inline bool Concurrent_Hash_Table<T_key_, T_val_, T_hasher_>::Iterator::next(T_key_& key, T_val_& val)
 {
     for(; idx < end; idx++)
-        if(M.T[idx].key != M.empty_key_)
+    {
+        const auto& s = M.slot(idx);
+        if(M.occupied(s.stamp))
         {
-            key = M.T[idx].key, val = M.T[idx].val;
+            key = s.key, val = s.val;
             idx++;
             return true;
         }
+    }
 
     return false;
 }
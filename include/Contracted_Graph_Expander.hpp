@@ -11,6 +11,7 @@
 #include "Kmer.hpp"
 #include "Kmer_Hasher.hpp"
 #include "Concurrent_Hash_Table.hpp"
+#include "Memory_Budget.hpp"
 #include "globals.hpp"
 #include "utility.hpp"
 
@@ -49,6 +50,12 @@ private:
 
     Concurrent_Hash_Table<Kmer<k>, Path_Info<k>, Kmer_Hasher<k, 0>> M;  // `M[v]` is the path-info for vertex `v`.
 
+    static constexpr std::size_t buf_bytes = 1 * 1024 * 1024;   // 1 MB preferred read-capacity of each read-buffer.
+    static constexpr std::size_t min_buf_bytes = 64 * 1024; // 64 KB minimum read-capacity of each read-buffer.
+    const std::size_t buf_bytes_w;  // Read-capacity of each worker-local read-buffer, in bytes.
+
+    const bool retain_input;    // Whether to retain the input of the expansion after its completion.
+
 
     // Expands the `[i, i]`'th (contracted) edge-block.
     void expand_diagonal_block(std::size_t i);
@@ -89,11 +96,20 @@ public:
     // Constructs an expander for the contracted discontinuity-graph `G`.
     // `P_v[i]` is to contain path-information for vertices at partition `i`,
     // and `P_e[b]` is to contain path-information for edges at bucket `b`.
-    // `logistics` is the data logistics manager for the algorithm execution.
-    Contracted_Graph_Expander(Discontinuity_Graph<k, Colored_>& G, P_v_t& P_v, P_e_t& P_e, const Data_Logistics& logistics);
+    // `logistics` is the data logistics manager for the algorithm execution,
+    // and `budget` is its memory governor. If `retain_input` is `true`, the
+    // input of the expansion—the vertices' path-info, the edge-matrix, and the
+    // contracted diagonal blocks—is retained after the expansion, so that it
+    // can be re-executed; it is to be removed with `remove_input` then.
+    Contracted_Graph_Expander(Discontinuity_Graph<k, Colored_>& G, P_v_t& P_v, P_e_t& P_e, const Data_Logistics& logistics, const Memory_Budget& budget, bool retain_input = false);
 
     // Expands the contracted discontinuity-graph.
     void expand();
+
+    // Removes the input of the expansion of the contracted discontinuity-graph
+    // `G`: the vertices' path-info `P_v`, the edge-matrix of `G`, and the
+    // contracted diagonal blocks at path-prefix `diagonal_path`.
+    static void remove_input(Discontinuity_Graph<k, Colored_>& G, P_v_t& P_v, const std::string& diagonal_path);
 };
 
 
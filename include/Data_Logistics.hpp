@@ -67,6 +67,19 @@ public:
     // Returns path prefix to the unitig-coordinate buckets produced in map-
     // reduce by Cuttlefish.
     const std::string unitig_coord_buckets_path() const;
+
+    // Returns path prefix to the buckets of the maximal unitigs' ends, for
+    // their links in GFA output.
+    const std::string unitig_end_buckets_path() const;
+
+    // Returns the path to the maximal unitigs staged for a path cover.
+    const std::string path_cover_segments_path() const;
+
+    // Returns the path to the manifest of the completed construction phases.
+    const std::string phase_manifest_path() const;
+
+    // Returns the path prefix to the checkpoints of the construction phases.
+    const std::string checkpoint_path() const;
 };
 
 
@@ -8,7 +8,11 @@
 #include "globals.hpp"
 
 #include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <string>
 #include <iostream>
+#include <cassert>
 
 
 namespace cuttlefish
@@ -41,6 +45,24 @@ private:
     static constexpr uint8_t phi_v[2]  = {0b0000'0000, 0b0000'1000};    // Flags to denote whether `v` is ϕ.
     static constexpr uint8_t unitig_o[2]  = {0b0000'0000, 0b0100'0000}; // Flags to denote the exit-orientation of the corresponding literal unitig wrt to the `(u, v)` orientation of the edge (`front: 0, back: 1`).
 
+    static constexpr std::size_t kmer_bytes = (k + 3) / 4;  // Number of bytes in the packed form of a k-mer.
+
+
+    // Returns the ϕ k-mer of the discontinuity graph.
+    static const Kmer<k>& phi();
+
+    // Appends the LEB128 varint of `x` at `p` and returns the end of it.
+    static uint8_t* put_varint(uint64_t x, uint8_t* p);
+
+    // Reads an LEB128 varint from `p` into `x` and returns the end of it.
+    static const uint8_t* get_varint(const uint8_t* p, uint64_t& x);
+
+    // Returns the zigzag-mapping of the difference `x - y`.
+    static uint64_t zigzag(uint64_t x, uint64_t y) { const auto d = static_cast<int64_t>(x - y); return (static_cast<uint64_t>(d) << 1) ^ static_cast<uint64_t>(d >> 63); }
+
+    // Returns `y + d`, where `z` is the zigzag-mapping of `d`.
+    static uint64_t unzigzag(uint64_t z, uint64_t y) { return y + ((z >> 1) ^ (~(z & 1) + 1)); }
+
 
 public:
 
@@ -107,6 +129,19 @@ public:
     // (De)serializes the edge from / to the `cereal` archive `archive`.
     template <typename T_archive_> void serialize(T_archive_& archive);
 
+    // Returns the maximum size in bytes of the packed form of an edge.
+    static constexpr std::size_t max_packed_bytes() { return 1 + 2 * kmer_bytes + 3 + 3 + 5; }
+
+    // Packs the `n` edges at `E` into `p`, and returns the size of the packed
+    // form in bytes. `p` must have space for `n * max_packed_bytes()` bytes.
+    // The packed form omits the ϕ endpoints and the unused bits of the k-mers,
+    // and has varint-encoded weights and delta-encoded unitig-coordinates.
+    static std::size_t pack(const Discontinuity_Edge* E, std::size_t n, uint8_t* p);
+
+    // Unpacks `n` edges from their packed form at `p` into `E`, and returns the
+    // number of bytes consumed.
+    static std::size_t unpack(const uint8_t* p, std::size_t n, Discontinuity_Edge* E);
+
     // Pretty-prints the edge `e` to the stream `os`.
     friend std::ostream& operator<<(std::ostream& os, const Discontinuity_Edge<k>& e)
     {
@@ -141,6 +176,99 @@ inline void Discontinuity_Edge<k>::serialize(T_archive_& archive)
     archive(u_, v_, weight, bucket_id, b_idx_, mask);
 }
 
+
+template <uint16_t k>
+inline const Kmer<k>& Discontinuity_Edge<k>::phi()
+{
+    static const Kmer<k> phi_(std::string(k, 'T'));    // Same as `Discontinuity_Graph::phi()`.
+    return phi_;
+}
+
+
+template <uint16_t k>
+inline uint8_t* Discontinuity_Edge<k>::put_varint(uint64_t x, uint8_t* p)
+{
+    for(; x >= 0x80; x >>= 7)
+        *p++ = static_cast<uint8_t>(x | 0x80);
+    *p++ = static_cast<uint8_t>(x);
+
+    return p;
+}
+
+
+template <uint16_t k>
+inline const uint8_t* Discontinuity_Edge<k>::get_varint(const uint8_t* p, uint64_t& x)
+{
+    x = 0;
+    for(uint16_t shift = 0; ; shift += 7)
+    {
+        const uint8_t b = *p++;
+        x |= static_cast<uint64_t>(b & 0x7f) << shift;
+        if(!(b & 0x80))
+            return p;
+    }
+}
+
+
+template <uint16_t k>
+inline std::size_t Discontinuity_Edge<k>::pack(const Discontinuity_Edge* const E, const std::size_t n, uint8_t* const p)
+{
+    // The k-mers are copied off their little-endian words, and hence their
+    // leading `kmer_bytes` bytes have all the bases.
+    static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__);
+    static_assert(sizeof(Kmer<k>) == ((k + 31) / 32) * sizeof(uint64_t));
+
+    auto q = p;
+    uint64_t b = 0, b_idx = 0;  // Unitig-coordinates of the last edge.
+    for(std::size_t i = 0; i < n; ++i)
+    {
+        const auto& e = E[i];
+        *q++ = e.mask;
+
+        assert(!e.u_is_phi() || e.u_ == phi());
+        assert(!e.v_is_phi() || e.v_ == phi());
+        if(!e.u_is_phi())
+            std::memcpy(q, e.u_.data(), kmer_bytes), q += kmer_bytes;
+        if(!e.v_is_phi())
+            std::memcpy(q, e.v_.data(), kmer_bytes), q += kmer_bytes;
+
+        q = put_varint(e.weight, q);
+        q = put_varint(zigzag(e.bucket_id, b), q);
+        q = put_varint(zigzag(e.b_idx_, b_idx), q);
+        b = e.bucket_id, b_idx = e.b_idx_;
+    }
+
+    return q - p;
+}
+
+
+template <uint16_t k>
+inline std::size_t Discontinuity_Edge<k>::unpack(const uint8_t* const p, const std::size_t n, Discontinuity_Edge* const E)
+{
+    auto q = p;
+    uint64_t b = 0, b_idx = 0;  // Unitig-coordinates of the last edge.
+    uint64_t x;
+    for(std::size_t i = 0; i < n; ++i)
+    {
+        auto& e = E[i];
+        e.mask = *q++;
+
+        e.u_ = phi();
+        if(!e.u_is_phi())
+            e.u_ = Kmer<k>(), std::memcpy(static_cast<void*>(&e.u_), q, kmer_bytes), q += kmer_bytes;
+
+        e.v_ = phi();
+        if(!e.v_is_phi())
+            e.v_ = Kmer<k>(), std::memcpy(static_cast<void*>(&e.v_), q, kmer_bytes), q += kmer_bytes;
+
+        q = get_varint(q, x), e.weight = x;
+        q = get_varint(q, x), b = unzigzag(x, b), e.bucket_id = b;
+        q = get_varint(q, x), b_idx = unzigzag(x, b_idx), e.b_idx_ = b_idx;
+    }
+
+    return q - p;
+}
+
 }
 
 
@@ -11,6 +11,7 @@
 #include "Ext_Mem_Bucket.hpp"
 #include "Color_Encoding.hpp"
 #include "Build_Params.hpp"
+#include "Memory_Budget.hpp"
 #include "globals.hpp"
 #include "parlay/parallel.h"
 #include "utility.hpp"
@@ -49,6 +50,7 @@ private:
     static const Kmer<k> phi_;  // ϕ k-mer connected to each chain-end in the discontinuity graph.
 
     const uint16_t min_len; // Size of the l-minimizers.
+    const uint64_t graph_count; // Number of subgraphs the de Bruijn graph is partitioned into.
 
     Edge_Matrix<k> E_;  // Edge-matrix of the discontinuity graph.
 
@@ -60,13 +62,17 @@ private:
     const source_id_t max_source_id_;   // Maximum source-ID, used for coloring.
     std::vector<Padded<Ext_Mem_Bucket<Vertex_Color_Mapping>>> vertex_color_map_;    // Buckets of vertex-color mappings.
 
+    static constexpr std::size_t vertex_color_pref_mem_bytes = 64 * 1024;   // Preferred memory in bytes per vertex-color mapping bucket before it spills.
+
 
 public:
 
     // Constructs a discontinuity graph object that operates with the required
-    // parameters in `params`. `logistics` is the data logistics manager for
-    // the algorithm execution.
-    Discontinuity_Graph(const Build_Params& params, const Data_Logistics& logistics);
+    // parameters in `params`, for a de Bruijn graph partitioned into
+    // `graph_count` subgraphs. `logistics` is the data logistics manager for
+    // the algorithm execution. The vertex-color mappings kept in memory before
+    // spilling are limited to a share of the subgraphs-stage of `budget`.
+    Discontinuity_Graph(const Build_Params& params, uint64_t graph_count, const Data_Logistics& logistics, const Memory_Budget& budget);
 
     // Deserializes the discontinuity graph from the `cereal` archive `archive`.
     Discontinuity_Graph(cereal::BinaryInputArchive& archive);
@@ -115,16 +121,31 @@ public:
     // Returns the `b`'th vertex-color mapping bucket.
     auto& vertex_color_map(const std::size_t b) { assert(b < vertex_color_map_.size()); return vertex_color_map_[b].unwrap(); }
 
+    // Returns the maximum memory in bytes held by the vertex-color mapping
+    // buckets before they spill to external-memory.
+    std::size_t vertex_color_map_mem_bytes() const;
+
     // Increments the potential phantom edge count.
     void inc_potential_phantom_edge() { phantom_edge_count_++; }
 
-    // Closes and releases the streams depositing to the graph.
+    // Closes and releases the streams depositing the locally-maximal unitigs
+    // and their colors to the graph. These are deposited only during the
+    // subgraphs' contraction.
+    void close_lmtigs();
+
+    // Closes and releases the streams depositing edges to the graph.
     void close();
 
     // Returns a tight upper bound of the maximum number of vertices in a
     // partition.
     std::size_t vertex_part_size_upper_bound() const;
 
+    // Returns a tight upper bound of the number of vertices in partition `j`.
+    std::size_t vertex_part_size_upper_bound(std::size_t j) const;
+
+    // Returns an estimate of the number of vertices in partition `j`.
+    std::size_t vertex_part_size_estimate(std::size_t j) const;
+
     // Returns `true` iff the k-mer at `seq` is a discontinuity vertex.
     bool is_discontinuity(const char* seq) const;
 
@@ -187,7 +208,7 @@ template <typename T_archive_>
 inline void Discontinuity_Graph<k, Colored_>::serialize(T_archive_& archive)
 {
     uint64_t phantom_edge_c = phantom_edge_count_;
-    archive(type::mut_ref(min_len), E_, lmtigs, phantom_edge_c, type::mut_ref(max_source_id_), vertex_color_map_);
+    archive(type::mut_ref(min_len), type::mut_ref(graph_count), E_, lmtigs, phantom_edge_c, type::mut_ref(max_source_id_), vertex_color_map_);
     phantom_edge_count_ = phantom_edge_c;
 }
 
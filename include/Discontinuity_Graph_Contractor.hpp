@@ -10,8 +10,8 @@
 #include "Discontinuity_Edge.hpp"
 #include "Discontinuity_Graph.hpp"
 #include "Concurrent_Hash_Table.hpp"
+#include "Memory_Budget.hpp"
 #include "utility.hpp"
-#include "unordered_dense/unordered_dense.h"
 
 #include <cstdint>
 #include <cstddef>
@@ -44,20 +44,48 @@ private:
     class Other_End;
     Concurrent_Hash_Table<Kmer<k>, Other_End, Kmer_Hasher<k>> M;    // `M[v]` is the associated vertex to `v` at a given time.
 
-    // TODO: remove `D_j` by adopting a more parallelization-amenable algorithm for diagonal contraction-expansion.
-    std::vector<Discontinuity_Edge<k>> D_j; // Edges introduced in contracting a diagonal block. TODO: remove `D_j` by adding these edges to the diagonal block.
+    static constexpr std::size_t buf_bytes = 1 * 1024 * 1024;   // 1 MB preferred read-capacity of the edge-read buffers.
+    static constexpr std::size_t min_buf_bytes = 64 * 1024; // 64 KB minimum read-capacity of the edge-read buffers.
+    static constexpr std::size_t read_ahead_bytes = 8 * 1024 * 1024;    // 8 MB of the edge-blocks of the next partition to read ahead while contracting a partition.
+    const std::size_t buf_cap;  // Capacity of the worker-local edge-read buffers, in edges.
+
+    std::vector<Padded<std::vector<Discontinuity_Edge<k>>>> D_j;    // `D_j[t]` contains the edges introduced by worker `t` in contracting a diagonal block, other than the compressed chains. TODO: remove `D_j` by adding these edges to the diagonal block.
     std::vector<Padded<std::vector<Discontinuity_Edge<k>>>> D_c;    // `D_c[t]` contains the edges corresponding to compressed diagonal chains by worker `t`.
     Buffer<Discontinuity_Edge<k>> D_c_flat; // Flattened `D_c`.
 
-    ankerl::unordered_dense::map<Kmer<k>, Other_End, Kmer_Hasher<k>> D; // `D[v]` is the associated vertex to `v` at a given time during diagonal compression.
+    class Chain_Link;
+    Concurrent_Hash_Table<Kmer<k>, std::size_t, Kmer_Hasher<k>> N;  // `N[v]` is the index of the vertex `v` during the compression of a diagonal block.
+    Buffer<Kmer<k>> V;  // `V[i]` is the vertex with index `i` in the diagonal block, if `mark[i]` is non-zero.
+    Buffer<uint8_t> mark;   // `mark[i]` is `0` if the index `i` is not assigned to any vertex; otherwise `1`, or `2` once visited in linearizing a cycle.
+    Buffer<Chain_Link> A;   // `A[2i + s]` is the link through the diagonal edge at side `s` of the vertex with index `i`.
+    Buffer<Chain_Link> J;   // `J[2i + s]` is the farthest link found from side `s` of the vertex with index `i` during pointer jumping.
 
     std::atomic_uint64_t phantom_count_;    // Number of phantom edges.
     std::atomic_uint64_t icc_count; // Number of ICCs.
 
 
-    // Contracts the `[j, j]`'th edge-block. Buffer `buf` is used to read the
-    // edges.
-    void contract_diagonal_block(std::size_t j, Buffer<Discontinuity_Edge<k>>& buf);
+    // Contracts the `[j, j]`'th edge-block. The worker-local buffers `B` are
+    // used to read the edges. The diagonal edges form vertex-disjoint chains
+    // and cycles; each vertex finds the endpoints of its chain by pointer
+    // jumping, and is linked to one of them with a new edge.
+    void contract_diagonal_block(std::size_t j, std::vector<Padded<Buffer<Discontinuity_Edge<k>>>>& B);
+
+    // Returns the index of the vertex `v` in the diagonal block, assigning it
+    // the index `i` if it has none yet.
+    std::size_t vertex_idx(const Kmer<k>& v, std::size_t i);
+
+    // Links the vertices in the diagonal block with the diagonal edge `e`.
+    // `i` is the index reserved for `e`'s `x` endpoint, and `i + 1` for `y`.
+    void link_diagonal_edge(const Discontinuity_Edge<k>& e, std::size_t i);
+
+    // Finds the endpoints of the chains through pointer jumping from each of
+    // the `idx_c` vertex-indices.
+    void jump_chains(std::size_t idx_c);
+
+    // Breaks the cycle containing the vertex with index `r` by its side
+    // `side_t::front`, with `r` as the rank-1 vertex, and collects the edges
+    // from `r` to the other cycle members into `D`. Marks the members visited.
+    void linearize_cycle(std::size_t r, std::vector<Discontinuity_Edge<k>>& D);
 
     // Forms a meta-vertex in the contracted graph with the vertex `v` belonging
     // to the vertex-partition `part`. In the contracted graph, `v` has a `w_1`
@@ -82,14 +110,52 @@ public:
 
     // Constructs a contractor for the discontinuity-graph `G`. `P_v[j]` is to
     // contain path-information for vertices at partition `j`. `logistics` is
-    // the data logistics manager for the algorithm execution.
-    Discontinuity_Graph_Contractor(Discontinuity_Graph<k, Colored_>& G, P_v_t& P_v, const Data_Logistics& logistics);
+    // the data logistics manager for the algorithm execution, and `budget` is
+    // its memory governor.
+    Discontinuity_Graph_Contractor(Discontinuity_Graph<k, Colored_>& G, P_v_t& P_v, const Data_Logistics& logistics, const Memory_Budget& budget);
 
     // Contracts the discontinuity-graph.
     void contract();
 };
 
 
+// =============================================================================
+// A link from a vertex in a diagonal block to another vertex along its chain.
+// It is packed into 64 bits, to be read and written atomically during pointer
+// jumping.
+template <uint16_t k, bool Colored_>
+class Discontinuity_Graph_Contractor<k, Colored_>::Chain_Link
+{
+public:
+
+    uint64_t v      : 40;   // Index of the linked vertex.
+    uint64_t w      : 16;   // Weight of the chain-segment to the linked vertex.
+    uint64_t s      : 1;    // Side of the linked vertex through which the segment enters it.
+    uint64_t is_end : 1;    // Whether the linked vertex is an endpoint of its chain.
+    uint64_t present: 1;    // Whether the link exists.
+
+    // Constructs an absent link.
+    Chain_Link(): v(0), w(0), s(0), is_end(0), present(0)
+    {}
+
+    // Constructs a link to the vertex with index `v` through a segment of
+    // weight `w` entering it through its side `s`. `is_end` denotes whether
+    // `v` is an endpoint of its chain.
+    Chain_Link(const std::size_t v, const weight_t w, const side_t s, const bool is_end = false):
+          v(v), w(w), s(s == side_t::back), is_end(is_end), present(1)
+    {}
+
+    // Returns the side of the linked vertex through which the segment enters it.
+    side_t side() const { return s ? side_t::back : side_t::front; }
+
+    // Returns the link atomically loaded from `l`.
+    static Chain_Link load(const Chain_Link& l) { Chain_Link r; __atomic_load(&l, &r, __ATOMIC_RELAXED); return r; }
+
+    // Atomically stores `l` into `dest`.
+    static void store(Chain_Link& dest, Chain_Link l) { __atomic_store(&dest, &l, __ATOMIC_RELAXED); }
+};
+
+
 // =============================================================================
 // Other endpoint `v` associated to a current vertex `u` through an edge.
 template <uint16_t k, bool Colored_>
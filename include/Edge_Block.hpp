@@ -0,0 +1,274 @@
+
+#ifndef EDGE_BLOCK_HPP
+#define EDGE_BLOCK_HPP
+
+
+
+#include "Discontinuity_Edge.hpp"
+#include "Spin_Lock.hpp"
+#include "Async_IO.hpp"
+#include "utility.hpp"
+#include "globals.hpp"
+#include "cereal/types/vector.hpp"
+#include "cereal/types/string.hpp"
+#include "parlay/parallel.h"
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <cstdlib>
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <unistd.h>
+#include <sys/stat.h>
+
+
+namespace cuttlefish
+{
+
+// =============================================================================
+// A concurrent external-memory block of the edge-matrix of a discontinuity-
+// graph of `k`-mers. Workers stage the edges in local buffers, and a full
+// buffer is flushed to the block-file as a frame: the edges packed per
+// `Discontinuity_Edge::pack`, and then LZ4-compressed if that shrinks them.
+// The frames are written asynchronously, and decoded transparently on reads.
+template <uint16_t k>
+class Edge_Block
+{
+private:
+
+    typedef Discontinuity_Edge<k> edge_t;
+
+    static constexpr std::size_t in_memory_bytes = 32 * 1024;   // 32KB.
+    static constexpr std::size_t read_bytes = 1024 * 1024;  // Maximum number of bytes of the block-file read in one go, unless a frame is larger—1MB.
+
+    // A flush of edges in the block-file.
+    struct Frame
+    {
+        uint64_t off;   // Byte-offset of the frame in the block-file.
+        uint32_t bytes; // Size of the frame in the block-file.
+        uint32_t packed_bytes;  // Size of the packed edges of the frame; the frame is compressed iff this is larger than `bytes`.
+        uint32_t edge_c;    // Number of edges in the frame.
+
+        // (De)serializes the frame from / to the `cereal` archive `archive`.
+        template <typename T_archive_> void serialize(T_archive_& archive) { archive(off, bytes, packed_bytes, edge_c); }
+    };
+
+    // Worker-local scratch space to encode and decode frames.
+    struct Scratch
+    {
+        Buffer<uint8_t> packed; // Packed edges.
+        Buffer<uint8_t> out[2]; // Frames being written, double-buffered.
+        uint8_t cur = 0;    // Index of the frame-buffer to write next.
+        IO_Request req; // Request of the pending frame-write.
+        Buffer<uint8_t> in; // Frames read off the block-file.
+    };
+
+    const std::string file_path;    // Path to the file storing the block.
+    const std::size_t max_buf_bytes;    // Maximum size of the in-memory worker-local edge-buffers in bytes.
+    const std::size_t max_buf_elems;    // Maximum size of the in-memory worker-local edge-buffers in elements.
+
+    std::size_t flushed;    // Number of edges added to the block and flushed to external-memory.
+    std::size_t bytes_; // Size of the block-file.
+    std::vector<Frame> frames;  // Frames in the block-file, in the order of their offsets.
+
+    std::vector<Padded<std::vector<edge_t>>> buf_w_local;   // In-memory worker-local buffers of the edges.
+    mutable std::vector<Padded<Scratch>> scratch;   // Worker-local scratch spaces.
+
+    int fd; // Descriptor of the block-file.
+    mutable Spin_Lock lock_;    // Lock to shared resources.
+
+    mutable std::size_t read_frame; // Index of the next frame to read.
+    mutable bool read_bufs_pending; // Whether reading the content of the worker-local buffers is pending.
+
+    mutable Buffer<uint8_t> ra_buf; // Leading frames of the block-file read ahead.
+    std::size_t ra_frame_c; // Number of leading frames read ahead; `0` if none is staged.
+    mutable std::atomic_size_t ra_pending;  // Number of frames read ahead yet to be decoded.
+    mutable IO_Request ra_req;  // Request of the read-ahead.
+
+    // States of the read-ahead.
+    enum RA_State : uint8_t
+    {
+        ra_issued,  // The read-ahead has been issued, and its result is unclaimed.
+        ra_claimed, // A worker has claimed the read-ahead and is collecting its result.
+        ra_ready,   // The result of the read-ahead has been collected.
+    };
+
+    mutable std::atomic<uint8_t> ra_state;  // State of the read-ahead.
+
+
+    // Flushes the in-memory buffer content of the worker `w` to external-
+    // memory as a frame. The lock is held only to reserve the range of the
+    // block-file to write to. The write is asynchronous; the worker waits only
+    // if its previous flush is pending.
+    void flush(std::size_t w);
+
+    // Waits for the pending flushes of all the workers to complete.
+    void sync() const;
+
+    // Opens the block-file; truncates it iff `truncate` is `true`.
+    void open_file(bool truncate);
+
+    // Reads `bytes` bytes from byte-offset `off` of the block-file into `buf`.
+    void read(uint8_t* buf, std::size_t bytes, off_t off) const;
+
+    // Decodes the frames `[f_beg, f_end)` into `E` and returns the number of
+    // edges decoded.
+    std::size_t decode(std::size_t f_beg, std::size_t f_end, edge_t* E) const;
+
+    // Copies the edges in the worker-local buffers into `E` and returns their
+    // count.
+    std::size_t copy_bufs(edge_t* E) const;
+
+    // Frees the read-scratch spaces of the workers.
+    void free_read_scratch() const;
+
+    // Waits for the read-ahead to complete.
+    void wait_read_ahead() const;
+
+    // Returns `true` iff the read-ahead content is available to the caller.
+    // The first caller claims the read-ahead and collects its result, so that
+    // an I/O error is reported once. Others get `false` while it is being
+    // collected, and are to read their frames themselves.
+    bool claim_read_ahead() const;
+
+
+public:
+
+    // Constructs an edge-block at path `file_path`. An optional in-memory
+    // buffer size (in bytes) `buf_sz` for each worker can be specified.
+    Edge_Block(const std::string& file_path, std::size_t buf_sz = in_memory_bytes);
+
+    // Constructs a placeholder block.
+    Edge_Block(): Edge_Block("", 0)
+    {}
+
+    Edge_Block(Edge_Block&& rhs);
+
+    Edge_Block(const Edge_Block&) = delete;
+    Edge_Block& operator=(const Edge_Block&) = delete;
+    Edge_Block& operator=(Edge_Block&&) = delete;
+
+    ~Edge_Block();
+
+    // Returns the number of edges in the block. It is exact only when the
+    // block is not being updated.
+    std::size_t size() const;
+
+    // Returns the size of the block-file in bytes.
+    std::size_t bytes() const { return bytes_; }
+
+    // Emplaces an edge, with its constructor-arguments being `args`, into the
+    // block.
+    template <typename... Args> void emplace(Args&&... args);
+
+    // Flushes all the edges to the block-file and closes it for writes. Edges
+    // should not be added anymore once this has been invoked.
+    void close();
+
+    // Loads the block into the vector `v`. It is safe only when the block is
+    // not being updated.
+    void load(std::vector<edge_t>& v) const;
+
+    // Loads the block into `b` and returns its size. `b` must have enough
+    // space allocated for all the edges. It is safe only when the block is not
+    // being updated.
+    std::size_t load(edge_t* b) const;
+
+    // Tries to read a chunk of size at most `n` into the buffer `buf`, and
+    // returns the number of edges read. The chunk consists of whole frames,
+    // hence more than `n` edges are read if the next frame is larger; `buf` is
+    // grown in that case. Returns `0` iff the block has been read off
+    // completely. It is safe only when the block is not being updated.
+    std::size_t read_buffered(Buffer<edge_t>& buf, std::size_t n) const;
+
+    // Resets the read-status of each worker.
+    void reset_read();
+
+    // Issues asynchronously reading the leading frames of the block-file,
+    // at most `max_bytes` bytes of them, so that the next read of the block
+    // starts warm. Returns the number of bytes issued. It is a no-op if the
+    // block is being read, or has a read-ahead staged already.
+    std::size_t read_ahead(std::size_t max_bytes);
+
+    // Removes the block.
+    void remove();
+
+    // Returns the resident set size of the space-dominant components of this
+    // block.
+    std::size_t RSS() const;
+
+    // Serializes the block to the `cereal` archive `archive`.
+    template <typename T_archive_> void save(T_archive_& archive) const;
+
+    // Deserializes the block from the `cereal` archive `archive`.
+    template <typename T_archive_> void load(T_archive_& archive);
+};
+
+
+template <uint16_t k>
+inline std::size_t Edge_Block<k>::size() const
+{
+    std::size_t in_buf_sz = 0;
+    std::for_each(buf_w_local.cbegin(), buf_w_local.cend(), [&](const auto& b){ in_buf_sz += b.unwrap().size(); });
+
+    return flushed + in_buf_sz;
+}
+
+
+template <uint16_t k>
+template <typename... Args>
+inline void Edge_Block<k>::emplace(Args&&... args)
+{
+    const auto w = parlay::worker_id();
+    auto& buf = buf_w_local[w].unwrap();
+    buf.emplace_back(args...);
+
+    assert(buf.size() <= max_buf_elems);
+    if(buf.size() == max_buf_elems)
+        flush(w);
+}
+
+
+template <uint16_t k>
+template <typename T_archive_>
+inline void Edge_Block<k>::save(T_archive_& archive) const
+{
+    sync();
+    archive(file_path, max_buf_bytes, max_buf_elems, flushed, bytes_, frames, buf_w_local);
+}
+
+
+template <uint16_t k>
+template <typename T_archive_>
+inline void Edge_Block<k>::load(T_archive_& archive)
+{
+    archive(type::mut_ref(file_path), type::mut_ref(max_buf_bytes), type::mut_ref(max_buf_elems),
+            flushed, bytes_, frames, buf_w_local);
+
+    assert(file_path.empty() || max_buf_elems > 0);
+
+    if(!file_path.empty())
+    {
+        open_file(false);
+
+        // Frames past the serialized state may have been written to the file
+        // afterwards, e.g. by an interrupted execution; they are dropped.
+        const auto bytes = static_cast<off_t>(bytes_);
+        struct stat st;
+        if(::fstat(fd, &st) != 0 || st.st_size < bytes || (st.st_size > bytes && ::ftruncate(fd, bytes) != 0))
+        {
+            std::cerr << "Error restoring edge-block at " << file_path << ". Aborting.\n";
+            std::exit(EXIT_FAILURE);
+        }
+    }
+}
+
+}
+
+
+
+#endif
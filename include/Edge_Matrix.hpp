@@ -5,7 +5,7 @@
 
 
 #include "Discontinuity_Edge.hpp"
-#include "Ext_Mem_Bucket.hpp"
+#include "Edge_Block.hpp"
 #include "utility.hpp"
 #include "cereal/types/vector.hpp"
 #include "cereal/types/string.hpp"
@@ -29,8 +29,8 @@ private:
 
     const std::size_t vertex_part_count_;   // Number of vertex-partitions in the graph; it needs to be a power of 2.
     const std::string path; // File-path prefix to the external-memory blocks of the matrix.
-    std::vector<std::vector<Ext_Mem_Bucket_Concurrent<Discontinuity_Edge<k>>>> edge_matrix; // Blocked edge matrix.
-    // TODO: do the cells need padding, or do the pads within the concurrent buckets suffice?
+    std::vector<std::vector<Edge_Block<k>>> edge_matrix;    // Blocked edge matrix.
+    // TODO: do the cells need padding, or do the pads within the blocks suffice?
 
     mutable std::vector<std::size_t> row_to_read;   // `j`'th entry contains the row of the next block to read from column `j`.
     mutable std::vector<std::size_t> col_to_read;   // `i`'th entry contains the column of the next block to read from row `i`.
@@ -82,6 +82,10 @@ public:
     // Resets the read-status of each worker for the entire matrix.
     void reset_read();
 
+    // Issues asynchronously reading ahead the leading edges of the blocks in
+    // column `j`, the diagonal one first, at most `max_bytes` bytes in total.
+    void read_ahead_column(std::size_t j, std::size_t max_bytes);
+
     // Reads a chunk of edges from the row `i` into `buf`. Returns the count of
     // edges read. If `0` is returned, then the column has been depleted.
     // NB: this does not read the blocks in the diagonal.
@@ -128,8 +132,9 @@ inline std::size_t Edge_Matrix<k>::partition(const Kmer<k>& kmer) const
 template <uint16_t k>
 inline void Edge_Matrix<k>::add(const Kmer<k> u, const side_t s_u, const Kmer<k> v, const side_t s_v, const weight_t w, const uint16_t b, const std::size_t b_idx, const bool u_is_phi, const bool v_is_phi)
 {
-    // TODO: add batched insertion per worker instead of locking a cell at every insertion.
-    // TODO: almost surely the lack of batched insertion is the scalability bottleneck.
+    // The edge is staged in the invoking worker's local buffer for the block;
+    // the block is locked only when that buffer is flushed in bulk, and only
+    // to reserve its range in the block-file.
 
     auto p = u_is_phi ? 0 : partition(u);
     auto q = v_is_phi ? 0 : partition(v);
@@ -5,6 +5,7 @@
 
 
 #include "Spin_Lock.hpp"
+#include "Async_IO.hpp"
 #include "utility.hpp"
 #include "globals.hpp"
 #include "cereal/types/vector.hpp"
@@ -21,13 +22,20 @@
 #include <cstdlib>
 #include <algorithm>
 #include <cassert>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
 
 
 namespace cuttlefish
 {
 
 // =============================================================================
-// An external-memory-backed bucket for elements of type `T_`.
+// An external-memory-backed bucket for elements of type `T_`. The in-memory
+// buffer is double-buffered: a full buffer is written asynchronously while the
+// other one is being filled. The bucket-file is created only at the first
+// spill to external-memory; till then, the buffer may grow up to a memory-cap,
+// and small buckets live entirely in memory.
 template <typename T_>
 class Ext_Mem_Bucket
 {
@@ -38,15 +46,26 @@ public:
     const std::string file_path;    // Path to the file storing the bucket.
     const std::size_t max_buf_bytes;    // Maximum size of the in-memory write-buffer in bytes.
     const std::size_t max_buf_elems;    // Maximum size of the in-memory write-buffer in elements.
+    const std::size_t max_mem_elems;    // Maximum number of elements kept in memory before the first spill.
 
     Buffer<T_> buf; // In-memory buffer of the bucket-elements.
+    Buffer<T_> flush_buf;   // In-memory buffer being flushed, allocated at the first flush.
     std::size_t size_;  // Number of elements added to the bucket.
 
     std::size_t in_mem_size;    // Number of elements in the in-memory buffer.
 
-    std::ofstream file; // The bucket-file.
+    mutable Async_Writer file;  // Writer to the bucket-file; its pending writes are synced by the const readers too.
+    bool on_disk;   // Whether the bucket-file has been created, i.e. the bucket has spilled to external-memory.
 
 
+    // Returns the number of in-memory elements that triggers a spill or a
+    // buffer-growth.
+    std::size_t buf_cap() const { return on_disk ? max_buf_elems : buf.capacity(); }
+
+    // Makes space in the full in-memory buffer: grows it if the bucket has
+    // not spilled yet and the memory-cap permits, and flushes it otherwise.
+    void make_space();
+
     // Flushes the in-memory buffer content to external memory.
     void flush();
 
@@ -55,7 +74,9 @@ public:
 
     // Constructs an external-memory bucket at path `file_path`. An optional in-
     // memory buffer size (in bytes) `buf_sz` for the bucket can be specified.
-    Ext_Mem_Bucket(const std::string& file_path, const std::size_t buf_sz = in_memory_bytes);
+    // Until the first spill, the buffer may grow up to `mem_sz` bytes; it is
+    // `buf_sz` if not specified.
+    Ext_Mem_Bucket(const std::string& file_path, const std::size_t buf_sz = in_memory_bytes, const std::size_t mem_sz = 0);
 
     // Constructs a placeholder bucket.
     Ext_Mem_Bucket(): Ext_Mem_Bucket("", 0)
@@ -86,14 +107,21 @@ public:
     template <typename... Args> void emplace(Args&&... args);
 
     // Serializes and closes the bucket. Elements should not be added anymore
-    // once this has been invoked. This method is required only if the entirety
-    // of the bucket needs to live in external-memory after the parent process
-    // finishes.
+    // once this has been invoked. A bucket that has not spilled is not written
+    // out; its elements are kept in a trimmed in-memory buffer instead.
     void serialize();
 
     // Loads the bucket into `b` and returns its size.
     std::size_t load(T_* b) const;
 
+    // Returns the elements of the bucket in-place if none of them has been
+    // flushed to external-memory, and `nullptr` otherwise.
+    const T_* in_memory_data() const { return in_mem_size == size_ ? buf.data() : nullptr; }
+
+    // Returns whether the bucket has spilled to external-memory, i.e. has its
+    // file at `file_path`.
+    bool spilled() const { return on_disk; }
+
     // Clears the bucket.
     void clear();
 
@@ -113,24 +141,17 @@ public:
 
 
 template <typename T_>
-inline Ext_Mem_Bucket<T_>::Ext_Mem_Bucket(const std::string& file_path, const std::size_t buf_sz):
+inline Ext_Mem_Bucket<T_>::Ext_Mem_Bucket(const std::string& file_path, const std::size_t buf_sz, const std::size_t mem_sz):
       file_path(file_path)
     , max_buf_bytes(buf_sz)
     , max_buf_elems(buf_sz / sizeof(T_))
+    , max_mem_elems(std::max(buf_sz, mem_sz) / sizeof(T_))
     , buf(max_buf_elems)
     , size_(0)
     , in_mem_size(0)
+    , on_disk(false)
 {
     assert(file_path.empty() || max_buf_elems > 0);
-
-    if(!file_path.empty())
-        file.open(file_path, std::ios::binary);
-
-    if(!file)
-    {
-        std::cerr << "Error opening external-memory bucket at " << file_path << ". Aborting.\n";
-        std::exit(EXIT_FAILURE);
-    }
 }
 
 
@@ -139,10 +160,13 @@ inline Ext_Mem_Bucket<T_>::Ext_Mem_Bucket(Ext_Mem_Bucket&& rhs):
       file_path(std::move(rhs.file_path))
     , max_buf_bytes(std::move(rhs.max_buf_bytes))
     , max_buf_elems(std::move(rhs.max_buf_elems))
+    , max_mem_elems(std::move(rhs.max_mem_elems))
     , buf(std::move(rhs.buf))
+    , flush_buf(std::move(rhs.flush_buf))
     , size_(std::move(rhs.size_))
     , in_mem_size(std::move(rhs.in_mem_size))
     , file(std::move(rhs.file))
+    , on_disk(std::move(rhs.on_disk))
 {}
 
 
@@ -152,9 +176,9 @@ inline void Ext_Mem_Bucket<T_>::add(const T_& elem)
     buf[in_mem_size++] = elem;
     size_++;
 
-    assert(in_mem_size <= max_buf_elems);
-    if(in_mem_size == max_buf_elems)
-        flush();
+    assert(in_mem_size <= buf_cap());
+    if(in_mem_size == buf_cap())
+        make_space();
 }
 
 
@@ -165,13 +189,13 @@ inline void Ext_Mem_Bucket<T_>::add(const T_* const buf, const std::size_t sz)
     std::size_t added = 0;
     while(rem_sz > 0)
     {
-        const auto to_add = std::min(rem_sz, max_buf_elems - in_mem_size);
+        const auto to_add = std::min(rem_sz, buf_cap() - in_mem_size);
         std::memcpy(reinterpret_cast<char*>(this->buf.data() + in_mem_size), reinterpret_cast<const char*>(buf + added), to_add * sizeof(T_));
         in_mem_size += to_add, added += to_add, rem_sz -= to_add;
 
-        assert(in_mem_size <= max_buf_elems);
-        if(in_mem_size == max_buf_elems)
-            flush();
+        assert(in_mem_size <= buf_cap());
+        if(in_mem_size == buf_cap())
+            make_space();
     }
 
     size_ += sz;
@@ -186,24 +210,51 @@ inline void Ext_Mem_Bucket<T_>::emplace(Args&&... args)
     in_mem_size++;
     size_++;
 
-    assert(in_mem_size <= max_buf_elems);
-    if(in_mem_size == max_buf_elems)
+    assert(in_mem_size <= buf_cap());
+    if(in_mem_size == buf_cap())
+        make_space();
+}
+
+
+template <typename T_>
+inline void Ext_Mem_Bucket<T_>::make_space()
+{
+    if(on_disk || buf.capacity() >= max_mem_elems)
+    {
         flush();
+        return;
+    }
+
+    Buffer<T_> b(std::min(2 * buf.capacity(), max_mem_elems));
+    std::memcpy(reinterpret_cast<char*>(b.data()), reinterpret_cast<const char*>(buf.data()), in_mem_size * sizeof(T_));
+    std::swap(buf, b);
 }
 
 
 template <typename T_>
 inline void Ext_Mem_Bucket<T_>::flush()
 {
-    assert(in_mem_size <= max_buf_elems);
+    assert(in_mem_size <= buf_cap());
 
-    file.write(reinterpret_cast<const char*>(buf.data()), in_mem_size * sizeof(T_));
-    if(!file)
+    if(!on_disk)
     {
-        std::cerr << "Error writing to external-memory bucket at " << file_path << ". Aborting.\n";
-        std::exit(EXIT_FAILURE);
+        file.open(file_path);
+        on_disk = true;
+    }
+
+    // The writer returns once the previous flush has completed, so the
+    // buffers can be swapped.
+    file.write(buf.data(), in_mem_size * sizeof(T_));
+    if(buf.capacity() > max_buf_elems)  // The buffer grown before the first spill is released once written.
+    {
+        file.sync();
+        buf.free();
     }
 
+    if(flush_buf.capacity() < max_buf_elems)
+        flush_buf.resize_uninit(max_buf_elems);
+
+    std::swap(buf, flush_buf);
     in_mem_size = 0;
 }
 
@@ -211,17 +262,28 @@ inline void Ext_Mem_Bucket<T_>::flush()
 template <typename T_>
 inline void Ext_Mem_Bucket<T_>::serialize()
 {
+    if(!on_disk)
+    {
+        flush_buf.free();
+
+        Buffer<T_> b;
+        if(in_mem_size > 0)
+        {
+            b.resize_uninit(in_mem_size);
+            std::memcpy(reinterpret_cast<char*>(b.data()), reinterpret_cast<const char*>(buf.data()), in_mem_size * sizeof(T_));
+        }
+
+        std::swap(buf, b);
+        return;
+    }
+
     if(in_mem_size != 0)
         flush();
 
-    buf.free();
-
     file.close();
-    if(!file)
-    {
-        std::cerr << "Error closing external-memory bucket at " << file_path << ". Aborting.\n";
-        std::exit(EXIT_FAILURE);
-    }
+
+    buf.free();
+    flush_buf.free();
 }
 
 
@@ -229,10 +291,16 @@ template <typename T_>
 inline std::size_t Ext_Mem_Bucket<T_>::load(T_* b) const
 {
     const auto file_sz = (size_ - in_mem_size) * sizeof(T_);
-    assert(file_sz <= file_size(file_path));
-    load_file(file_path, file_sz, reinterpret_cast<char*>(b));
+    if(on_disk)
+    {
+        file.sync();
+        assert(file_sz <= file_size(file_path));
+        load_file(file_path, file_sz, reinterpret_cast<char*>(b));
+    }
+    else
+        assert(file_sz == 0);
 
-    assert(in_mem_size < max_buf_elems);
+    assert(in_mem_size <= buf.capacity());
     if(in_mem_size > 0)
         std::memcpy(reinterpret_cast<char*>(b) + file_sz, reinterpret_cast<const char*>(buf.data()), in_mem_size * sizeof(T_));
 
@@ -245,17 +313,19 @@ inline void Ext_Mem_Bucket<T_>::clear()
 {
     size_ = 0;
     in_mem_size = 0;
-    file.seekp(std::ios_base::beg);
+    file.rewind();
 }
 
 
 template <typename T_>
 inline void Ext_Mem_Bucket<T_>::remove()
 {
-    if(!file_path.empty())
+    if(on_disk)
     {
-        file.close();
-        if(!file || !remove_file(file_path))
+        if(file.is_open())  // The bucket may have been serialized already.
+            file.close();
+
+        if(!remove_file(file_path))
         {
             std::cerr << "Error removing file at " << file_path << ". Aborting.\n";
             std::exit(EXIT_FAILURE);
@@ -263,13 +333,14 @@ inline void Ext_Mem_Bucket<T_>::remove()
     }
 
     buf.free();
+    flush_buf.free();
 }
 
 
 template <typename T_>
 inline std::size_t Ext_Mem_Bucket<T_>::RSS() const
 {
-    return max_buf_elems * sizeof(T_);
+    return (buf.capacity() + flush_buf.capacity()) * sizeof(T_);
 }
 
 
@@ -277,7 +348,8 @@ template <typename T_>
 template <typename T_archive_>
 inline void Ext_Mem_Bucket<T_>::save(T_archive_& archive) const
 {
-    archive(file_path, max_buf_bytes, max_buf_elems, buf, size_, in_mem_size);
+    file.sync();
+    archive(file_path, max_buf_bytes, max_buf_elems, max_mem_elems, buf, size_, in_mem_size, on_disk);
 }
 
 
@@ -285,20 +357,16 @@ template <typename T_>
 template <typename T_archive_>
 inline void Ext_Mem_Bucket<T_>::load(T_archive_& archive)
 {
-    archive(type::mut_ref(file_path), type::mut_ref(max_buf_bytes), type::mut_ref(max_buf_elems),
-            buf, size_, in_mem_size);
+    archive(type::mut_ref(file_path), type::mut_ref(max_buf_bytes), type::mut_ref(max_buf_elems), type::mut_ref(max_mem_elems),
+            buf, size_, in_mem_size, on_disk);
 
 
     assert(file_path.empty() || max_buf_elems > 0);
 
-    if(!file_path.empty())
-        file.open(file_path, std::ios::binary | std::ios::app);
-
-    if(!file)
-    {
-        std::cerr << "Error opening external-memory bucket at " << file_path << ". Aborting.\n";
-        std::exit(EXIT_FAILURE);
-    }
+    // Content past the serialized state may have been written to the file
+    // afterwards, e.g. by an interrupted execution; it is dropped.
+    if(on_disk)
+        file.open(file_path, (size_ - in_mem_size) * sizeof(T_));
 }
 
 
@@ -318,8 +386,10 @@ private:
     std::size_t flushed;    // Number of elements added to the bucket and flushed to external-memory.
 
     std::vector<Padded<std::vector<T_>>> buf_w_local;   // In-memory worker-local buffers of the bucket-elements.
+    std::vector<Padded<std::vector<T_>>> flush_w_local; // In-memory worker-local buffers being flushed.
+    mutable std::vector<Padded<IO_Request>> flush_req;  // Worker-local requests of the pending flushes.
 
-    std::ofstream file; // The bucket-file.
+    int fd; // Descriptor of the bucket-file.
     mutable Spin_Lock lock_;    // Lock to shared resources.
 
     mutable std::vector<Padded<std::ifstream>> read_is; // Worker-local read-input streams.
@@ -328,9 +398,22 @@ private:
 
 
     // Flushes the in-memory buffer content of the invoking worker to external-
-    // memory.
+    // memory. The lock is held only to reserve the range of the bucket-file to
+    // write to, so that workers flushing to the same bucket do not serialize
+    // on the disk-writes. The write is asynchronous, and the worker continues
+    // with its other buffer; it waits only if its previous flush is pending.
     void flush();
 
+    // Waits for the pending flushes of all the workers to complete.
+    void sync() const;
+
+    // Opens the bucket-file; truncates it iff `truncate` is `true`.
+    void open_file(bool truncate);
+
+    // Writes `sz` elements from `buf` at element-offset `off` of the bucket-
+    // file.
+    void write(const T_* buf, std::size_t sz, std::size_t off) const;
+
 
 public:
 
@@ -349,6 +432,8 @@ public:
     Ext_Mem_Bucket_Concurrent& operator=(const Ext_Mem_Bucket_Concurrent&) = delete;
     Ext_Mem_Bucket_Concurrent& operator=(Ext_Mem_Bucket_Concurrent&&) = delete;
 
+    ~Ext_Mem_Bucket_Concurrent();
+
     // Returns the size of the bucket. It is exact only when the bucket is not
     // being updated. Otherwise it is not necessarily exact and runs the risk
     // of data races.
@@ -410,6 +495,9 @@ inline Ext_Mem_Bucket_Concurrent<T_>::Ext_Mem_Bucket_Concurrent(const std::strin
     , max_buf_elems(max_buf_bytes / sizeof(T_))
     , flushed(0)
     , buf_w_local(parlay::num_workers())
+    , flush_w_local(parlay::num_workers())
+    , flush_req(parlay::num_workers())
+    , fd(-1)
     , read_is(parlay::num_workers())
     , read(0)
     , read_bufs_pending(true)
@@ -417,13 +505,7 @@ inline Ext_Mem_Bucket_Concurrent<T_>::Ext_Mem_Bucket_Concurrent(const std::strin
     assert(file_path.empty() || max_buf_elems > 0);
 
     if(!file_path.empty())
-        file.open(file_path, std::ios::out | std::ios::binary);
-
-    if(!file)
-    {
-        std::cerr << "Error opening concurrent external-memory bucket at " << file_path << ". Aborting.\n";
-        std::exit(EXIT_FAILURE);
-    }
+        open_file(true);
 
 
     std::for_each(buf_w_local.begin(), buf_w_local.end(), [&](auto& v){ v.unwrap().reserve(max_buf_elems); });
@@ -437,11 +519,58 @@ inline Ext_Mem_Bucket_Concurrent<T_>::Ext_Mem_Bucket_Concurrent(Ext_Mem_Bucket_C
     , max_buf_elems(std::move(rhs.max_buf_elems))
     , flushed(std::move(rhs.flushed))
     , buf_w_local(std::move(rhs.buf_w_local))
-    , file(std::move(rhs.file))
+    , flush_w_local(std::move(rhs.flush_w_local))
+    , flush_req(std::move(rhs.flush_req))
+    , fd(rhs.fd)
     , read_is(std::move(rhs.read_is))
     , read(std::move(rhs.read))
     , read_bufs_pending(std::move(rhs.read_bufs_pending))
-{}
+{
+    rhs.fd = -1;
+}
+
+
+template <typename T_>
+inline Ext_Mem_Bucket_Concurrent<T_>::~Ext_Mem_Bucket_Concurrent()
+{
+    if(fd >= 0)
+    {
+        sync();
+        ::close(fd);
+    }
+}
+
+
+template <typename T_>
+inline void Ext_Mem_Bucket_Concurrent<T_>::open_file(const bool truncate)
+{
+    fd = ::open(file_path.c_str(), O_WRONLY | O_CREAT | (truncate ? O_TRUNC : 0), 0644);
+    if(fd < 0)
+    {
+        std::cerr << "Error opening concurrent external-memory bucket at " << file_path << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+}
+
+
+template <typename T_>
+inline void Ext_Mem_Bucket_Concurrent<T_>::write(const T_* const buf, const std::size_t sz, const std::size_t off) const
+{
+    auto b = reinterpret_cast<const char*>(buf);
+    std::size_t rem = sz * sizeof(T_);
+    off_t pos = off * sizeof(T_);
+    while(rem > 0)
+    {
+        const auto w = ::pwrite(fd, b, rem, pos);
+        if(w <= 0)
+        {
+            std::cerr << "Error writing to external-memory bucket at " << file_path << ". Aborting.\n";
+            std::exit(EXIT_FAILURE);
+        }
+
+        b += w, rem -= w, pos += w;
+    }
+}
 
 
 template <typename T_>
@@ -482,6 +611,9 @@ inline void Ext_Mem_Bucket_Concurrent<T_>::emplace(Args&&... args)
 template <typename T_>
 inline void Ext_Mem_Bucket_Concurrent<T_>::close()
 {
+    sync();
+    std::for_each(flush_w_local.begin(), flush_w_local.end(), [](auto& w_buf){ force_free(w_buf.unwrap()); });
+
     std::size_t in_mem = 0;
     for(std::size_t w = 0; w < buf_w_local.size(); ++w)
         in_mem += buf_w_local[w].unwrap().size();
@@ -497,13 +629,7 @@ inline void Ext_Mem_Bucket_Concurrent<T_>::close()
         force_free(b);
     }
 
-    file.write(reinterpret_cast<const char*>(buf.data()), buf.size() * sizeof(T_));
-    if(!file)
-    {
-        std::cerr << "Error writing to external-memory bucket at " << file_path << ". Aborting.\n";
-        std::exit(EXIT_FAILURE);
-    }
-
+    write(buf.data(), buf.size(), flushed);
     flushed += buf.size();
 
     buf.clear();
@@ -521,26 +647,47 @@ inline void Ext_Mem_Bucket_Concurrent<T_>::flush()
         return;
 
     lock_.lock();
+    const auto off = flushed;
+    flushed += buf.size();
+    lock_.unlock();
 
-    // TODO: use async-write.
-    file.write(reinterpret_cast<const char*>(buf.data()), buf.size() * sizeof(T_));
-    if(!file)
+    auto& io = Async_IO::get();
+    auto& req = flush_req[parlay::worker_id()].unwrap();
+    if(!io.wait(req))
     {
         std::cerr << "Error writing to external-memory bucket at " << file_path << ". Aborting.\n";
         std::exit(EXIT_FAILURE);
     }
 
-    flushed += buf.size();
-
-    lock_.unlock();
+    io.write(req, fd, buf.data(), buf.size() * sizeof(T_), off * sizeof(T_));
 
+    // The other buffer's flush has completed; swapping the buffers keeps the
+    // one being written to untouched.
+    auto& flush_buf = flush_w_local[parlay::worker_id()].unwrap();
+    std::swap(buf, flush_buf);
     buf.clear();
+    buf.reserve(max_buf_elems);
+}
+
+
+template <typename T_>
+inline void Ext_Mem_Bucket_Concurrent<T_>::sync() const
+{
+    auto& io = Async_IO::get();
+    for(auto& req : flush_req)
+        if(!io.wait(req.unwrap()))
+        {
+            std::cerr << "Error writing to external-memory bucket at " << file_path << ". Aborting.\n";
+            std::exit(EXIT_FAILURE);
+        }
 }
 
 
 template <typename T_>
 inline void Ext_Mem_Bucket_Concurrent<T_>::load(std::vector<T_>& v) const
 {
+    sync();
+
     const auto sz = size();
     v.resize(sz);
 
@@ -566,6 +713,8 @@ inline void Ext_Mem_Bucket_Concurrent<T_>::load(std::vector<T_>& v) const
 template <typename T_>
 inline std::size_t Ext_Mem_Bucket_Concurrent<T_>::load(T_* b) const
 {
+    sync();
+
     std::size_t sz = flushed;
 
     // Load from the bucket-file.
@@ -595,6 +744,8 @@ inline std::size_t Ext_Mem_Bucket_Concurrent<T_>::read_buffered(Buffer<T_>& buf,
 {
     assert(buf.capacity() >= n);
 
+    sync();
+
     lock_.lock();
     assert(read <= flushed);
     const auto read_off = read; // Offset to read from the file.
@@ -664,10 +815,13 @@ inline void Ext_Mem_Bucket_Concurrent<T_>::reset_read()
 template <typename T_>
 inline void Ext_Mem_Bucket_Concurrent<T_>::remove()
 {
+    sync();
+
     if(!file_path.empty())
     {
-        file.close();
-        if(!file || !remove_file(file_path))
+        const auto closed = (fd < 0 || ::close(fd) == 0);
+        fd = -1;
+        if(!closed || !remove_file(file_path))
         {
             std::cerr << "Error removing file at " << file_path << ". Aborting.\n";
             std::exit(EXIT_FAILURE);
@@ -676,6 +830,7 @@ inline void Ext_Mem_Bucket_Concurrent<T_>::remove()
 
 
     std::for_each(buf_w_local.begin(), buf_w_local.end(), [](auto& w_buf){ force_free(w_buf.unwrap()); });
+    std::for_each(flush_w_local.begin(), flush_w_local.end(), [](auto& w_buf){ force_free(w_buf.unwrap()); });
 }
 
 
@@ -684,6 +839,7 @@ inline std::size_t Ext_Mem_Bucket_Concurrent<T_>::RSS() const
 {
     std::size_t buf_bytes = 0;
     std::for_each(buf_w_local.cbegin(), buf_w_local.cend(), [&](const auto& b){ buf_bytes += b.unwrap().capacity() * sizeof(T_); });
+    std::for_each(flush_w_local.cbegin(), flush_w_local.cend(), [&](const auto& b){ buf_bytes += b.unwrap().capacity() * sizeof(T_); });
 
     return buf_bytes;
 }
@@ -693,6 +849,7 @@ template <typename T_>
 template <typename T_archive_>
 inline void Ext_Mem_Bucket_Concurrent<T_>::save(T_archive_& archive) const
 {
+    sync();
     archive(file_path, max_buf_bytes, max_buf_elems, flushed, buf_w_local);
 }
 
@@ -707,12 +864,18 @@ inline void Ext_Mem_Bucket_Concurrent<T_>::load(T_archive_& archive)
     assert(file_path.empty() || max_buf_elems > 0);
 
     if(!file_path.empty())
-        file.open(file_path, std::ios::binary | std::ios::app);
-
-    if(!file)
     {
-        std::cerr << "Error opening concurrent external-memory bucket at " << file_path << ". Aborting.\n";
-        std::exit(EXIT_FAILURE);
+        open_file(false);
+
+        // Content past the serialized state may have been written to the file
+        // afterwards, e.g. by an interrupted execution; it is dropped.
+        const off_t bytes = flushed * sizeof(T_);
+        struct stat st;
+        if(::fstat(fd, &st) != 0 || (st.st_size > bytes && ::ftruncate(fd, bytes) != 0))
+        {
+            std::cerr << "Error restoring concurrent external-memory bucket at " << file_path << ". Aborting.\n";
+            std::exit(EXIT_FAILURE);
+        }
     }
 }
 
@@ -5,6 +5,7 @@
 
 
 #include "Color_Encoding.hpp"
+#include "Binary_Unitig_Format.hpp"
 #include "fmt/format.h"
 
 #include <cstdint>
@@ -71,6 +72,12 @@ public:
     // Returns the length of the sequence of the record.
     std::size_t seq_size() const { return (seq_.size() - offset_) + (!seq_add_.empty() ? (seq_add_.size() - offset_add_) : 0); }
 
+    // Returns the sequence of the record, excluding the additional sequence.
+    std::string_view seq() const { return seq_.substr(offset_); }
+
+    // Returns the additional sequence of the record.
+    std::string_view seq_add() const { return !seq_add_.empty() ? seq_add_.substr(offset_add_) : std::string_view(); }
+
     // Returns the size of the color-list.
     std::size_t color_list_size() const { assert(color_ != nullptr); return color_->size(); }
 
@@ -89,6 +96,13 @@ public:
 
     // Appends the color-list to the `buf`.
     void append_color_list(std::string& buf) const;
+
+    // Returns the size of the record in the binary unitig format.
+    std::size_t binary_size() const;
+
+    // Appends the record in the binary unitig format to `buf`, along with the
+    // color-list if present. The identifier is not retained.
+    void append_binary(std::string& buf) const;
 };
 
 
@@ -159,4 +173,17 @@ inline void FASTA_Record::append_color_list(std::string& buf) const
 
 
 
+inline std::size_t FASTA_Record::binary_size() const
+{
+    return cuttlefish::Binary_Unitig_Format::record_size(seq_size(), color_ != nullptr ? color_->size() : 0);
+}
+
+
+inline void FASTA_Record::append_binary(std::string& buf) const
+{
+    cuttlefish::Binary_Unitig_Format::append_record(buf, seq(), seq_add(),
+        color_ != nullptr ? color_->data() : nullptr, color_ != nullptr ? color_->size() : 0);
+}
+
+
 #endif
@@ -34,7 +34,13 @@ namespace cuttlefish
         constexpr char vertex_p_inf_bucket_ext[] = "_P_v";
         constexpr char edge_p_inf_bucket_ext[] = "_P_e";
         constexpr char unitig_coord_bucket_ext[] = "_U";
+        constexpr char unitig_end_bucket_ext[] = "_U_end";
+        constexpr char path_cover_seg_ext[] = "_cover_seg";
         constexpr char color_rel_bucket_ext[] = "_C_rel";
+        constexpr char phase_manifest_ext[] = "_phases.json";
+        constexpr char checkpoint_ext[] = "_ckpt";
+        constexpr char bin_ext[] = ".cfb";
+        constexpr char gzip_ext[] = ".gz";
 
 
         // For k-mer index.
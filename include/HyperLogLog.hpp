@@ -10,7 +10,10 @@
 #include <cstdint>
 #include <cstddef>
 #include <vector>
+#include <utility>
+#include <algorithm>
 #include <cmath>
+#include <cassert>
 
 
 namespace cuttlefish
@@ -20,6 +23,8 @@ namespace cuttlefish
 // A class to estimate the cardinality of a data stream in parallel at accuracy
 // i.e. SD 4.6%, with the HyperLogLog algorithm. Data must be provided as a
 // stream of its hashes, which must be uniform for the accuracy bound to hold.
+// The estimator either keeps a register-set per worker, or a single one shared
+// by all the workers.
 class HyperLogLog
 {
 
@@ -31,29 +36,59 @@ private:
 
     std::vector<Padded<uint8_t[m]>> M_w;    // `M_w[i]` contains the 'log'-registers for worker `i`.
 
+    // Returns the register-index and the register-value for the 32-bit hash `h`.
+    static std::pair<uint32_t, uint8_t> reg(uint32_t h);
+
 
 public:
 
-    // Constructs a Hyperloglog cardinality-estimator.
-    HyperLogLog();
+    // Constructs a Hyperloglog cardinality-estimator. If `shared` is `true`,
+    // a single register-set is shared by all the workers.
+    HyperLogLog(bool shared = false);
 
-    // Adds the 32-bit hash `h` of a data item to the estimator.
+    // Adds the 32-bit hash `h` of a data item to the estimator. Must not be
+    // used if the register-set is shared.
     void add(uint32_t h);
 
+    // Adds the 32-bit hash `h` of a data item to the estimator with a shared
+    // register-set. Updates racing on a register may be lost, which only
+    // affects the estimate marginally.
+    void add_shared(uint32_t h);
+
     // Returns the cardinality estimation of the added stream of hashes.
     uint64_t estimate() const;
 };
 
 
-inline void HyperLogLog::add(const uint32_t h)
+inline std::pair<uint32_t, uint8_t> HyperLogLog::reg(const uint32_t h)
 {
     constexpr auto substream_mask = m - 1;
 
     const auto stream = h & substream_mask;
     const auto h_proxy = h >> log_m;
     const auto tz = (h_proxy != 0 ? __builtin_ctz(h_proxy) : 32);
+    return {stream, static_cast<uint8_t>(1 + tz)};
+}
+
+
+inline void HyperLogLog::add(const uint32_t h)
+{
+    assert(M_w.size() == parlay::num_workers());
+
+    const auto [stream, val] = reg(h);
     auto& M = M_w[parlay::worker_id()].unwrap();
-    M[stream] = std::max(M[stream], static_cast<uint8_t>(1 + tz));
+    M[stream] = std::max(M[stream], val);
+}
+
+
+inline void HyperLogLog::add_shared(const uint32_t h)
+{
+    assert(M_w.size() == 1);
+
+    const auto [stream, val] = reg(h);
+    auto const r = M_w.front().unwrap() + stream;
+    if(__atomic_load_n(r, __ATOMIC_RELAXED) < val)
+        __atomic_store_n(r, val, __ATOMIC_RELAXED);
 }
 
 }
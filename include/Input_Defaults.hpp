@@ -32,7 +32,7 @@ namespace cuttlefish
         constexpr uint16_t MIN_LEN = 20;    // TODO: placeholder for now.
 
 
-        constexpr std::size_t SUBGRAPH_COUNT = 8192;
+        constexpr std::size_t SUBGRAPH_COUNT = 0;   // Chosen at runtime per the input size and the thread count.
         constexpr std::size_t VERTEX_PART_COUNT = 64;
         constexpr std::size_t LMTIG_BUCKET_COUNT = 1024;
         constexpr std::size_t GMTIG_BUCKET_COUNT = 1024;
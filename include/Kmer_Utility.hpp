@@ -7,6 +7,7 @@
 #include "DNA_Utility.hpp"
 
 #include <cstdint>
+#include <cstddef>
 
 
 class Kmer_Utility
@@ -77,6 +78,17 @@ public:
     template <uint16_t k>
     static uint64_t encode_checked(const char* label);
 
+    // Encodes the literal label `label` of `32 * word_c` bases into `word_c`
+    // binary encoding words at `words`, in reverse: its `i`'th 32-base block
+    // is encoded into `words[word_c - 1 - i]`, as per `encode_checked<32>`.
+    // Placeholder bases do not affect the encoding of the valid bases. The
+    // encoding is vectorized per the instruction sets supported by the CPU.
+    static void encode_checked_words(const char* label, std::size_t word_c, uint64_t* words);
+
+    // Encodes the literal label `label` just as `encode_checked_words`, one
+    // base at a time.
+    static void encode_checked_words_scalar(const char* label, std::size_t word_c, uint64_t* words);
+
     // Returns the base-reversed representation of the `B`-base (DNA) binary
     // representation of `val`: if `val` represents `b_{B - 1} ... b_1 b_0`,
     // then returns `b_0 b_1 ... b_{B - 1}`.
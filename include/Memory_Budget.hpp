@@ -0,0 +1,89 @@
+#ifndef MEMORY_BUDGET_HPP
+#define MEMORY_BUDGET_HPP
+
+
+
+#include <cstdint>
+#include <cstddef>
+
+
+class Build_Params;
+
+
+namespace cuttlefish
+{
+
+// =============================================================================
+// Memory governor for the stages of the compacted de Bruijn graph construction.
+// The user-provided memory limit is divided among the stages as per fixed
+// shares, and each stage sizes its buffers and throttles its concurrency to
+// stay within its share. If the limit is not strict, the governor only reports
+// and never shrinks the preferred configurations.
+class Memory_Budget
+{
+public:
+
+    // Stages of the construction algorithm.
+    enum class Stage : uint8_t
+    {
+        partition,  // Partitioning the input sequences into subgraphs.
+        subgraphs,  // Constructing and contracting the subgraphs.
+        contract,   // Contracting the discontinuity graph.
+        expand,     // Expanding the contracted discontinuity graph.
+        collate,    // Collating the locally-maximal unitigs.
+    };
+
+private:
+
+    const std::size_t total_bytes_; // Total memory budget in bytes.
+    const bool strict_; // Whether the budget is to be strictly enforced.
+
+    static constexpr std::size_t stage_count = 5;   // Number of stages.
+
+    // Fractions of the total budget usable by the governed components of each
+    // stage, indexed by `Stage`. The rest of the budget of a stage is kept for
+    // its ungoverned components, e.g. the parser and the output buffers.
+    static constexpr double share[stage_count] = {0.50, 0.90, 0.90, 0.90, 0.75};
+
+
+public:
+
+    // Constructs a memory governor with a budget of `max_memory` GB. If
+    // `strict` is `true`, the budget is enforced.
+    Memory_Budget(std::size_t max_memory, bool strict);
+
+    // Constructs a memory governor from the parameters wrapped in `params`.
+    // The budget is enforced only if a memory limit is explicitly specified.
+    Memory_Budget(const Build_Params& params);
+
+    // Returns the total memory budget in bytes.
+    auto total_bytes() const { return total_bytes_; }
+
+    // Returns whether the budget is strictly enforced.
+    auto strict() const { return strict_; }
+
+    // Returns the memory budget in bytes for the governed components of stage
+    // `s`.
+    std::size_t stage_bytes(Stage s) const;
+
+    // Returns the size in bytes of each of `count` buffers in stage `s`, such
+    // that these and `reserved` bytes from other components of the stage fit
+    // within its budget. The buffers have a preferred size of `pref_bytes` and
+    // are not shrunk below `min_bytes`.
+    std::size_t buffer_bytes(Stage s, std::size_t pref_bytes, std::size_t count, std::size_t min_bytes, std::size_t reserved = 0) const;
+
+    // Returns the number of workers in stage `s` that may run simultaneously,
+    // each requiring `per_worker_bytes` bytes, such that their total and
+    // `reserved` bytes from other components of the stage fit within its
+    // budget. At least one worker is always allowed.
+    std::size_t worker_count(Stage s, std::size_t per_worker_bytes, std::size_t reserved = 0) const;
+
+    // Returns the name of the stage `s`.
+    static const char* name(Stage s);
+};
+
+}
+
+
+
+#endif
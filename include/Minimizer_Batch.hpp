@@ -0,0 +1,85 @@
+
+#ifndef MINIMIZER_BATCH_HPP
+#define MINIMIZER_BATCH_HPP
+
+
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <cassert>
+
+
+// =============================================================================
+// A class to compute the canonical `l`-minimizer hashes of all the constituent
+// `k`-mers of a sequence, in batches of consecutive k-mers. For a batch, the
+// forward and the reverse-complement l-mers are packed first, then hashed in
+// bulk—with SIMD where the CPU supports it—and then the window-minima of the
+// hashes are found with a branch-free sliding-min. The hashes are identical to
+// those of `Min_Iterator`, and hence so are the super k-mer boundaries.
+class Minimizer_Batch
+{
+private:
+
+    static constexpr std::size_t batch_sz = 1024;   // Number of k-mers per batch.
+
+    const uint16_t k;   // Size of the k-mers.
+    const uint16_t l;   // Size of the minimizers.
+    const std::size_t w;    // Number of l-mers in a k-mer, i.e. the sliding-window size.
+    const uint64_t lmer_mask;   // Bitmask to clear the bits beyond an l-mer in a 64-bit word.
+
+    const char* seq;    // The sequence being iterated over.
+    std::size_t kmer_c; // Number of k-mers in the sequence.
+    std::size_t batch_beg;  // Index of the first k-mer in the current batch.
+    std::size_t batch_end;  // Non-inclusive index of the last k-mer in the current batch.
+
+    std::vector<uint64_t> lmer_f;   // Forward l-mers of the current batch.
+    std::vector<uint64_t> lmer_r;   // Reverse-complement l-mers of the current batch.
+    std::vector<uint64_t> H;    // Canonical hashes of the l-mers of the current batch.
+    std::vector<uint64_t> M;    // Minimizer hashes of the k-mers of the current batch.
+    std::vector<uint64_t> T[2]; // Scratch space for the doubling passes of the sliding-min.
+
+
+    // Computes the minimizer hashes of the batch of k-mers starting at the
+    // `b`'th k-mer.
+    void compute_batch(std::size_t b);
+
+public:
+
+    // Constructs a batch minimizer engine for the `l`-minimizers of `k`-mers.
+    Minimizer_Batch(uint16_t k, uint16_t l);
+
+    // Resets the engine to the sequence `seq` of length `len`. `seq` should
+    // consist of only DNA bases, and have at least one k-mer.
+    void reset(const char* seq, std::size_t len);
+
+    // Returns the number of k-mers in the sequence.
+    auto kmer_count() const { return kmer_c; }
+
+    // Returns the 64-bit hash of the minimizer of the `i`'th k-mer of the
+    // sequence. The k-mers should be queried in non-decreasing order of `i`.
+    uint64_t hash(std::size_t i);
+
+    // Puts the canonical hashes of the `n` l-mer pairs `(f[i], r[i])` into
+    // `h[i]`, dispatching to the best kernel for the CPU.
+    static void hash_lmers(const uint64_t* f, const uint64_t* r, std::size_t n, uint64_t* h);
+
+    // Puts the canonical hashes of the `n` l-mer pairs `(f[i], r[i])` into
+    // `h[i]`, without vectorization.
+    static void hash_lmers_scalar(const uint64_t* f, const uint64_t* r, std::size_t n, uint64_t* h);
+};
+
+
+inline uint64_t Minimizer_Batch::hash(const std::size_t i)
+{
+    assert(i >= batch_beg && i < kmer_c);
+
+    if(i >= batch_end)
+        compute_batch(i);
+
+    return M[i - batch_beg];
+}
+
+
+
+#endif
@@ -20,13 +20,11 @@ template <typename T_seq_, uint16_t k, bool is_canonical_> class Minimizer_Itera
 class Minimizer_Utility
 {
 
-private:
+public:
 
-    // Salt for `wyhash`.
+    // Salt for `wyhash`. Also used by the vectorized l-mer hashers.
     static constexpr uint64_t wy_salt[4] = {4167021922371662411llu, 7320285940802167691llu, 14307255741305819987llu, 10859488101230029397llu};
 
-public:
-
     // Returns the hash value of the l-mer `lmer`. The seed-value `seed` is used
     // in hashing.
     static uint64_t hash(cuttlefish::minimizer_t lmer, uint64_t seed = 0);
@@ -16,6 +16,7 @@ namespace cuttlefish
         gfa1 = 1,
         gfa2 = 2,
         gfa_reduced = 3,
+        bin = 4,
         num_op_formats
     };
 }
@@ -5,6 +5,7 @@
 
 
 #include "Async_Logger_Wrapper.hpp"
+#include "Streaming_File_Sink.hpp"
 #include "spdlog/spdlog.h"
 
 #include <fstream>
@@ -74,5 +75,32 @@ public:
 };
 
 
+template <>
+class Output_Sink<Streaming_File_Sink>
+{
+private:
+
+    Streaming_File_Sink output_;
+
+
+public:
+
+    void init_sink(const std::string& output_file_path, const bool bgzf = false)
+    {
+        output_.open(output_file_path, bgzf);
+    }
+
+    Streaming_File_Sink& sink()
+    {
+        return output_;
+    }
+
+    void close_sink(const bool final = true)
+    {
+        output_.close(final);
+    }
+};
+
+
 
 #endif
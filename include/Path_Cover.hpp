@@ -0,0 +1,92 @@
+
+#ifndef PATH_COVER_HPP
+#define PATH_COVER_HPP
+
+
+
+#include "Unitig_Links.hpp"
+#include "Character_Buffer.hpp"
+#include "Streaming_File_Sink.hpp"
+#include "Output_Format.hpp"
+#include "utility.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+namespace cuttlefish
+{
+
+// =============================================================================
+// Maximal path cover of the compacted de Bruijn graph of `k`-mers, i.e. a
+// spectrum-preserving string set: the maximal unitigs are glued into paths
+// over their `(k - 1)`-mer overlaps, such that each unitig is in exactly one
+// path and no two paths can be joined. Each `k`-mer of the graph is spelled
+// exactly once by the paths. The unitigs are to be staged as GFA segments, and
+// registered with a unitig-link tracker.
+template <uint16_t k>
+class Path_Cover
+{
+private:
+
+    typedef Character_Buffer<Streaming_File_Sink> op_buf_t;
+
+    const Unitig_Links<k>& links;   // Links between the unitigs.
+    const std::string seg_path; // Path to the file of the staged unitig segments.
+
+    std::vector<uint64_t> M;    // `M[e]` is the unitig-end matched with the end `e`; see `Unitig_Links::match`.
+    std::vector<uint64_t> off;  // `off[u]` is the offset of the label of the unitig `u` in the segment file.
+    std::vector<uint8_t> covered;   // `covered[u]` is whether the unitig `u` is in a path extracted already.
+
+    const char* seg;    // The memory-mapped segment file.
+    std::size_t seg_sz; // Size of the segment file in bytes.
+
+    std::atomic_uint64_t path_c;    // Number of the extracted paths.
+    std::atomic_uint64_t cycle_c;   // Number of the extracted paths that are cycles.
+
+
+    // Maps the segment file and indexes the labels of the unitigs in it.
+    void index_segments();
+
+    // Returns the label of the unitig `u`.
+    std::string_view label(uint64_t u) const;
+
+    // Returns the unitig-end through which the path traversal entering the
+    // path through the end `e` exits the path.
+    uint64_t exit_end(uint64_t e) const;
+
+    // Appends the path traversed entering it through the end `e` as a record
+    // to `op`, with its label built in `buf`.
+    void extract_path(uint64_t e, std::string& buf, op_buf_t& op);
+
+
+public:
+
+    // Constructs a path cover over the unitigs registered with `links`, with
+    // their segments staged at the file `seg_path`.
+    Path_Cover(const Unitig_Links<k>& links, const std::string& seg_path);
+
+    Path_Cover(const Path_Cover&) = delete;
+    Path_Cover& operator=(const Path_Cover&) = delete;
+
+    ~Path_Cover();
+
+    // Extracts the path cover to `sink`, as records in the format `format`.
+    void extract(Streaming_File_Sink& sink, Output_Format format);
+
+    // Returns the number of the extracted paths.
+    uint64_t path_count() const { return path_c; }
+
+    // Returns the number of the extracted paths that are cycles.
+    uint64_t cycle_count() const { return cycle_c; }
+};
+
+}
+
+
+
+#endif
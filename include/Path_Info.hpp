@@ -69,6 +69,9 @@ public:
 
     // Returns a 64-bit hash value of the path-information.
     uint64_t hash() const { return XXH3_64bits(&p_, sizeof(p_)) ^ XXH3_64bits(&r_, sizeof(r_)) ^ XXH3_64bits(&o_, sizeof(o_)); }
+
+    // (De)serializes the information from / to the `cereal` archive `archive`.
+    template <typename T_archive_> void serialize(T_archive_& archive) { archive(p_, r_, o_, is_cycle_); }
 };
 
 
@@ -111,6 +114,9 @@ public:
 
     // Returns `true` iff this information is the same as in `rhs`.
     bool operator==(const Obj_Path_Info_Pair& rhs) const { return obj_ == rhs.obj_ && path_info_ == rhs.path_info_; }
+
+    // (De)serializes the pair from / to the `cereal` archive `archive`.
+    template <typename T_archive_> void serialize(T_archive_& archive) { archive(obj_, path_info_); }
 };
 
 }
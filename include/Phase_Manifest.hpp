@@ -0,0 +1,90 @@
+#ifndef PHASE_MANIFEST_HPP
+#define PHASE_MANIFEST_HPP
+
+
+
+#include "nlohmann/json.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+
+class Build_Params;
+
+
+namespace cuttlefish
+{
+
+// =============================================================================
+// Manifest of the completed phases of a compacted de Bruijn graph construction,
+// kept in the working directory so that an interrupted construction can be
+// resumed from its last completed phase. The manifest also records the
+// construction configuration, and is only usable by a construction with the
+// same configuration.
+class Phase_Manifest
+{
+public:
+
+    // Checkpointed phases of the construction, in their execution order.
+    enum class Phase : uint8_t
+    {
+        none,       // No phase has been completed.
+        subgraphs,  // The subgraphs have been constructed and contracted.
+        contract,   // The discontinuity graph has been contracted.
+        expand,     // The contracted discontinuity graph has been expanded.
+        collate,    // The maximal unitigs have been collated; i.e. the construction is complete.
+    };
+
+private:
+
+    const std::string file_path_;   // Path to the disk-file of the manifest.
+    const nlohmann::ordered_json config;    // Configuration of the construction.
+
+    Phase phase_;   // Last completed phase.
+    uint64_t output_bytes_; // Size of the output file at the completion of the last phase.
+
+    static constexpr const char* config_field = "configuration";    // Header for the construction configuration.
+    static constexpr const char* phase_field = "completed phase";   // Header for the last completed phase.
+    static constexpr const char* output_field = "output bytes"; // Header for the output size.
+
+
+    // Returns the configuration of the construction with the parameters
+    // `params` with `graph_count` subgraphs.
+    static nlohmann::ordered_json configuration(const Build_Params& params, uint64_t graph_count);
+
+
+public:
+
+    // Constructs a manifest at the file `file_path` for a construction with
+    // the parameters `params` with `graph_count` subgraphs. No phase is marked
+    // to be completed.
+    Phase_Manifest(const std::string& file_path, const Build_Params& params, uint64_t graph_count);
+
+    // Returns the path to the disk-file of the manifest.
+    const std::string& file_path() const { return file_path_; }
+
+    // Returns the last completed phase.
+    auto phase() const { return phase_; }
+
+    // Returns the size of the output file at the completion of the last phase.
+    auto output_bytes() const { return output_bytes_; }
+
+    // Loads the manifest from its disk-file, if it exists, and returns the
+    // last completed phase.
+    Phase load();
+
+    // Marks the phase `p` to be completed with an output file of size
+    // `output_bytes`, and writes the manifest to its disk-file. The file is
+    // replaced atomically.
+    void record(Phase p, uint64_t output_bytes);
+
+    // Returns the name of the phase `p`.
+    static const char* name(Phase p);
+};
+
+}
+
+
+
+#endif
@@ -0,0 +1,39 @@
+
+#ifndef SEGMENT_REGISTRY_HPP
+#define SEGMENT_REGISTRY_HPP
+
+
+
+#include <cstdint>
+#include <string_view>
+
+
+namespace cuttlefish
+{
+
+// =============================================================================
+// Interface to register the output maximal unitigs as segments of a graph
+// output: it identifies the segments, and tracks what is required to connect
+// them. Registration is to be thread-safe.
+class Segment_Registry
+{
+public:
+
+    virtual ~Segment_Registry() = default;
+
+    // Registers the segment with the label `seq` concatenated with `seq_add`,
+    // and returns its identifier.
+    virtual uint64_t add(const std::string_view& seq, const std::string_view& seq_add) = 0;
+
+    // Registers the edges of the graph exiting a segment-end: `end` is the
+    // 2-bit packed k-mer at the end, laid out as `Kmer<k>::data()`, oriented
+    // so that the edges exit through its back; and `edges` is the bit-mask of
+    // the `Base`-encodings of the bases extending `end` into the edges.
+    virtual void add_end_edges(const uint64_t* end, uint8_t edges) = 0;
+};
+
+}
+
+
+
+#endif
@@ -24,6 +24,9 @@ public:
 
     // Releases the lock, giving up the exclusive access to it.
     void unlock();
+
+    // Tries to acquire the lock without waiting. Returns `true` iff acquired.
+    bool try_lock();
 };
 
 
@@ -48,5 +51,11 @@ inline void Spin_Lock::unlock()
 }
 
 
+inline bool Spin_Lock::try_lock()
+{
+    return !lock_.test_and_set(std::memory_order_acquire);
+}
+
+
 
 #endif
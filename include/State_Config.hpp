@@ -11,6 +11,7 @@
 
 #include <cstdint>
 #include <climits>
+#include <algorithm>
 #include <cassert>
 
 
@@ -53,6 +54,13 @@ public:
 
     // Returns the number of edges at side `s` of a corresponding vertex.
     uint32_t edge_count(side_t s) const;
+
+    // Returns the edges passing frequency threshold and incident to the side
+    // `s` of a corresponding vertex, as a bit-mask over their `Base`-encodings.
+    uint8_t edge_mask(side_t s) const;
+
+    // Adds the edge-frequencies of `rhs` to this counter.
+    void merge(const Edge_Frequency& rhs);
 };
 
 
@@ -79,6 +87,10 @@ public:
     // vertex having this neighborhood.
     base_t edge_at(side_t s) const { return e_f.edge_at(s); }
 
+    // Returns the edges incident to the side `s` of a vertex having this
+    // neighborhood, as a bit-mask over their `Base`-encodings.
+    uint8_t edge_mask(side_t s) const { return e_f.edge_mask(s); }
+
     // Returns `true` iff some vertex having this neighborhood is branching
     // (i.e. has multiple incident edges) at its side `s`.
     bool is_branching_side(side_t s) const { return e_f.edge_count(s) > 1; }
@@ -90,6 +102,9 @@ public:
     // Returns `true` iff some vertex having this neighborhood is isolated off
     // the rest of the graph.
     bool is_isolated() const { return is_empty_side(side_t::back) && is_empty_side(side_t::front); }
+
+    // Adds the edges of the neighborhood `rhs` to this neighborhood.
+    void merge(const Vertex_Neighborhood& rhs) { e_f.merge(rhs.e_f); }
 };
 
 
@@ -160,6 +175,14 @@ public:
         update_edges(front, back);
         mark_discontinuous_optional(s_0), mark_discontinuous_optional(s_1);
     }
+
+    // Merges the state `rhs`, built from a disjoint set of super k-mers of the
+    // same vertex, into this state.
+    void merge(const State_Config& rhs)
+    {
+        Vertex_Neighborhood::merge(rhs);
+        status |= rhs.status;
+    }
 };
 
 
@@ -229,6 +252,24 @@ inline uint32_t Edge_Frequency::edge_count(const side_t s) const
 }
 
 
+inline void Edge_Frequency::merge(const Edge_Frequency& rhs)
+{
+    for(uint32_t off = 0; off < 32; off += 4)
+    {
+        const auto f = std::min(f_at(off) + rhs.f_at(off), max_f);
+        e_f = (e_f & ~(max_f << off)) | (f << off);
+    }
+}
+
+
+inline uint8_t Edge_Frequency::edge_mask(const side_t s) const
+{
+    const uint32_t off = (s == side_t::front ? 0 : 16);
+    return  ((f_at(off + 0) >= f_th) << base_t::A) | ((f_at(off + 4) >= f_th) << base_t::C) |
+            ((f_at(off + 8) >= f_th) << base_t::G) | ((f_at(off + 12) >= f_th) << base_t::T);
+}
+
+
 inline base_t Edge_Frequency::edge_at(const side_t s) const
 {
     const uint32_t off = (s == side_t::front ? 0 : 16);
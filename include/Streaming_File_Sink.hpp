@@ -0,0 +1,133 @@
+
+#ifndef STREAMING_FILE_SINK_HPP
+#define STREAMING_FILE_SINK_HPP
+
+
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <sys/types.h>
+
+
+// A sink streaming character buffers to the end of a file from a dedicated
+// writer thread. A buffer is handed over without copying: its content is moved
+// into a slot of a bounded pool, and the index of the slot is passed to the
+// writer thread through a lock-free queue; the submitter gets back the recycled
+// buffer of the slot. The writer thread batches the queued buffers into
+// vectored writes, and returns the slots through another lock-free queue.
+// Submissions from multiple threads can be made concurrently. Waits for a free
+// slot or for a submission back off by yielding and, for the idle writer
+// thread, by short sleeps.
+//
+// Optionally, the file is written in the BGZF format: each submitted buffer is
+// compressed by its submitter into independent gzip members of at most 64 KB,
+// so the compression scales with the submitting threads, and the result is a
+// valid multi-member gzip file that is also indexable as BGZF.
+class Streaming_File_Sink
+{
+private:
+
+    static constexpr std::size_t bufs_per_worker = 4;   // Number of buffers in the pool per worker thread.
+    static constexpr std::size_t max_batch_sz = 256;    // Maximum number of buffers written in one go.
+
+    static constexpr std::size_t bgzf_max_block_sz = 64 * 1024; // Maximum size of a BGZF block.
+    static constexpr std::size_t bgzf_max_input_sz = 0xff00;    // Maximum uncompressed size of a BGZF block, so that it fits a block even if incompressible.
+    static constexpr std::size_t bgzf_header_sz = 18;   // Size of the header of a BGZF block.
+    static constexpr std::size_t bgzf_footer_sz = 8;    // Size of the footer of a BGZF block.
+    static constexpr int bgzf_level = 6;    // Compression level for the BGZF blocks.
+
+    std::string path_;  // Path to the file.
+    int fd; // Descriptor of the file.
+    off_t off;  // Byte-offset in the file for the next write; accessed only by the writer thread once it is running.
+    bool bgzf;  // Whether the file is written in the BGZF format.
+
+    // A bounded lock-free multi-producer multi-consumer queue of buffer-slot
+    // indices, with per-cell sequence numbers. Its capacity is at least the
+    // number of slots, so pushes never fail.
+    class Slot_Queue
+    {
+    private:
+
+        struct Cell
+        {
+            std::atomic<uint64_t> seq;  // Sequence number of the cell, telling whether it is to be pushed or popped at next.
+            uint32_t idx;   // Slot index in the cell.
+        };
+
+        std::size_t mask;   // Capacity of the queue minus 1.
+        std::unique_ptr<Cell[]> cell;   // Cells of the queue.
+        alignas(L1_CACHE_LINE_SIZE) std::atomic<uint64_t> tail;    // Position of the next push.
+        alignas(L1_CACHE_LINE_SIZE) std::atomic<uint64_t> head;    // Position of the next pop.
+
+    public:
+
+        // Resets the queue to be empty, with capacity for `n` slot indices.
+        void reset(std::size_t n);
+
+        // Pushes the slot index `idx` to the queue.
+        void push(uint32_t idx);
+
+        // Pops a slot index from the queue into `idx`; returns `false` iff the
+        // queue is empty.
+        bool pop(uint32_t& idx);
+    };
+
+    std::vector<std::string> slot;  // Pool of the buffers, handed over between the submitters and the writer thread.
+    Slot_Queue free_q;  // Indices of the slots with recycled buffers available to the submitters.
+    Slot_Queue write_q; // Indices of the slots with buffers yet to be written.
+    std::vector<uint32_t> batch;    // Indices of the slots being written by the writer thread.
+
+    std::atomic<bool> stop; // Whether the writer thread is to stop once the queue is drained.
+
+    std::thread writer; // The writer thread.
+
+
+    // Writes the submitted buffers until stopped.
+    void run();
+
+    // Writes the buffers of `batch` to the file.
+    void write_batch();
+
+    // Compresses `in` into a sequence of BGZF blocks at `out`.
+    void compress_bgzf(const std::string& in, std::string& out) const;
+
+    // Appends to `out` the BGZF block of `len` bytes at `in`, compressed with
+    // the level `level`; returns `false` iff the block would not fit. The
+    // deflate streams are kept per thread and level, and reset per block.
+    static bool append_bgzf_block(const char* in, std::size_t len, int level, std::string& out);
+
+
+public:
+
+    // Constructs a placeholder sink.
+    Streaming_File_Sink();
+
+    Streaming_File_Sink(const Streaming_File_Sink&) = delete;
+    Streaming_File_Sink& operator=(const Streaming_File_Sink&) = delete;
+
+    ~Streaming_File_Sink();
+
+    // Opens the file at `path` for the sink; writes are appended to its
+    // existing content. If `bgzf` is `true`, then the content is compressed
+    // in the BGZF format, and the final closing of the sink appends the BGZF
+    // end-of-file marker block.
+    void open(const std::string& path, bool bgzf = false);
+
+    // Hands over the content of `buf` to be written to the file, and replaces
+    // `buf` with an empty buffer from the pool. Waits if the pool is depleted.
+    void submit(std::string& buf);
+
+    // Writes out all the submitted buffers and closes the file. No submission
+    // may be in progress. If `final` is `false`, then the file is to be
+    // reopened for more content, and the BGZF end-of-file marker is skipped.
+    void close(bool final = true);
+};
+
+
+
+#endif
@@ -60,7 +60,7 @@ public:
     typedef Ext_Mem_Bucket<color_rel_t> color_rel_bucket_t;
     typedef std::vector<color_rel_bucket_t> color_rel_bucket_arr_t;
     typedef Buffer<color_rel_t> color_rel_arr_t;
-    typedef ankerl::unordered_dense::map<Kmer<k>, uint32_t, Kmer_Hasher<k>> count_map_t;
+    typedef std::vector<uint32_t> count_arr_t;
 
     typedef Buffer<uint64_t> bit_vector_t;
 
@@ -69,8 +69,17 @@ public:
 
     // Constructs working space for workers, supporting capacity of at least
     // `max_sz` vertices. For colored graphs, temporary color-relationship
-    // buckets are stored at path-prefix `color_rel_bucket_pref`.
-    Subgraphs_Scratch_Space(std::size_t max_sz, const std::string& color_rel_bucket_pref);
+    // buckets are stored at path-prefix `color_rel_bucket_pref`, and the
+    // color-table has preallocated memory for `color_table_cap` color-sets.
+    Subgraphs_Scratch_Space(std::size_t max_sz, const std::string& color_rel_bucket_pref, std::size_t color_table_cap);
+
+    // Returns an estimate of the memory in bytes used by the working space of
+    // a worker processing subgraphs of at most `max_sz` vertices.
+    static std::size_t worker_bytes(std::size_t max_sz);
+
+    // Returns an estimate of the memory in bytes used by a map of `sz`
+    // vertices.
+    static std::size_t map_bytes(std::size_t sz);
 
     // Returns the appropriate map for a worker.
     map_t& map();
@@ -97,9 +106,9 @@ public:
     // relationships for a worker.
     color_rel_arr_t& color_rel_collate_arr();
 
-    // Returns the appropriate count map of (vertex, source-ID) relationships
-    // for a worker.
-    count_map_t& count_map();
+    // Returns the appropriate array of partition-counts of (vertex, source-ID)
+    // relationships for a worker.
+    count_arr_t& count_arr();
 
     // Returns the appropriate color bit-vector of a worker.
     bit_vector_t& bv();
@@ -136,9 +145,9 @@ private:
     // for different workers.
     std::vector<Padded<color_rel_arr_t>> color_rel_collate_arr_;
 
-    // Collection of count map of (vertex, source-ID) relationships, for
-    // different workers.
-    std::vector<Padded<count_map_t>> count_map_;
+    // Collection of arrays of partition-counts of (vertex, source-ID)
+    // relationships, for different workers.
+    std::vector<Padded<count_arr_t>> count_arr_;
 
     // Collection of color bit-vectors of different workers.
     std::vector<Padded<bit_vector_t>> bv_;
@@ -166,6 +175,9 @@ private:
 
     typedef HT_Router<k, Colored_> ht_router;
 
+    static constexpr uint32_t max_digit_bits = 16;  // Maximum number of vertex-bits to partition color-relationships on.
+    static constexpr std::size_t insertion_sort_threshold = 32; // Color-relationship partitions up to this size are insertion-sorted.
+
     const Super_Kmer_Bucket<Colored_>& B;   // The weak super k-mer bucket inducing this subgraph.
 
     Subgraphs_Scratch_Space<k, Colored_>& work_space;   // Collection of working space for various data structures, per worker.
@@ -207,6 +219,12 @@ private:
     // that has `word_count` words.
     static base_t get_base(const label_unit_t* super_kmer, std::size_t word_count, std::size_t idx);
 
+    // Builds the vertices of the weak super k-mers iterated by `super_kmer_it`
+    // into the hashtable `HT`, and adds the counts of the k-mer instances and
+    // the edges observed to `kmer_c` and `e_c` respectively.
+    template <typename T_ht_>
+    static void construct(typename Super_Kmer_Bucket<Colored_>::Iterator& super_kmer_it, T_ht_& HT, uint64_t& kmer_c, uint64_t& e_c);
+
     // Extracts the maximal unitig containing the vertex `v_hat`, and
     // `maximal_unitig` is used as the working scratch for the extraction, i.e.
     // to build and store two unitigs connecting to the two sides of `v_hat`.
@@ -221,11 +239,16 @@ private:
     // discontinuous side; in which case that vertex is stored in `exit_v`.
     termination_t walk_unitig(const Kmer<k>& v_hat, side_t s_v_hat, Unitig_Scratch<k>& unitig, Directed_Vertex<k>& exit_v);
 
+    // Registers the edges with the bit-mask `edges` exiting the maximal
+    // unitig-end `v` through its back with the GFA segment-registry of the
+    // output, if any.
+    void register_end(const Directed_Vertex<k>& v, uint8_t edges);
+
     // Collects color-relationships of vertices with potentially new colors.
     void collect_color_rels();
 
     // Semi-sorts the color-relationship array `x` of size `sz` to the array
-    // `y`.
+    // `y`, stably.
     void semi_sort_color_rels(const color_rel_t* x, color_rel_t* y, std::size_t sz);
 
     // Sorts the color-set (list) `color`.
@@ -242,12 +265,35 @@ private:
 
 public:
 
+    // A part of a subgraph, induced by a range of the super k-mer chunks of
+    // its bucket. Parts of a subgraph can be constructed concurrently, and be
+    // merged into the subgraph afterwards.
+    class Part
+    {
+        friend class Subgraph;
+
+    private:
+
+        typename Subgraphs_Scratch_Space<k, Colored_>::map_t M; // Map of the part.
+        uint64_t kmer_count_ = 0;   // Number of k-mer instances in the part.
+        uint64_t edge_c = 0;    // Number of edges in the part.
+
+    public:
+
+        // Constructs the part of the subgraph induced by the chunks
+        // `[chunk_beg, chunk_end)` of the weak super k-mer bucket `B`.
+        // `sz_est` is an estimate of the number of vertices in the part, used
+        // to pre-size its map.
+        void construct(const Super_Kmer_Bucket<Colored_>& B, std::size_t chunk_beg, std::size_t chunk_end, std::size_t sz_est);
+    };
+
     // Constructs a subgraph object where the subgraph is induced by the weak
     // super k-mers in the bucket `B`. Updates the discontinuity graph `G` with
     // its edges observed from this subgraph and writes the trivially maximal
     // unitigs to `op_buf`. Uses scratch space for internal data structures
-    // from `space`.
-    Subgraph(const Super_Kmer_Bucket<Colored_>& B, Discontinuity_Graph<k, Colored_>& d_graph, op_buf_t& op_buf, Subgraphs_Scratch_Space<k, Colored_>& space);
+    // from `space`. `sz_est` is an estimate of the number of vertices in the
+    // subgraph, used to pre-size its map.
+    Subgraph(const Super_Kmer_Bucket<Colored_>& B, Discontinuity_Graph<k, Colored_>& d_graph, op_buf_t& op_buf, Subgraphs_Scratch_Space<k, Colored_>& space, std::size_t sz_est = 0);
 
     Subgraph(const Subgraph&) = delete;
     Subgraph(Subgraph&&) = delete;
@@ -256,6 +302,12 @@ public:
     // an internal navigable and membership data structure.
     void construct();
 
+    // Constructs the subgraph by merging its parts `P`, which together cover
+    // the provided weak super k-mer bucket. The parts are released. Only
+    // supported for uncolored subgraphs, as the color-set hashes of vertices
+    // depend on the order of their super k-mers.
+    void construct(std::vector<Part>& P);
+
     // Constructs the subgraph from the provided weak super k-mer bucket into
     // an internal navigable and membership data structure. Addresses "exact"
     // loop-filtering opposed to `construct`.
@@ -347,6 +399,11 @@ private:
     template <typename T_ht_> static void add_HT(std::vector<Padded<T_ht_>>& vec, std::size_t sz) { vec.emplace_back(); (void)sz; }
     static void add_HT(std::vector<Padded<Kmer_Hashtable<k, Colored_>>>& vec, std::size_t sz) { vec.emplace_back(sz); }
 
+    template <typename T_ht_> static void reserve(T_ht_& HT, std::size_t sz) { HT.reserve(sz); }
+    static void reserve(Kmer_Hashtable<k, Colored_>& HT, std::size_t sz) { (void)HT; (void)sz; }
+
+    template <typename T_ht_> static void merge(T_ht_& HT, const Kmer<k>& kmer, const State_Config<Colored_>& st) { HT[kmer].merge(st); }
+
     template <typename T_ht_> static void update(T_ht_& HT, const Kmer<k>& kmer, base_t front, base_t back, side_t disc_0, side_t disc_1, source_id_t source);
     static void update(Kmer_Hashtable<k, Colored_>& HT, const Kmer<k>& kmer, base_t front, base_t back, side_t disc_0, side_t disc_1);
 
@@ -487,12 +544,20 @@ inline typename Subgraph<k, Colored_>::termination_t Subgraph<k, Colored_>::walk
         b_ext = state.edge_at(s_v);
         assert(!state.is_discontinuous(s_v) || b_ext == base_t::E); // If a side is discontinuous, it must be empty.
         if(b_ext == base_t::N)  // Reached a branching endpoint.
+        {
+            // The edges are to be in the orientation of the walk.
+            const auto e = state.edge_mask(s_v);
+            register_end(v, s_v == side_t::back ? e : ((e & 0b0001) << 3) | ((e & 0b0010) << 1) | ((e & 0b0100) >> 1) | ((e & 0b1000) >> 3));
             return termination_t::branched;
+        }
 
         if(b_ext == base_t::E)
         {
             if(CF_UNLIKELY(!state.is_discontinuous(s_v)))   // Reached a truly empty side.
+            {
+                register_end(v, 0);
                 return termination_t::dead_ended;
+            }
 
             // Trying to exit the subgraph through a discontinuity vertex.
             exit_v = v;
@@ -512,10 +577,15 @@ inline typename Subgraph<k, Colored_>::termination_t Subgraph<k, Colored_>::walk
         s_v = v.entrance_side();
         assert(!state.is_empty_side(s_v));
         if(state.is_branching_side(s_v))    // Crossed an endpoint and reached a different unitig.
+        {
+            register_end(unitig.endpoint(), 1 << b_ext);
             return termination_t::crossed;
+        }
 
         if(CF_UNLIKELY(state.is_visited())) // Hit the same unitig.
         {
+            register_end(unitig.endpoint(), 1 << b_ext);
+
             // The unitig is an ICC; crossed back to the same unitig.
             if(v.canonical() == v_hat && s_v == s_icc_return)
                 unitig.mark_cycle();
@@ -543,6 +613,17 @@ inline typename Subgraph<k, Colored_>::termination_t Subgraph<k, Colored_>::walk
 }
 
 
+template <uint16_t k, bool Colored_>
+inline void Subgraph<k, Colored_>::register_end(const Directed_Vertex<k>& v, const uint8_t edges)
+{
+    auto const seg_reg = op_buf.segment_registry();
+    if(seg_reg == nullptr)
+        return;
+
+    seg_reg->add_end_edges(v.kmer().data(), edges);
+}
+
+
 template <uint16_t k, bool Colored_>
 template <typename T_ht_>
 inline void HT_Router<k, Colored_>::update(T_ht_& HT, const Kmer<k>& kmer, const base_t front, const base_t back, const side_t disc_0, const side_t disc_1, const source_id_t source)
@@ -5,12 +5,14 @@
 
 
 #include "Atlas.hpp"
+#include "Atlas_Geometry.hpp"
 #include "HyperLogLog.hpp"
 #include "Directed_Vertex.hpp"
 #include "DNA_Utility.hpp"
 #include "Discontinuity_Graph.hpp"
-#include "Async_Logger_Wrapper.hpp"
+#include "Streaming_File_Sink.hpp"
 #include "Character_Buffer.hpp"
+#include "Memory_Budget.hpp"
 #include "utility.hpp"
 #include "globals.hpp"
 
@@ -44,12 +46,24 @@ private:
     const std::string color_rel_path_pref;  // Path-prefix to color-relationship buckets.
     const uint16_t l;   // `l`-minimizer size to partition the graph.
 
+    const Memory_Budget& budget;    // Memory governor for the algorithm execution.
+
+    const Atlas_Geometry geometry;  // Geometry of the subgraph atlases.
+
     typedef Atlas<Colored_> atlas_t;
-    static constexpr std::size_t chunk_bytes = 1024 * 1024; // 1 MB chunk capacity for each atlas.
-    static constexpr std::size_t w_chunk_bytes = 64 * 1024; // 64 KB worker-local chunk capacity in each atlas.
+    static constexpr std::size_t chunk_bytes = 1024 * 1024; // 1 MB preferred chunk capacity for each atlas.
+    static constexpr std::size_t w_chunk_bytes = 64 * 1024; // 64 KB preferred worker-local chunk capacity in each atlas.
+    static constexpr std::size_t subgraph_chunk_bytes = 64 * 1024;  // 64 KB preferred chunk capacity for each subgraph.
+    static constexpr std::size_t min_chunk_bytes = 4 * 1024;    // 4 KB minimum capacity for any chunk, if the memory budget is tight.
     std::vector<Padded<atlas_t>> atlas; // Super k-mer buckets for the subgraph atlases.
 
     std::vector<Padded<HyperLogLog>> HLL;   // `HLL[g]` is the cardinality-estimator for subgraph `g`.
+    static constexpr uint32_t log_HLL_sample_gap = 4;   // Only one in `2^log_HLL_sample_gap` distinct k-mers, by content, are fed to the estimators.
+
+    static constexpr std::size_t split_factor = 2;  // Subgraphs larger than `1 / split_factor` of a worker's fair share of the bytes are split in construction.
+    static constexpr std::size_t min_split_bytes = 16 * 1024 * 1024;    // 16 MB minimum size of subgraphs to split in construction.
+
+    static constexpr std::size_t read_ahead_bytes = 1024 * 1024;    // 1 MB of compressed chunks read ahead from the bucket of a worker's next subgraph.
 
     Discontinuity_Graph<k, Colored_>& G_;   // The discontinuity graph.
 
@@ -58,7 +72,7 @@ private:
 
     // TODO: move out the following to some CF3-centralized location.
 
-    typedef Async_Logger_Wrapper sink_t;
+    typedef Streaming_File_Sink sink_t;
     typedef Character_Buffer<sink_t> op_buf_t;
     typedef std::vector<Padded<op_buf_t>> op_buf_list_t;
     op_buf_list_t& op_buf; // Worker-specific output buffers.
@@ -66,7 +80,9 @@ private:
     const std::string color_path_pref;  // Path-prefix to the output color buckets.
 
     // Adds the label `seq` and length `len` to the HLL estimate of the
-    // subgraph `g` of the de Bruijn graph.
+    // subgraph `g` of the de Bruijn graph. A k-mer is sampled into the
+    // estimate per a cheap hash of its content, so that only the sampled ones
+    // are fully hashed and touch the shared registers.
     void add_to_HLL(std::size_t g, const char* seq, std::size_t len);
 
 
@@ -74,13 +90,15 @@ public:
 
     // Constructs a manager for the subgraphs of a de Bruijn graph which is
     // partitioned according to `l`-minimizers. `logistics` is the data-
-    // logistics manager for the algorithm execution. The discontinuity-graph
-    // is produced at `G` without false-phantom edges. Worker-specific
-    // trivially maximal unitigs are written to the buffers in `op_buf`.
-    Subgraphs_Manager(const Data_Logistics& logistics, uint16_t l, Discontinuity_Graph<k, Colored_>& G, op_buf_list_t& op_buf);
+    // logistics manager for the algorithm execution, and `budget` is its
+    // memory governor. The subgraphs are laid out in atlases per `geometry`.
+    // The discontinuity-graph is produced at `G` without false-phantom edges.
+    // Worker-specific trivially maximal unitigs are written to the buffers in
+    // `op_buf`.
+    Subgraphs_Manager(const Data_Logistics& logistics, const Memory_Budget& budget, const Atlas_Geometry& geometry, uint16_t l, Discontinuity_Graph<k, Colored_>& G, op_buf_list_t& op_buf);
 
     // Returns the number of subgraphs.
-    auto graph_count() const { return Atlas<Colored_>::graph_count(); }
+    auto graph_count() const { return geometry.graph_count(); }
 
     // Returns the discontinuity graph.
     const auto& G() const { return G_; }
@@ -112,6 +130,9 @@ public:
     // after this.
     void finalize();
 
+    // Returns the estimated size of the subgraph `g`.
+    uint64_t estimate_size(std::size_t g) const;
+
     // Returns the largest estimated size of any subgraph.
     uint64_t estimate_size_max() const;
 
@@ -127,7 +148,7 @@ public:
     uint64_t icc_count() const;
 
     // Returns the subgraph ID for a minimizer with 64-bit hash value `h`.
-    uint64_t graph_ID(uint64_t h) const { return h & (Atlas<Colored_>::graph_count() - 1); }
+    uint64_t graph_ID(uint64_t h) const { return geometry.graph_of(h); }
 
     // Returns the resident set size of the space-dominant components of the
     // subgraphs-manager.
@@ -141,11 +162,11 @@ inline void Subgraphs_Manager<k, Colored_>::add_super_kmer(const std::size_t g,
 {
     assert(len >= k);
 
-    const auto a = Atlas<Colored_>::atlas_ID(g);
+    const auto a = geometry.atlas_ID(g);
     auto& bucket = atlas[a].unwrap();
     bucket.add(seq, len, l_disc, r_disc, g);
 
-    // add_to_HLL(g, seq, len);
+    add_to_HLL(g, seq, len);
 }
 
 
@@ -155,11 +176,11 @@ inline void Subgraphs_Manager<k, Colored_>::add_super_kmer(const std::size_t g,
 {
     assert(len >= k);
 
-    const auto a = Atlas<Colored_>::atlas_ID(g);
+    const auto a = geometry.atlas_ID(g);
     auto& bucket = atlas[a].unwrap();
     bucket.add(seq, len, source, l_disc, r_disc, g);
 
-    // add_to_HLL(g, seq, len);
+    add_to_HLL(g, seq, len);
 }
 
 
@@ -172,7 +193,13 @@ inline void Subgraphs_Manager<k, Colored_>::add_to_HLL(const std::size_t g, cons
     std::size_t next_idx = k;
     while(true)
     {
-        hll.add(v.canonical().to_u64() & u32_mask);
+        const auto& kmer = v.canonical();
+        uint64_t x = 0;
+        for(uint16_t i = 0; i < (k + 31) / 32; ++i)
+            x ^= kmer.data()[i];
+
+        if(((x * 0x9E3779B97F4A7C15) >> (64 - log_HLL_sample_gap)) == 0)
+            hll.add_shared(kmer.to_u64() & u32_mask);
 
         if(next_idx == len)
             break;
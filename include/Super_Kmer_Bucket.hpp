@@ -5,6 +5,7 @@
 
 
 #include "Super_Kmer_Chunk.hpp"
+#include "Async_IO.hpp"
 #include "globals.hpp"
 
 #include <cstddef>
@@ -13,8 +14,9 @@
 #include <string>
 #include <vector>
 #include <utility>
-#include <fstream>
+#include <atomic>
 #include <cassert>
+#include <sys/types.h>
 
 
 namespace cuttlefish
@@ -23,7 +25,10 @@ namespace cuttlefish
 // =============================================================================
 // A bucket of super k-mers corresponding to a subgraph of the underlying de
 // Bruijn graph. `Colored_` denotes whether the super k-mers in the bucket each
-// has an associated source ID.
+// has an associated source ID. The chunks are compressed into alternating
+// buffers and written asynchronously, so that a chunk is being written while
+// the next one is being filled. One of the buffers is the chunk's own
+// compression-buffer, so the bucket adds only one.
 template <bool Colored_>
 class Super_Kmer_Bucket
 {
@@ -32,14 +37,18 @@ class Super_Kmer_Bucket
 
 private:
 
+    const uint16_t k;   // k-mer length.
+    const uint16_t l;   // Minimizer length.
     const std::string path_;    // Path to the external-memory bucket.
-    std::ofstream output;   // Output stream to the external-memory bucket.
+    Async_Writer output;    // Writer to the external-memory bucket.
 
     uint64_t size_; // Number of super k-mers in the bucket. It's not necessarily correct before closing the bucket.
 
     typedef Super_Kmer_Chunk<Colored_> chunk_t;
     std::size_t chunk_cap;  // Capacity (in number of super k-mers) of the chunk of the bucket.
     mutable chunk_t chunk;  // Super k-mer chunk for the bucket.
+    Buffer<uint8_t> cmp_buf;    // Buffer of the compressed chunks being written, alternating with the compression-buffer of `chunk`.
+    uint8_t cmp_cur;    // Index of the buffer to compress the next chunk into: `0` for `cmp_buf`, and `1` for that of `chunk`.
 
     std::vector<uint32_t> chunk_sz; // Sizes of the flushed chunks.
     std::vector<std::pair<int32_t, int32_t>> cmp_bytes; // Sizes (in bytes) of the compressed chunks' attributes and labels.
@@ -47,10 +56,54 @@ private:
     std::size_t bytes_; // Total number of bytes in the bucket. Not necessarily exact before closing.
     std::size_t compressed_bytes_;  // Total number of bytes in the compressed bucket. Not necessarily exact before closing.
 
+    // Read-ahead of the leading compressed chunks of the bucket. It is claimed
+    // by the first iterator from the bucket's beginning, whichever worker
+    // that is.
+    struct Read_Ahead
+    {
+        // States of a read-ahead.
+        enum State : uint8_t
+        {
+            none,       // No read-ahead has been issued.
+            issuing,    // The read-ahead is being issued.
+            issued,     // The read-ahead has been issued.
+            claimed,    // The read-ahead has been claimed, or is not to be issued anymore.
+        };
+
+        std::atomic<uint8_t> state; // State of the read-ahead.
+        int fd; // Descriptor of the external-memory bucket for the read-ahead.
+        std::size_t chunk_c;    // Number of chunks read ahead.
+        Buffer<uint8_t> buf;    // Buffer of the compressed chunks read ahead.
+        IO_Request req; // Request of the read-ahead.
+
+        Read_Ahead():
+              state(none)
+            , fd(-1)
+            , chunk_c(0)
+        {}
+
+        Read_Ahead(Read_Ahead&& rhs):
+              state(rhs.state.load())
+            , fd(rhs.fd)
+            , chunk_c(rhs.chunk_c)
+            , buf(std::move(rhs.buf))
+            , req(std::move(rhs.req))
+        {
+            rhs.fd = -1;
+        }
+    };
+
+    mutable Read_Ahead read_ahead_; // Read-ahead of the bucket.
+
 
     // Flushes the super k-mer chunk to the external-memory bucket.
     void flush_chunk();
 
+    // Claims the read-ahead of the bucket, if one has been issued, into `buf`
+    // with its chunk-count in `chunk_c`, and returns `true`. Returns `false`
+    // if none has been issued, and no read-ahead can be issued afterwards.
+    bool claim_read_ahead(Buffer<uint8_t>& buf, std::size_t& chunk_c) const;
+
 public:
 
     class Iterator;
@@ -79,6 +132,9 @@ public:
     // necessarily exact before closing.
     auto compressed_bytes() const { return compressed_bytes_; }
 
+    // Returns the number of chunks flushed to the external-memory bucket.
+    auto chunk_count() const { return chunk_sz.size(); }
+
     // Issues prefetch request for the end of the chunk.
     void fetch_end() { chunk.fetch_end(); }
 
@@ -89,6 +145,12 @@ public:
     // Closes the bucket—no more content should be added afterwards.
     void close();
 
+    // Issues asynchronously reading ahead the leading compressed chunks of the
+    // closed bucket, at most `max_bytes` bytes of them—but at least one chunk,
+    // so that an iteration over the bucket starts warm. It is a no-op if the
+    // bucket has been read ahead or iterated already.
+    void read_ahead(std::size_t max_bytes);
+
     // Removes the bucket.
     void remove();
 
@@ -98,20 +160,41 @@ public:
 };
 
 
-// Iterator over super k-mer buckets.
+// Iterator over super k-mer buckets. The next compressed chunk is prefetched
+// asynchronously while the current one is being decompressed and processed.
 template <bool Colored_>
 class Super_Kmer_Bucket<Colored_>::Iterator
 {
 private:
 
     const Super_Kmer_Bucket& B; // Bucket to iterate over.
-    std::ifstream input;    // Input stream from the external-memory bucket.
+    int fd; // Descriptor of the external-memory bucket.
+
+    chunk_t range_chunk;    // Super k-mer chunk of the iterator when it is over a chunk-range of the bucket.
+    chunk_t& chunk; // Super k-mer chunk to read the bucket into.
 
     std::size_t idx;    // Current slot-index the iterator is in, i.e. next super k-mer to access.
+    std::size_t end_idx;    // Non-inclusive index into the bucket where the iteration ends.
     std::size_t chunk_start_idx;    // Index into the bucket where the current in-memory chunk starts.
     std::size_t chunk_end_idx;  // Non-inclusive index into the bucket where the current in-memory chunk ends.
     std::size_t chunk_id;   // Sequential-ID of the chunk being processed right now.
+    std::size_t chunk_end_id;   // Non-inclusive sequential-ID of the chunk where the iteration ends.
+    off_t chunk_off;    // Byte-offset of the chunk `chunk_id` in the external-memory bucket.
 
+    Buffer<uint8_t> cmp_buf[2]; // Buffers of the compressed current and next chunks.
+    uint8_t cmp_cur;    // Index of the buffer of the current chunk.
+    IO_Request fetch_req;   // Request of the chunk being fetched.
+
+    Buffer<uint8_t> staged; // Compressed leading chunks of the bucket that have been read ahead.
+    std::size_t staged_c;   // Number of chunks read ahead.
+
+
+    // Opens the external-memory bucket.
+    void open();
+
+    // Issues fetching the compressed chunk `c` at byte-offset `off` into the
+    // buffer `cmp_buf[b]`.
+    void fetch(std::size_t c, off_t off, uint8_t b);
 
     // Reads in the next super k-mer chunk from the bucket and returns the
     // number of super k-mers read.
@@ -125,13 +208,20 @@ public:
     // Constructs an iterator for the super k-mer bucket `B`.
     Iterator(const Super_Kmer_Bucket& B);
 
+    // Constructs an iterator over the chunks `[chunk_beg, chunk_end)` of the
+    // super k-mer bucket `B`. Iterators over disjoint chunk-ranges of a bucket
+    // can be used concurrently.
+    Iterator(const Super_Kmer_Bucket& B, std::size_t chunk_beg, std::size_t chunk_end);
+
     Iterator(const Iterator&) = delete;
     Iterator& operator=(const Iterator&) = delete;
     Iterator(Iterator&&) = delete;
     Iterator& operator=(Iterator&&) = delete;
 
+    ~Iterator();
+
     // Return the number of 64-bit words in super k-mer encodings.
-    auto super_kmer_word_count() const { return B.chunk.super_kmer_word_count(); }
+    auto super_kmer_word_count() const { return chunk.super_kmer_word_count(); }
 
     // Moves the iterator to the next super k-mer in the bucket. Iff the bucket
     // is not depleted, the associated super k-mer's attribute and label-
@@ -153,11 +243,11 @@ inline void Super_Kmer_Bucket<Colored_>::add(const label_unit_t* const seq, cons
 template <bool Colored_>
 inline bool Super_Kmer_Bucket<Colored_>::Iterator::next(attribute_t& att, const label_unit_t*& label)
 {
-    assert(idx <= B.size());
+    assert(idx <= end_idx);
 
-    if(CF_UNLIKELY(idx == B.size()))
+    if(CF_UNLIKELY(idx == end_idx))
     {
-        B.chunk.clear();
+        chunk.clear();
         return false;
     }
 
@@ -168,7 +258,7 @@ inline bool Super_Kmer_Bucket<Colored_>::Iterator::next(attribute_t& att, const
     }
 
     assert(idx >= chunk_start_idx && idx < chunk_end_idx);
-    B.chunk.get_super_kmer(idx - chunk_start_idx, att, label);
+    chunk.get_super_kmer(idx - chunk_start_idx, att, label);
     idx++;
 
     return true;
@@ -129,6 +129,15 @@ public:
     // returns the compressed sizes of the attributes and the labels.
     auto serialize_compressed(std::ofstream& os) const -> std::pair<int32_t, int32_t>;
 
+    // Compresses the chunk into the buffer `sink`, growing it as required, and
+    // returns the compressed sizes of the attributes and the labels. The
+    // compressed labels follow the compressed attributes in `sink`.
+    auto compress(Buffer<uint8_t>& sink) const -> std::pair<int32_t, int32_t>;
+
+    // Returns the buffer the chunk (de)compresses through with streams. Its
+    // owner may use it otherwise while no such (de)serialization is underway.
+    Buffer<uint8_t>& compression_buffer() const { return cmp_buf; }
+
     // Deserializes a chunk from the stream `is` with `sz` super k-mers.
     template <typename T_is_>
     void deserialize(T_is_& is, std::size_t sz);
@@ -137,6 +146,10 @@ public:
     // `cmp_bytes` in the compressed form, from the stream `is`.
     void deserialize_decompressed(std::ifstream& is, std::size_t sz, std::pair<int32_t, int32_t> cmp_bytes);
 
+    // Decompresses a chunk with `sz` super k-mers from the memory `src`, which
+    // has the compressed chunk with sizes `cmp_bytes`, per `compress`.
+    void decompress(const uint8_t* src, std::size_t sz, std::pair<int32_t, int32_t> cmp_bytes);
+
     // Issues prefetch request for the end of the chunk.
     void fetch_end() const;
 
@@ -279,29 +292,38 @@ inline void Super_Kmer_Chunk<Colored_>::serialize(T_os_& os) const
 
 template <bool Colored_>
 inline auto Super_Kmer_Chunk<Colored_>::serialize_compressed(std::ofstream& os) const -> std::pair<int32_t, int32_t>
+{
+    const auto cmp_bytes = compress(cmp_buf);
+
+    os.write(reinterpret_cast<const char*>(cmp_buf.data()), cmp_bytes.first + cmp_bytes.second);
+    if(!os)
+    {
+        std::cerr << "Serialization of compressed super k-mer chunk of size " << size() << " failed. Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    return cmp_bytes;
+}
+
+
+template <bool Colored_>
+inline auto Super_Kmer_Chunk<Colored_>::compress(Buffer<uint8_t>& sink_buf) const -> std::pair<int32_t, int32_t>
 {
     const auto max_att_bytes = LZ4_compressBound(size() * sizeof(attribute_t));
     const auto max_label_bytes = LZ4_compressBound(label_units() * sizeof(label_unit_t));
     assert(max_att_bytes > 0 && max_label_bytes > 0);
 
-    cmp_buf.reserve_uninit(max_att_bytes + max_label_bytes);
-    auto* const sink = reinterpret_cast<char*>(cmp_buf.data());
+    sink_buf.reserve_uninit(max_att_bytes + max_label_bytes);
+    auto* const sink = reinterpret_cast<char*>(sink_buf.data());
 
     auto* const sink_att = sink;
-    const auto att_bytes = LZ4_compress_default(reinterpret_cast<const char*>(att_buf.data()), sink_att, size() * sizeof(attribute_t), cmp_buf.capacity());
+    const auto att_bytes = LZ4_compress_default(reinterpret_cast<const char*>(att_buf.data()), sink_att, size() * sizeof(attribute_t), sink_buf.capacity());
     assert(att_bytes > 0);
 
     auto* const sink_label = sink + att_bytes;
-    const auto label_bytes = LZ4_compress_default(reinterpret_cast<const char*>(label_buf.data()), sink_label, label_units() * sizeof(label_unit_t), cmp_buf.capacity() - att_bytes);
+    const auto label_bytes = LZ4_compress_default(reinterpret_cast<const char*>(label_buf.data()), sink_label, label_units() * sizeof(label_unit_t), sink_buf.capacity() - att_bytes);
     assert(label_bytes > 0);
 
-    os.write(sink, att_bytes + label_bytes);
-    if(!os)
-    {
-        std::cerr << "Serialization of compressed super k-mer chunk of size " << size() << " failed. Aborting.\n";
-        std::exit(EXIT_FAILURE);
-    }
-
     return {att_bytes, label_bytes};
 }
 
@@ -331,15 +353,22 @@ inline void Super_Kmer_Chunk<Colored_>::deserialize(T_is_& is, const std::size_t
 template <bool Colored_>
 inline void Super_Kmer_Chunk<Colored_>::deserialize_decompressed(std::ifstream& is, const std::size_t sz, const std::pair<int32_t, int32_t> cmp_bytes)
 {
-    assert(sz <= cap_);
-    size_ = sz;
-
     cmp_buf.reserve_uninit(cmp_bytes.first + cmp_bytes.second);
-    auto* const src = reinterpret_cast<char*>(cmp_buf.data());
 
-    is.read(src, cmp_bytes.first + cmp_bytes.second);
+    is.read(reinterpret_cast<char*>(cmp_buf.data()), cmp_bytes.first + cmp_bytes.second);
     assert(is.gcount() == static_cast<std::streamsize>(cmp_bytes.first + cmp_bytes.second));
 
+    decompress(cmp_buf.data(), sz, cmp_bytes);
+}
+
+
+template <bool Colored_>
+inline void Super_Kmer_Chunk<Colored_>::decompress(const uint8_t* const cmp_src, const std::size_t sz, const std::pair<int32_t, int32_t> cmp_bytes)
+{
+    assert(sz <= cap_);
+    size_ = sz;
+
+    const auto* const src = reinterpret_cast<const char*>(cmp_src);
     const auto src_att = src;
     const auto att_bytes = LZ4_decompress_safe(src_att, reinterpret_cast<char*>(att_buf.data()), cmp_bytes.first, att_buf.capacity() * sizeof(attribute_t));
     assert(att_bytes >= 0); (void)att_bytes;
@@ -395,13 +424,8 @@ template <bool Colored_>
 inline void Super_Kmer_Chunk<Colored_>::add_encoded_label(const char* const seq, const std::size_t len)
 {
     const auto label_off = label_units();   // Offset into the packed-encoding concatenation where to put the label.
-    int64_t word_idx = sup_kmer_word_c - 1; // Index of the current word being encoded from the label; the encoding is MSB-boundary aligned for now.
-    // TODO: use vectorized encoding.
-    for(std::size_t b_idx = 0; b_idx < len; b_idx += 32)
-    {
-        label_buf[label_off + word_idx] = Kmer_Utility::encode_checked<32>(seq + b_idx);
-        word_idx--;
-    }
+    const auto word_c = (len + 31) / 32;    // Number of words encoding the label; the encoding is MSB-boundary aligned for now.
+    Kmer_Utility::encode_checked_words(seq, word_c, label_buf.data() + label_off + sup_kmer_word_c - word_c);
 }
 
 
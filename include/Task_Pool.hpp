@@ -0,0 +1,126 @@
+#ifndef TASK_POOL_HPP
+#define TASK_POOL_HPP
+
+
+
+#include "Spin_Lock.hpp"
+#include "utility.hpp"
+
+#include <cstddef>
+#include <deque>
+#include <vector>
+#include <cassert>
+
+
+namespace cuttlefish
+{
+
+// =============================================================================
+// A work-stealing pool of tasks of type `T_` for a fixed set of workers. Each
+// worker has its own FIFO queue of tasks; a worker with an empty queue steals
+// from the front of the others' queues.
+template <typename T_>
+class Task_Pool
+{
+private:
+
+    std::vector<Padded<std::deque<T_>>> Q;  // Task-queues of the workers.
+    std::vector<Padded<Spin_Lock>> lock_;   // Locks to the task-queues.
+
+
+    // Tries to take a task off the `w`'th worker's queue into `t`. Returns
+    // `true` iff a task is taken.
+    bool take(std::size_t w, T_& t);
+
+public:
+
+    // Constructs an empty task-pool for `worker_c` workers.
+    Task_Pool(std::size_t worker_c):
+          Q(worker_c)
+        , lock_(worker_c)
+    {}
+
+    // Returns the number of workers of the pool.
+    std::size_t worker_count() const { return Q.size(); }
+
+    // Adds the task `t` to the `w`'th worker's queue.
+    void push(std::size_t w, const T_& t);
+
+    // Fetches the next task for the `w`'th worker into `t`: from its own queue
+    // if non-empty, otherwise stealing from the other workers. Returns `false`
+    // iff the pool has no task left.
+    bool next(std::size_t w, T_& t);
+
+    // Copies the task at the front of the `w`'th worker's own queue into `t`,
+    // without taking it. Returns `false` iff the queue is empty. The task may
+    // be stolen by another worker afterwards.
+    bool peek(std::size_t w, T_& t);
+};
+
+
+template <typename T_>
+inline void Task_Pool<T_>::push(const std::size_t w, const T_& t)
+{
+    assert(w < Q.size());
+
+    lock_[w].unwrap().lock();
+    Q[w].unwrap().push_back(t);
+    lock_[w].unwrap().unlock();
+}
+
+
+template <typename T_>
+inline bool Task_Pool<T_>::take(const std::size_t w, T_& t)
+{
+    auto& q = Q[w].unwrap();
+    bool taken = false;
+
+    lock_[w].unwrap().lock();
+    if(!q.empty())
+        t = q.front(),
+        q.pop_front(),
+        taken = true;
+    lock_[w].unwrap().unlock();
+
+    return taken;
+}
+
+
+template <typename T_>
+inline bool Task_Pool<T_>::next(const std::size_t w, T_& t)
+{
+    assert(w < Q.size());
+
+    for(std::size_t i = 0; i < Q.size(); ++i)
+    {
+        const auto v = (w + i < Q.size() ? w + i : w + i - Q.size());
+        if(take(v, t))
+            return true;
+    }
+
+    return false;
+}
+
+
+template <typename T_>
+inline bool Task_Pool<T_>::peek(const std::size_t w, T_& t)
+{
+    assert(w < Q.size());
+
+    auto& q = Q[w].unwrap();
+    bool found = false;
+
+    lock_[w].unwrap().lock();
+    if(!q.empty())
+        t = q.front(),
+        found = true;
+    lock_[w].unwrap().unlock();
+
+    return found;
+}
+
+}
+
+
+
+#endif
@@ -11,6 +11,7 @@
 #include "Directed_Vertex.hpp"
 #include "Discontinuity_Graph.hpp"
 #include "Color_Encoding.hpp"
+#include "Memory_Budget.hpp"
 #include "globals.hpp"
 #include "utility.hpp"
 
@@ -22,6 +23,7 @@
 #include <vector>
 #include <string>
 #include <algorithm>
+#include <utility>
 #include <cassert>
 
 
@@ -49,6 +51,8 @@ private:
     const std::string lmtig_buckets_path;   // Path-prefix to the lm-tig buckets.
     const std::string unitig_coord_buckets_path;    // Path-prefix to the unitig-coordinate buckets produced in map-reduce.
 
+    const Memory_Budget& budget;    // Memory governor for the algorithm execution.
+
     std::size_t max_bucket_sz;  // Maximum size of the edge-buckets.
 
     const std::size_t max_unitig_bucket_count;  // Number of buckets storing literal globally-maximal unitigs.
@@ -60,6 +64,12 @@ private:
 
     std::atomic_uint64_t phantom_c_;    // Number of phantom unitigs observed.
 
+    const bool retain_input;    // Whether to retain the input of the collation after its completion.
+
+    const bool positional_op;   // Whether the maximal unitigs are written to their pre-computed positions in the output file.
+    const std::string op_file_path; // Path to the output file.
+    const bool binary_op;   // Whether the output is in the binary unitig format.
+
     class Maximal_Unitig;
 
 
@@ -70,6 +80,25 @@ private:
     // Reduces each maximal unitig bucket to its contained maximal unitigs.
     void reduce();
 
+    // Reduces the maximal unitig bucket `b` to its contained maximal unitigs,
+    // using `U`, `L`, and `C` as working space for its unitig-coordinates,
+    // labels, and colors respectively. Each maximal unitig is passed to `emit`
+    // once in its canonical form.
+    template <typename F_> void reduce_bucket(std::size_t b, Unitig_Coord<k, Colored_>* U, char* L, Unitig_Color* C, F_ emit);
+
+    // Returns the size of the FASTA output of the maximal unitig bucket `b`,
+    // computed from its unitig-coordinates only, using `U` as working space
+    // for these. Only applicable in the uncolored case.
+    std::size_t output_size(std::size_t b, Unitig_Coord<k, Colored_>* U) const;
+
+    // Opens the output file and preallocates `bytes` bytes past its current
+    // end, and returns its descriptor and the beginning offset of the space.
+    std::pair<int, std::size_t> preallocate_output(std::size_t bytes) const;
+
+    // Writes `sz` bytes from `buf` to byte-offset `off` of the output file with
+    // descriptor `fd`.
+    void write_output(int fd, const char* buf, std::size_t sz, std::size_t off) const;
+
     // Loads the path-info of edges from bucket `b` into the table `M`, and
     // returns the size of the bucket. Uses the buffer `buf` to transfer the
     // information from the bucket to the table.
@@ -83,20 +112,34 @@ private:
     // applicable in the colored case.
     void emit_trivial_mtigs();
 
+    // Invokes `f` on each index in `[beg, end)` in parallel, with at most
+    // `worker_c` workers running simultaneously.
+    template <typename F_> static void throttled_for(std::size_t beg, std::size_t end, std::size_t worker_c, F_ f);
+
 
 public:
 
     // Constructs a unitig-collator for unitigs with their associated path-info
     // at `P_e`, i.e. `P_e[b]` contains path-information of the unitigs'
     // corresponding edges at bucket `b`. `logistics` is the data logistics
-    // manager for the algorithm execution. Worker-specific maximal unitigs are
-    // written to the buffers in `op_buf`. `gmtig_bucket_count` many buckets
-    // are used to partition the lm-tigs to their maximal unitigs. `G` is the
-    // associated discontinuity graph.
-    Unitig_Collator(Discontinuity_Graph<k, Colored_>& G, P_e_t& P_e, const Data_Logistics& logistics, op_buf_list_t& op_buf, std::size_t gmtig_bucket_count);
+    // manager for the algorithm execution, and `budget` is its memory
+    // governor. Worker-specific maximal unitigs are written to the buffers in
+    // `op_buf`. `gmtig_bucket_count` many buckets are used to partition the
+    // lm-tigs to their maximal unitigs. `G` is the associated discontinuity
+    // graph. If `retain_input` is `true`, the input of the collation—the
+    // edges' path-info, the lm-tigs, and their colors—is retained after the
+    // collation, so that it can be re-executed; it is to be removed with
+    // `remove_input` then. If `positional_op` is `true`, the maximal unitigs
+    // are written directly to the output file, in parallel and in the order of
+    // their buckets, past its current end—bypassing `op_buf`; only applicable
+    // in the uncolored case. The output buffers should be flushed then.
+    Unitig_Collator(Discontinuity_Graph<k, Colored_>& G, P_e_t& P_e, const Data_Logistics& logistics, const Memory_Budget& budget, op_buf_list_t& op_buf, std::size_t gmtig_bucket_count, bool retain_input = false, bool positional_op = false);
 
     // Collates the locally-maximal unitigs into global ones.
     void collate();
+
+    // Removes the input of the collation.
+    void remove_input();
 };
 
 
@@ -0,0 +1,160 @@
+
+#ifndef UNITIG_LINKS_HPP
+#define UNITIG_LINKS_HPP
+
+
+
+#include "Segment_Registry.hpp"
+#include "Kmer.hpp"
+#include "DNA_Utility.hpp"
+#include "globals.hpp"
+#include "Ext_Mem_Bucket.hpp"
+#include "Character_Buffer.hpp"
+#include "Streaming_File_Sink.hpp"
+#include "utility.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+namespace cuttlefish
+{
+
+// =============================================================================
+// Links between the maximal unitigs of a de Bruijn graph of `k`-mers, for GFA
+// output. The unitigs are registered as they are output, and the ends of each
+// are bucketed by their `(k - 1)`-mer overlaps. The edges exiting the unitig-
+// ends are registered separately, during the subgraphs' contraction, into the
+// same buckets. Unitig-ends overlapping in the same `(k - 1)`-mer, in opposite
+// orientations, are linked iff the `(k + 1)`-mer spanning them is an edge of
+// the graph, i.e. passes the edge-frequency threshold.
+//
+// Ends with no registered edges are those of the cyclic unitigs, which exit
+// only into their own other ends.
+template <uint16_t k>
+class Unitig_Links : public Segment_Registry
+{
+private:
+
+    typedef Kmer<(k > 1 ? k - 1 : 1)> overlap_t;    // `(k - 1)`-mers.
+
+
+    // An end of a unitig.
+    struct End
+    {
+        overlap_t key;  // Canonical form of the `(k - 1)`-mer overlap at the end.
+        uint64_t id;    // ID of the unitig; it is `unmatched` for a record of the edges exiting an end.
+        uint64_t len;   // Length of the unitig.
+        bool tail;  // Whether this is the back end of the unitig.
+        bool fw;    // Whether the overlap exiting the unitig through this end is `key` itself.
+        uint8_t ext;    // `Base`-encoding of the base of the end's k-mer off the exiting overlap.
+        uint8_t edges;  // Bit-mask of the bases extending the exiting overlap into the edges; `unknown_edges` if not registered.
+
+        bool operator<(const End& rhs) const
+        {
+            return key < rhs.key || (key == rhs.key && (fw > rhs.fw || (fw == rhs.fw && ext < rhs.ext)));
+        }
+
+        // Returns whether `rhs` is the same unitig-end as this one, i.e. has
+        // the same k-mer, exiting in the same orientation.
+        bool same_kmer(const End& rhs) const { return key == rhs.key && fw == rhs.fw && ext == rhs.ext; }
+
+        // Returns whether the `(k + 1)`-mer exiting this end and entering the
+        // end `v` is an edge.
+        bool links_to(const End& v) const
+        {
+            return edges == unknown_edges ?
+                    (v.id == id && v.tail != tail) : (edges & (1u << DNA_Utility::complement(static_cast<base_t>(v.ext))));
+        }
+
+        // (De)serializes the end from / to the `cereal` archive `archive`.
+        template <typename T_archive_> void serialize(T_archive_& archive) { archive(key, id, len, tail, fw, ext, edges); }
+    };
+
+    static constexpr uint8_t unknown_edges = 0xff;  // Marker of unitig-ends with no registered exiting edges.
+
+    typedef Ext_Mem_Bucket_Concurrent<End> bucket_t;
+
+
+    std::vector<Padded<bucket_t>> B;    // `B[b]` contains the unitig-ends with overlaps hashing to `b`.
+    std::atomic_uint64_t id_c;  // Count of the registered unitigs.
+
+
+    // Adds the `(k - 1)`-mer `out` exiting the unitig `id` of length `len`
+    // through its back end iff `tail` is `true`; `ext` is the base of the
+    // end's k-mer off `out`, and `edges` is the bit-mask of the bases
+    // extending `out` into the exiting edges.
+    void add_end(const overlap_t& out, base_t ext, uint64_t id, uint64_t len, bool tail, uint8_t edges = unknown_edges);
+
+    // Invokes `f(E, i, r, j, pal)` for each distinct overlap, in parallel,
+    // where the unitig-ends in `E[i, r)` exit through the overlap and those in
+    // `E[r, j)` enter through it. `pal` is whether the overlap is palindromic,
+    // in which case it is both exited and entered by each end in `E[i, j)`.
+    // The ends have their registered exiting edges attached.
+    template <typename T_f_> void for_each_overlap(T_f_ f) const;
+
+    // Appends the link between the unitig-ends `u` and `v` to `buf`, with
+    // `v`'s overlap entering through `u`'s; in GFA2 iff `gfa2` is `true`.
+    static void append_link(std::string& buf, const End& u, const End& v, bool gfa2);
+
+
+public:
+
+    // Marker of unitig-ends not matched with any other.
+    static constexpr uint64_t unmatched = std::numeric_limits<uint64_t>::max();
+
+    // Constructs a unitig-link tracker with `bucket_count` buckets of unitig-
+    // ends at path-prefix `path_pref`.
+    Unitig_Links(const std::string& path_pref, std::size_t bucket_count);
+
+    // Constructs an empty unitig-link tracker, to be deserialized.
+    Unitig_Links(): id_c(0)
+    {}
+
+    Unitig_Links(const Unitig_Links&) = delete;
+    Unitig_Links& operator=(const Unitig_Links&) = delete;
+
+    // Registers the unitig with the label `seq` concatenated with `seq_add`,
+    // and returns its ID. It is thread-safe.
+    uint64_t add(const std::string_view& seq, const std::string_view& seq_add) override;
+
+    // Registers the edges `edges` exiting the unitig-end with the packed k-mer
+    // `end`. It is thread-safe.
+    void add_end_edges(const uint64_t* end, uint8_t edges) override;
+
+    // Returns the count of the registered unitigs.
+    uint64_t size() const { return id_c; }
+
+    // Appends the links of the registered unitigs to the worker-local output
+    // buffers `op_buf`, in GFA2 iff `gfa2` is `true`.
+    void emit(std::vector<Padded<Character_Buffer<Streaming_File_Sink>>>& op_buf, bool gfa2) const;
+
+    // Matches the unitig-ends pairwise over their links such that each end is
+    // in at most one pair, and no two unmatched ends are linked. `M[2u + t]`
+    // is set to the end matched with the back end of the unitig `u` if `t` is
+    // 1, and with its front end otherwise; it is `unmatched` if there is none.
+    void match(std::vector<uint64_t>& M) const;
+
+    // Removes the buckets of the unitig-ends.
+    void remove();
+
+    // Returns the header of the GFA output, in GFA2 iff `gfa2` is `true`.
+    static std::string header(bool gfa2) { return gfa2 ? "H\tVN:Z:2.0\n" : "H\tVN:Z:1.0\n"; }
+
+    // Serializes the tracker to the `cereal` archive `archive`.
+    template <typename T_archive_> void save(T_archive_& archive) const { const uint64_t c = id_c; archive(B, c); }
+
+    // Deserializes the tracker from the `cereal` archive `archive`.
+    template <typename T_archive_> void load(T_archive_& archive) { uint64_t c; archive(B, c); id_c = c; }
+};
+
+}
+
+
+
+#endif
@@ -7,16 +7,22 @@
 #include "Discontinuity_Graph.hpp"
 #include "Path_Info.hpp"
 #include "Ext_Mem_Bucket.hpp"
-#include "Async_Logger_Wrapper.hpp"
+#include "Streaming_File_Sink.hpp"
 #include "Output_Sink.hpp"
 #include "Character_Buffer.hpp"
+#include "Unitig_Links.hpp"
 #include "Build_Params.hpp"
 #include "Data_Logistics.hpp"
+#include "Memory_Budget.hpp"
+#include "Atlas_Geometry.hpp"
+#include "Phase_Manifest.hpp"
 #include "utility.hpp"
 #include "globals.hpp"
 
 #include <cstdint>
 #include <vector>
+#include <string>
+#include <memory>
 
 
 namespace cuttlefish
@@ -38,7 +44,7 @@ public:
     typedef std::vector<Padded<p_v_bucket_t>> P_v_t;
     typedef std::vector<Padded<p_e_bucket_t>> P_e_t;
 
-    typedef Async_Logger_Wrapper sink_t;
+    typedef Streaming_File_Sink sink_t;
     typedef Character_Buffer<sink_t> op_buf_t;
     typedef std::vector<Padded<op_buf_t>> op_buf_list_t;
 
@@ -46,6 +52,9 @@ private:
 
     const Build_Params params;  // Required parameters (wrapped inside).
     const Data_Logistics logistics; // Data logistics manager for the algorithm execution.
+    const Memory_Budget budget; // Memory governor for the stages of the algorithm execution.
+    const Atlas_Geometry geometry;  // Geometry of the subgraph atlases.
+    const std::string op_sink_path; // Path to the file that the output buffers flush to: the output file, or the staged unitigs for a path cover.
 
     P_v_t P_v;  // `P_v[j]` contains path-info for vertices in partition `j`.
     P_e_t P_e;  // `P_e[b]` contains path-info for edges induced by unitigs in bucket `b`.
@@ -55,6 +64,8 @@ private:
     // 128 KB (soft limit) worth of maximal unitig records (FASTA) can be retained in memory per worker, at most, before flushes.
     op_buf_list_t op_buf;   // Worker-specific output buffers.
 
+    std::unique_ptr<Unitig_Links<k>> links; // Links between the maximal unitigs, for GFA output and path covers.
+
 
     // Contracts the compacted de Bruijn graph from the parameters provided in
     // the constructor. `Colored_` determines whether to color the compacted
@@ -73,6 +84,28 @@ private:
     // Releases the containers of path-info of edges.
     void release_p_e();
 
+    // Returns the total size in bytes of the input files managed by
+    // `logistics`.
+    static uint64_t input_bytes(const Data_Logistics& logistics);
+
+    // Returns the path to the checkpoint of the phase `p`.
+    const std::string checkpoint_path(Phase_Manifest::Phase p) const;
+
+    // Flushes the output buffers and the output sink, and returns the size of
+    // the file that they flush to. The sink remains open.
+    uint64_t flush_output();
+
+    // Records the completion of the phase `p` in the manifest `manifest`, if
+    // checkpointing is requested. The discontinuity graph `gamma`, the path-
+    // info buckets, and the unitig-links for GFA output are checkpointed,
+    // unless the construction is complete.
+    template <bool Colored_> void checkpoint(Phase_Manifest& manifest, Phase_Manifest::Phase p, Discontinuity_Graph<k, Colored_>& gamma);
+
+    // Restores the path-info buckets and the unitig-links for GFA output from
+    // the checkpoint of the phase `p`, and returns the checkpointed
+    // discontinuity graph.
+    template <bool Colored_> std::unique_ptr<Discontinuity_Graph<k, Colored_>> restore(Phase_Manifest::Phase p);
+
 
 public:
 
@@ -0,0 +1,457 @@
+
+#include "Async_IO.hpp"
+#include "parlay/parallel.h"
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <algorithm>
+#include <iostream>
+#include <cstdlib>
+#include <cerrno>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#ifdef CF_IO_URING
+#include <liburing.h>
+#endif
+
+
+namespace cuttlefish
+{
+
+// Interface of the backends servicing the I/O requests.
+class Async_IO::Backend
+{
+public:
+
+    virtual ~Backend() = default;
+
+    // Returns the name of the backend.
+    virtual const char* name() const = 0;
+
+    // Submits the pending request `r` for servicing.
+    virtual void submit(IO_Request& r) = 0;
+};
+
+
+// Backend servicing the requests with blocking I/O from a pool of threads.
+class Async_IO::Thread_Pool_Backend: public Async_IO::Backend
+{
+private:
+
+    Async_IO& io;   // The parent service.
+
+    std::vector<std::thread> thread;    // The I/O threads.
+    std::deque<IO_Request*> queue;  // Requests yet to be serviced.
+    std::mutex mtx; // Mutex guarding the queue.
+    std::condition_variable cv; // Condition variable to notify the I/O threads.
+    bool stop;  // Whether the I/O threads are to stop.
+
+
+    // Services the queued requests until stopped.
+    void run()
+    {
+        while(true)
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            cv.wait(lock, [&](){ return stop || !queue.empty(); });
+            if(queue.empty())
+                return;
+
+            auto* const r = queue.front();
+            queue.pop_front();
+            lock.unlock();
+
+            io.complete(*r, Async_IO::service(*r));
+        }
+    }
+
+
+public:
+
+    Thread_Pool_Backend(Async_IO& io, const std::size_t thread_count):
+          io(io)
+        , stop(false)
+    {
+        thread.reserve(thread_count);
+        for(std::size_t t = 0; t < thread_count; ++t)
+            thread.emplace_back(&Thread_Pool_Backend::run, this);
+    }
+
+    ~Thread_Pool_Backend() override
+    {
+        {
+            std::lock_guard<std::mutex> guard(mtx);
+            stop = true;
+        }
+
+        cv.notify_all();
+        std::for_each(thread.begin(), thread.end(), [](auto& t){ t.join(); });
+    }
+
+    const char* name() const override { return "thread-pool"; }
+
+    void submit(IO_Request& r) override
+    {
+        {
+            std::lock_guard<std::mutex> guard(mtx);
+            queue.push_back(&r);
+        }
+
+        cv.notify_one();
+    }
+};
+
+
+#ifdef CF_IO_URING
+
+// Backend servicing the requests with `io_uring`. The submission queue is
+// shared by the issuing threads under a mutex, and a dedicated thread reaps the
+// completions—resubmitting the remainders of short transfers.
+class Async_IO::IO_Uring_Backend: public Async_IO::Backend
+{
+private:
+
+    static constexpr unsigned queue_depth = 256;    // Number of entries in the submission queue.
+
+    Async_IO& io;   // The parent service.
+
+    io_uring ring;  // The `io_uring` instance.
+    std::mutex sq_mtx;  // Mutex guarding the submission queue.
+    std::thread reaper; // Thread reaping the completions.
+
+
+    IO_Uring_Backend(Async_IO& io):
+          io(io)
+    {}
+
+    // Submits the untransferred remainder of the request `r`; a `nullptr`
+    // request signals the reaper to stop.
+    void enqueue(IO_Request* const r)
+    {
+        std::lock_guard<std::mutex> guard(sq_mtx);
+
+        io_uring_sqe* sqe;
+        while((sqe = io_uring_get_sqe(&ring)) == nullptr)
+            io_uring_submit(&ring);
+
+        if(r == nullptr)
+            io_uring_prep_nop(sqe);
+        else
+        {
+            const auto rem = r->bytes - r->transferred;
+            const auto pos = r->off + r->transferred;
+            if(r->is_write)
+                io_uring_prep_write(sqe, r->fd, r->buf + r->transferred, rem, pos);
+            else
+                io_uring_prep_read(sqe, r->fd, r->buf + r->transferred, rem, pos);
+        }
+
+        io_uring_sqe_set_data(sqe, r);
+        if(io_uring_submit(&ring) < 0)
+        {
+            std::cerr << "Error submitting to io_uring. Aborting.\n";
+            std::exit(EXIT_FAILURE);
+        }
+    }
+
+    // Reaps the completions until signalled to stop.
+    void reap()
+    {
+        while(true)
+        {
+            io_uring_cqe* cqe;
+            const auto ret = io_uring_wait_cqe(&ring, &cqe);
+            if(ret == -EINTR)
+                continue;
+
+            if(ret < 0)
+            {
+                std::cerr << "Error waiting on io_uring completions. Aborting.\n";
+                std::exit(EXIT_FAILURE);
+            }
+
+            auto* const r = static_cast<IO_Request*>(io_uring_cqe_get_data(cqe));
+            const auto res = cqe->res;
+            io_uring_cqe_seen(&ring, cqe);
+
+            if(r == nullptr)
+                return;
+
+            if(res == -EINTR || res == -EAGAIN)
+                enqueue(r);
+            else if(res <= 0)
+                io.complete(*r, false);
+            else
+            {
+                r->transferred += res;
+                if(r->transferred < r->bytes)
+                    enqueue(r);
+                else
+                    io.complete(*r, true);
+            }
+        }
+    }
+
+
+public:
+
+    // Returns an `io_uring` backend for the service `io`, or `nullptr` if the
+    // kernel does not allow it.
+    static std::unique_ptr<Backend> make(Async_IO& io)
+    {
+        std::unique_ptr<IO_Uring_Backend> b(new IO_Uring_Backend(io));
+        if(io_uring_queue_init(queue_depth, &b->ring, 0) < 0)
+            return nullptr;
+
+        // Without `IORING_FEAT_NODROP`, completions beyond the queue capacity
+        // are dropped, and the in-flight requests here are unbounded.
+        if(!(b->ring.features & IORING_FEAT_NODROP))
+        {
+            io_uring_queue_exit(&b->ring);
+            return nullptr;
+        }
+
+        b->reaper = std::thread(&IO_Uring_Backend::reap, b.get());
+        return b;
+    }
+
+    ~IO_Uring_Backend() override
+    {
+        if(reaper.joinable())   // The ring is live.
+        {
+            enqueue(nullptr);
+            reaper.join();
+            io_uring_queue_exit(&ring);
+        }
+    }
+
+    const char* name() const override { return "io_uring"; }
+
+    void submit(IO_Request& r) override { enqueue(&r); }
+};
+
+#endif
+
+
+Async_IO::Async_IO()
+{
+#ifdef CF_IO_URING
+    backend = IO_Uring_Backend::make(*this);
+#endif
+
+    if(!backend)
+        backend = std::make_unique<Thread_Pool_Backend>(*this, std::max<std::size_t>(min_thread_count, parlay::num_workers()));
+}
+
+
+Async_IO::~Async_IO()
+{
+    backend.reset();
+}
+
+
+Async_IO& Async_IO::get()
+{
+    static Async_IO io;
+    return io;
+}
+
+
+const char* Async_IO::backend_name() const
+{
+    return backend->name();
+}
+
+
+void Async_IO::issue(IO_Request& r, const int fd, char* const buf, const std::size_t bytes, const off_t off, const bool is_write)
+{
+    assert(r.state == IO_Request::idle);
+
+    r.fd = fd;
+    r.buf = buf;
+    r.bytes = bytes;
+    r.off = off;
+    r.is_write = is_write;
+    r.transferred = 0;
+
+    if(bytes == 0)
+    {
+        r.state.store(IO_Request::done, std::memory_order_release);
+        return;
+    }
+
+    r.state.store(IO_Request::pending, std::memory_order_release);
+    backend->submit(r);
+}
+
+
+void Async_IO::write(IO_Request& r, const int fd, const void* const buf, const std::size_t bytes, const off_t off)
+{
+    issue(r, fd, const_cast<char*>(static_cast<const char*>(buf)), bytes, off, true);
+}
+
+
+void Async_IO::read(IO_Request& r, const int fd, void* const buf, const std::size_t bytes, const off_t off)
+{
+    issue(r, fd, static_cast<char*>(buf), bytes, off, false);
+}
+
+
+void Async_IO::complete(IO_Request& r, const bool ok)
+{
+    {
+        std::lock_guard<std::mutex> guard(done_mtx);
+        r.state.store(ok ? IO_Request::done : IO_Request::failed, std::memory_order_release);
+    }
+
+    done_cv.notify_all();
+}
+
+
+bool Async_IO::wait(IO_Request& r)
+{
+    auto s = r.state.load(std::memory_order_acquire);
+    if(s == IO_Request::pending)
+    {
+        std::unique_lock<std::mutex> lock(done_mtx);
+        done_cv.wait(lock, [&](){ return r.state.load(std::memory_order_acquire) != IO_Request::pending; });
+        s = r.state.load(std::memory_order_acquire);
+    }
+
+    r.state.store(IO_Request::idle, std::memory_order_release);
+    return s != IO_Request::failed;
+}
+
+
+bool Async_IO::service(IO_Request& r)
+{
+    while(r.transferred < r.bytes)
+    {
+        const auto rem = r.bytes - r.transferred;
+        const auto pos = r.off + static_cast<off_t>(r.transferred);
+        const auto n = (r.is_write ? ::pwrite(r.fd, r.buf + r.transferred, rem, pos) : ::pread(r.fd, r.buf + r.transferred, rem, pos));
+        if(n < 0 && errno == EINTR)
+            continue;
+
+        if(n <= 0)
+            return false;
+
+        r.transferred += n;
+    }
+
+    return true;
+}
+
+
+Async_Writer::Async_Writer():
+      fd(-1)
+    , off(0)
+    , cur(0)
+{}
+
+
+Async_Writer::Async_Writer(const std::string& path, const off_t resume_off):
+    Async_Writer()
+{
+    open(path, resume_off);
+}
+
+
+Async_Writer::Async_Writer(Async_Writer&& rhs):
+      path_(std::move(rhs.path_))
+    , fd(rhs.fd)
+    , off(rhs.off)
+    , req{std::move(rhs.req[0]), std::move(rhs.req[1])}
+    , cur(rhs.cur)
+{
+    rhs.fd = -1;
+}
+
+
+Async_Writer::~Async_Writer()
+{
+    if(fd >= 0)
+        close();
+}
+
+
+void Async_Writer::open(const std::string& path, const off_t resume_off)
+{
+    assert(fd < 0);
+
+    path_ = path;
+    fd = ::open(path_.c_str(), O_WRONLY | O_CREAT | (resume_off < 0 ? O_TRUNC : 0), 0644);
+    if(fd < 0)
+    {
+        std::cerr << "Error opening file at " << path_ << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    off = 0;
+    if(resume_off >= 0)
+    {
+        struct stat st;
+        if(::fstat(fd, &st) != 0 || st.st_size < resume_off || (st.st_size > resume_off && ::ftruncate(fd, resume_off) != 0))
+        {
+            std::cerr << "Error resuming writes to file at " << path_ << ". Aborting.\n";
+            std::exit(EXIT_FAILURE);
+        }
+
+        off = resume_off;
+    }
+}
+
+
+void Async_Writer::write(const void* const buf, const std::size_t bytes)
+{
+    assert(fd >= 0);
+
+    auto& io = Async_IO::get();
+    io.write(req[cur], fd, buf, bytes, off);
+    off += bytes;
+
+    cur ^= 1;
+    if(!io.wait(req[cur]))
+    {
+        std::cerr << "Error writing to file at " << path_ << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+}
+
+
+void Async_Writer::sync()
+{
+    auto& io = Async_IO::get();
+    for(auto& r : req)
+        if(!io.wait(r))
+        {
+            std::cerr << "Error writing to file at " << path_ << ". Aborting.\n";
+            std::exit(EXIT_FAILURE);
+        }
+}
+
+
+void Async_Writer::rewind()
+{
+    sync();
+    off = 0;
+}
+
+
+void Async_Writer::close()
+{
+    sync();
+
+    if(fd >= 0 && ::close(fd) != 0)
+    {
+        std::cerr << "Error closing file at " << path_ << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    fd = -1;
+}
+
+}
@@ -11,8 +11,9 @@ namespace cuttlefish
 {
 
 template <bool Colored_>
-Atlas<Colored_>::Atlas(uint16_t k, uint16_t l, const std::string& path, std::size_t chunk_cap, std::size_t chunk_cap_per_w):
+Atlas<Colored_>::Atlas(uint16_t k, uint16_t l, const std::string& path, const uint64_t graph_per_atlas, std::size_t chunk_cap, std::size_t chunk_cap_per_w, std::size_t subgraph_chunk_cap):
       path_(path)
+    , graph_per_atlas_(graph_per_atlas)
     , size_(0)
     , chunk_cap(chunk_cap)
     , w_local_chunk_cap(chunk_cap_per_w)
@@ -20,6 +21,7 @@ Atlas<Colored_>::Atlas(uint16_t k, uint16_t l, const std::string& path, std::siz
     // , flush_buf(!Colored_ ? new chunk_t(k, l, chunk_cap) : nullptr)
     , flush_buf(new chunk_t(k, l, chunk_cap))   // TODO: fix depending on the partitioning scheme.
     , rec_size(chunk->record_size())
+    , subgraph_chunk_cap(subgraph_chunk_cap)
 {
     chunk_w.reserve(parlay::num_workers());
     for(std::size_t i = 0; i < parlay::num_workers(); ++i)
@@ -27,13 +29,14 @@ Atlas<Colored_>::Atlas(uint16_t k, uint16_t l, const std::string& path, std::siz
 
     subgraph.reserve(graph_per_atlas());
     for(std::size_t i = 0; i < graph_per_atlas(); ++i)
-        subgraph.emplace_back(k, l, path_ + "/G_" + std::to_string(i), subgraph_chunk_cap_bytes / chunk->record_size());
+        subgraph.emplace_back(k, l, path_ + "/G_" + std::to_string(i), subgraph_chunk_cap);
 }
 
 
 template <bool Colored_>
 Atlas<Colored_>::Atlas(Atlas&& rhs):
       path_(std::move(rhs.path_))
+    , graph_per_atlas_(rhs.graph_per_atlas_)
     , size_(rhs.size_)
     , chunk_cap(rhs.chunk_cap)
     , w_local_chunk_cap(rhs.w_local_chunk_cap)
@@ -41,6 +44,7 @@ Atlas<Colored_>::Atlas(Atlas&& rhs):
     , flush_buf(std::move(rhs.flush_buf))
     , chunk_w(std::move(rhs.chunk_w))
     , rec_size(std::move(rhs.rec_size))
+    , subgraph_chunk_cap(rhs.subgraph_chunk_cap)
     , subgraph(std::move(rhs.subgraph))
 {}
 
@@ -54,12 +58,18 @@ void Atlas<Colored_>::empty_w_local_chunk(const std::size_t w_id)
 
     chunk_lock.lock();
 
-    const bool to_flush = (chunk->size() + c_w.size() >= chunk_cap);
+    // A full chunk is swapped out for flushing only once the previous one has
+    // been flushed; until then, it keeps taking in super k-mers past its soft
+    // capacity, so that the workers do not wait on the flush.
+    const auto sz = chunk->size() + c_w.size();
+    bool to_flush = false;
+    if(sz >= max_chunk_growth * chunk_cap)
+        flush_lock.lock(), to_flush = true;
+    else if(sz >= chunk_cap)
+        to_flush = flush_lock.try_lock();
+
     if(to_flush)
-    {
-        flush_lock.lock();
         chunk.swap(flush_buf);
-    }
 
     chunk->append(c_w);
     size_ += c_w.size();
@@ -0,0 +1,51 @@
+
+#include "Atlas_Geometry.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <cstdlib>
+
+
+namespace cuttlefish
+{
+
+Atlas_Geometry::Atlas_Geometry(const uint64_t atlas_count, const uint64_t graph_per_atlas):
+      atlas_count_(atlas_count)
+    , graph_per_atlas_(graph_per_atlas)
+    , log_graph_per_atlas(is_pow_2(graph_per_atlas) ? log_2(graph_per_atlas) : 0)
+{
+    if(!is_pow_2(atlas_count) || !is_pow_2(graph_per_atlas))
+    {
+        std::cerr << "Atlas count and subgraph count per atlas need to be powers of 2. Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    if(graph_count() > max_graph_count_)
+    {
+        std::cerr << "At most " << max_graph_count_ << " subgraphs are supported. Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+}
+
+
+Atlas_Geometry Atlas_Geometry::choose(uint64_t graph_count, const uint64_t input_bytes, const std::size_t worker_count)
+{
+    if(graph_count == 0)
+    {
+        const auto min_c = std::max(min_graph_count, graph_per_worker * worker_count);
+        graph_count = std::min(ceil_pow_2(std::max(min_c, input_bytes / input_bytes_per_graph)), max_graph_count_);
+    }
+    else if(!is_pow_2(graph_count))
+    {
+        std::cerr << "Subgraph count needs to be a power of 2. Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    // Each atlas is contended by the workers adding super k-mers to it, and
+    // holds a chunk per worker; so the atlases scale with the worker count.
+    const auto atlas_c = std::min(std::clamp(ceil_pow_2(2 * std::max(worker_count, 1lu)), min_atlas_count, max_atlas_count), graph_count);
+
+    return Atlas_Geometry(atlas_c, graph_count / atlas_c);
+}
+
+}
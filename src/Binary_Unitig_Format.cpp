@@ -0,0 +1,99 @@
+
+#include "Binary_Unitig_Format.hpp"
+
+#include <vector>
+#include <iostream>
+#include <cstdlib>
+#include <cerrno>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+
+namespace cuttlefish
+{
+
+void Binary_Unitig_Format::finalize(const std::string& path, const uint16_t k, const bool colored)
+{
+    const int fd = ::open(path.c_str(), O_RDWR);
+    struct stat st;
+    if(fd < 0 || ::fstat(fd, &st) != 0)
+    {
+        std::cerr << "Error opening binary unitig file at " << path << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    // The records are self-delimiting; only their leading words are visited.
+    const std::size_t sz = st.st_size;
+    std::vector<uint64_t> idx;
+    if(sz > 0)
+    {
+        void* const m = ::mmap(nullptr, sz, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(m == MAP_FAILED)
+        {
+            std::cerr << "Error mapping binary unitig file at " << path << ". Aborting.\n";
+            std::exit(EXIT_FAILURE);
+        }
+
+        ::madvise(m, sz, MADV_SEQUENTIAL);
+        const auto base = static_cast<const char*>(m);
+        std::size_t off = 0;
+        while(off + 2 * sizeof(uint64_t) <= sz)
+        {
+            uint64_t len, color_c;
+            std::memcpy(&len, base + off, sizeof(len));
+            std::memcpy(&color_c, base + off + sizeof(len), sizeof(color_c));
+
+            idx.push_back(off);
+            off += record_size(len, color_c);
+        }
+
+        ::munmap(m, sz);
+        if(off != sz)
+        {
+            std::cerr << "Malformed binary unitig file at " << path << ". Aborting.\n";
+            std::exit(EXIT_FAILURE);
+        }
+    }
+
+    Footer footer;
+    std::memcpy(footer.magic, magic, sizeof(magic));
+    footer.version = version;
+    footer.k = k;
+    footer.colored = colored;
+    footer.pad = 0;
+    footer.count = idx.size();
+    footer.idx_off = sz;
+    idx.push_back(sz);
+
+    std::string tail(idx.size() * sizeof(uint64_t) + sizeof(footer), '\0');
+    std::memcpy(tail.data(), idx.data(), idx.size() * sizeof(uint64_t));
+    std::memcpy(tail.data() + idx.size() * sizeof(uint64_t), &footer, sizeof(footer));
+
+    std::size_t rem = tail.size();
+    const char* buf = tail.data();
+    off_t pos = sz;
+    while(rem > 0)
+    {
+        const auto w = ::pwrite(fd, buf, rem, pos);
+        if(w < 0 && errno == EINTR)
+            continue;
+
+        if(w <= 0)
+        {
+            std::cerr << "Error writing index of binary unitig file at " << path << ". Aborting.\n";
+            std::exit(EXIT_FAILURE);
+        }
+
+        buf += w, rem -= w, pos += w;
+    }
+
+    if(::close(fd) != 0)
+    {
+        std::cerr << "Error closing binary unitig file at " << path << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+}
+
+}
@@ -0,0 +1,63 @@
+
+#include "Binary_Unitig_Reader.hpp"
+
+#include <iostream>
+#include <cstdlib>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+
+namespace cuttlefish
+{
+
+Binary_Unitig_Reader::Binary_Unitig_Reader(const std::string& path):
+      path_(path)
+    , sz(0)
+    , base(nullptr)
+    , idx(nullptr)
+{
+    const int fd = ::open(path_.c_str(), O_RDONLY);
+    struct stat st;
+    if(fd < 0 || ::fstat(fd, &st) != 0)
+    {
+        std::cerr << "Error opening binary unitig file at " << path_ << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    sz = st.st_size;
+    if(sz < sizeof(footer))
+    {
+        std::cerr << "Binary unitig file at " << path_ << " is truncated. Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    void* const m = ::mmap(nullptr, sz, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if(m == MAP_FAILED)
+    {
+        std::cerr << "Error mapping binary unitig file at " << path_ << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    base = static_cast<const char*>(m);
+    std::memcpy(&footer, base + sz - sizeof(footer), sizeof(footer));
+    if(std::memcmp(footer.magic, Binary_Unitig_Format::magic, sizeof(footer.magic)) != 0 || footer.version != Binary_Unitig_Format::version ||
+        footer.idx_off % sizeof(uint64_t) != 0 || footer.idx_off + (footer.count + 1) * sizeof(uint64_t) + sizeof(footer) != sz)
+    {
+        std::cerr << "File at " << path_ << " is not a valid binary unitig file. Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    idx = reinterpret_cast<const uint64_t*>(base + footer.idx_off);
+}
+
+
+Binary_Unitig_Reader::~Binary_Unitig_Reader()
+{
+    if(base != nullptr)
+        ::munmap(const_cast<char*>(base), sz);
+}
+
+}
@@ -17,6 +17,9 @@ Build_Params::Build_Params( const bool is_read_graph,
                             const std::size_t vertex_part_count,
                             const std::size_t lmtig_bucket_count,
                             const std::size_t gmtig_bucket_count,
+                            const bool resume,
+                            const bool positional_output,
+                            const bool gzip_output,
                             const std::string& vertex_db_path,
                             const std::string& edge_db_path,
                             const uint16_t thread_count,
@@ -47,6 +50,9 @@ Build_Params::Build_Params( const bool is_read_graph,
     vertex_part_count_(vertex_part_count),
     lmtig_bucket_count_(lmtig_bucket_count),
     gmtig_bucket_count_(gmtig_bucket_count),
+    resume_(resume),
+    positional_output_(positional_output),
+    gzip_output_(gzip_output),
     vertex_db_path_(vertex_db_path),
     edge_db_path_(edge_db_path),
     thread_count_(thread_count),
@@ -85,6 +91,9 @@ const std::string Build_Params::output_file_ext() const
     case cuttlefish::Output_Format::gfa2:
         return cuttlefish::file_ext::gfa2_ext;
 
+    case cuttlefish::Output_Format::bin:
+        return cuttlefish::file_ext::bin_ext;
+
     default:
         break;
     }
@@ -156,6 +165,45 @@ bool Build_Params::is_valid() const
         std::cout << "Both a memory bound and the option for unrestricted memory usage specified. Unrestricted memory mode will be used.\n";
 
 
+    // The sizes of colored records are not known before their reduction.
+    if(positional_output_ && color_)
+        std::cout << "Positional output is not supported for colored graphs. Streamed output will be used.\n";
+
+    // Compressed output is produced through the streaming sink only.
+    if(positional_output_ && gzip_output_)
+        std::cout << "Positional output is not supported for compressed output. Streamed output will be used.\n";
+
+    const auto gfa = (output_format() == cuttlefish::Output_Format::gfa1 || output_format() == cuttlefish::Output_Format::gfa2);
+
+    // The segment IDs are assigned as the maximal unitigs are output.
+    if(positional_output_ && gfa)
+        std::cout << "Positional output is not supported for GFA output. Streamed output will be used.\n";
+
+
+    // GFA segments do not carry colors.
+    if(color_ && gfa)
+    {
+        std::cout << "GFA output is not supported for colored graphs.\n";
+        valid = false;
+    }
+
+
+    // Path covers glue unitigs of different colors, and are not graphs.
+    if(path_cover_ && (color_ || gfa))
+    {
+        std::cout << "Path covers are supported only for uncolored graphs, in the FASTA or the binary output format.\n";
+        valid = false;
+    }
+
+
+    // The binary output is to be memory-mapped, hence not to be compressed.
+    if(gzip_output_ && output_format() == cuttlefish::Output_Format::bin)
+    {
+        std::cout << "The binary output format can not be compressed.\n";
+        valid = false;
+    }
+
+
     if(is_read_graph_ || is_ref_graph_) // Validate Cuttlefish 2 specific arguments.
     {
         // Read and reference de Bruijn graph parameters can not be mixed with.
@@ -196,7 +244,7 @@ bool Build_Params::is_valid() const
 
 
         // Cuttlefish 2 specific arguments can not be specified.
-        if(cutoff_ || path_cover_)
+        if(cutoff_)
         {
             std::cout << "Cuttlefish 2 specific arguments specified while using Cuttlefish 1.\n";
             valid = false;
@@ -1,19 +1,32 @@
 
 #include "Color_Repo.hpp"
+#include "elias_fano/sequence.hpp"
 #include "parlay/parallel.h"
 
 #include <cstdint>
+#include <cstring>
 #include <algorithm>
+#include <functional>
+#include <fstream>
+#include <iostream>
+#include <cstdlib>
 
 
 namespace cuttlefish
 {
 
-void Color_Repo::init(const std::string& path)
+void Color_Repo::init(const std::string& path, const std::size_t worker_mem_bytes)
 {
+    // A color-set takes at least a word in its bucket besides its offset, so
+    // four-fifths of the memory goes to the color-bucket.
+    const auto B_mem_bytes = worker_mem_bytes / 5 * 4;
+    const auto O_mem_bytes = worker_mem_bytes / 5;
+
     B.reserve(parlay::num_workers());
+    O.reserve(parlay::num_workers());
     for(uint32_t w_id = 0; w_id < parlay::num_workers(); ++w_id)
-        B.emplace_back(bucket_t(path + "." + std::to_string(w_id), 32 * 1024));
+        B.emplace_back(bucket_t(path + "." + std::to_string(w_id), 32 * 1024, B_mem_bytes)),
+        O.emplace_back(bucket_t(path + ".off." + std::to_string(w_id), 8 * 1024, O_mem_bytes));
 }
 
 
@@ -32,7 +45,7 @@ std::size_t Color_Repo::bytes() const
         sz += b.unwrap().size();
     });
 
-    return sz * sizeof(source_id_t);
+    return sz * sizeof(uint64_t);
 }
 
 
@@ -42,6 +55,98 @@ void Color_Repo::close()
         [&](const std::size_t w)
         {
             B[w].unwrap().serialize();
+            O[w].unwrap().serialize();
+        }, 1);
+}
+
+
+void Color_Repo::finalize(const std::string& path, const uint64_t source_c)
+{
+    const auto w_c = B.size();
+    std::vector<uint64_t> base(w_c + 1, 0); // `base[w]` is the word-offset of the color-sets of worker `w`.
+    uint64_t set_c = 0;
+    for(std::size_t w = 0; w < w_c; ++w)
+        base[w + 1] = base[w] + B[w].unwrap().size(),
+        set_c += O[w].unwrap().size();
+
+    const auto word_c = base[w_c];
+
+    // The worker-local offsets are shifted to the concatenation of the buckets.
+    std::vector<uint64_t> off(set_c + 1);
+    uint64_t* p = off.data();
+    for(std::size_t w = 0; w < w_c; ++w)
+    {
+        const auto& o_w = O[w].unwrap();
+        const auto sz = o_w.load(p);
+        std::for_each(p, p + sz, [b = base[w]](auto& o){ o += b; });
+        p += sz;
+    }
+
+    off.back() = word_c;
+    elias_fano::sequence<true> ef;
+    ef.encode(off.cbegin(), off.size(), off.back());
+    force_free(off);
+
+    std::ofstream output(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if(!output)
+    {
+        std::cerr << "Error opening the color-repository at " << path << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    constexpr std::size_t chunk_words = 1024 * 1024;    // 8 MB chunks are copied from the buckets.
+    std::vector<uint64_t> chunk(chunk_words);
+    for(std::size_t w = 0; w < w_c; ++w)
+    {
+        const auto& b = B[w].unwrap();
+        if(!b.spilled())
+        {
+            // The bucket never left memory.
+            output.write(reinterpret_cast<const char*>(b.in_memory_data()), b.size() * sizeof(uint64_t));
+            continue;
+        }
+
+        std::ifstream input(b.file_path, std::ios::in | std::ios::binary);
+        for(uint64_t rem = b.size(); rem > 0; )
+        {
+            const auto sz = std::min(rem, static_cast<uint64_t>(chunk_words));
+            input.read(reinterpret_cast<char*>(chunk.data()), sz * sizeof(uint64_t));
+            if(!input)
+            {
+                std::cerr << "Error reading the color-bucket at " << b.file_path << ". Aborting.\n";
+                std::exit(EXIT_FAILURE);
+            }
+
+            output.write(reinterpret_cast<const char*>(chunk.data()), sz * sizeof(uint64_t));
+            rem -= sz;
+        }
+    }
+
+    output.write(reinterpret_cast<const char*>(base.data()), base.size() * sizeof(uint64_t));
+
+    Footer footer;
+    std::memcpy(footer.magic, magic, sizeof(magic));
+    footer.version = version;
+    footer.worker_c = w_c;
+    footer.count = set_c;
+    footer.word_c = word_c;
+    footer.source_c = source_c;
+    footer.ef_off = (word_c + base.size()) * sizeof(uint64_t);
+    elias_fano::essentials::save(ef, std::ref(output));
+    output.write(reinterpret_cast<const char*>(&footer), sizeof(footer));
+
+    output.close();
+    if(!output)
+    {
+        std::cerr << "Error writing the color-repository at " << path << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    parlay::parallel_for(0, w_c,
+        [&](const std::size_t w)
+        {
+            B[w].unwrap().remove();
+            O[w].unwrap().remove();
         }, 1);
 }
 
@@ -0,0 +1,78 @@
+
+#include "Color_Repo_Reader.hpp"
+
+#include <cstring>
+#include <functional>
+#include <fstream>
+#include <iostream>
+#include <cstdlib>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+
+namespace cuttlefish
+{
+
+Color_Repo_Reader::Color_Repo_Reader(const std::string& path):
+      path_(path)
+    , sz(0)
+    , base(nullptr)
+    , W(nullptr)
+    , B(nullptr)
+{
+    const int fd = ::open(path_.c_str(), O_RDONLY);
+    struct stat st;
+    if(fd < 0 || ::fstat(fd, &st) != 0)
+    {
+        std::cerr << "Error opening color-repository at " << path_ << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    sz = st.st_size;
+    if(sz < sizeof(footer))
+    {
+        std::cerr << "Color-repository at " << path_ << " is truncated. Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    void* const m = ::mmap(nullptr, sz, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if(m == MAP_FAILED)
+    {
+        std::cerr << "Error mapping color-repository at " << path_ << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    base = static_cast<const char*>(m);
+    std::memcpy(&footer, base + sz - sizeof(footer), sizeof(footer));
+    if(std::memcmp(footer.magic, Color_Repo::magic, sizeof(footer.magic)) != 0 || footer.version != Color_Repo::version ||
+        footer.ef_off != (footer.word_c + footer.worker_c + 1) * sizeof(uint64_t) || footer.ef_off + sizeof(footer) > sz)
+    {
+        std::cerr << "File at " << path_ << " is not a valid color-repository. Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    W = reinterpret_cast<const uint64_t*>(base);
+    B = W + footer.word_c;
+
+    // The offsets are small, and are loaded in memory.
+    std::ifstream input(path_, std::ios::in | std::ios::binary);
+    input.seekg(footer.ef_off, std::ios::beg);
+    elias_fano::essentials::load(off, std::ref(input));
+    if(!input || off.size() != footer.count + 1)
+    {
+        std::cerr << "Error loading the color-set offsets from " << path_ << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+}
+
+
+Color_Repo_Reader::~Color_Repo_Reader()
+{
+    if(base != nullptr)
+        ::munmap(const_cast<char*>(base), sz);
+}
+
+}
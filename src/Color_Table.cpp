@@ -1,16 +1,87 @@
 
 #include "Color_Table.hpp"
+#include "parlay/parallel.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
 
 
 namespace cuttlefish
 {
 
-Color_Table::Color_Table():
-#ifndef USE_PARLAY_HASH
-      M(map_sz_init)
-#else
-      M(map_sz_init, false)
-#endif
-{}
+Color_Table::Color_Table(const uint64_t cap):
+      level_c(0)
+    , claim_c(parlay::num_workers(), Padded<uint64_t>(0))
+{
+    add_level(ceil_pow_2(std::max(static_cast<uint64_t>(cap / lf), min_level_cap)), 0);
+}
+
+
+Color_Table::~Color_Table()
+{
+    const auto n = level_c.load();
+    for(uint32_t l = 0; l < n; ++l)
+        deallocate(L[l].T);
+}
+
+
+uint64_t Color_Table::size() const
+{
+    uint64_t sz = 0;
+    for(const auto& c : claim_c)
+        sz += __atomic_load_n(&c.unwrap(), __ATOMIC_RELAXED);
+
+    return sz;
+}
+
+
+void Color_Table::add_level(const uint64_t cap, const uint64_t base)
+{
+    const auto n = level_c.load(std::memory_order_relaxed);
+    if(n == max_level_c)
+    {
+        std::cerr << "Color-table exceeded its maximum number of levels. Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    auto& lev = L[n];
+    lev.T = allocate_zeroed<Slot>(cap);
+    lev.cap = cap;
+    lev.shift = 64 - __builtin_ctzll(cap);
+    lev.base = base;
+    if(lev.T == nullptr)
+    {
+        std::cerr << "Failed to allocate a color-table level of " << cap << " slots. Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    level_c.store(n + 1, std::memory_order_release);
+}
+
+
+void Color_Table::grow(const uint32_t n, const bool force)
+{
+    if(growing.test_and_set(std::memory_order_acquire))
+        return;
+
+    if(level_c.load(std::memory_order_relaxed) == n)
+    {
+        const auto& lev = L[n - 1];
+        const auto sz = size();
+        if(force || sz - lev.base > lf * lev.cap)
+            // The new level is to take in as many color-hashes as seen till now.
+            add_level(ceil_pow_2(std::max(static_cast<uint64_t>(sz / lf), lev.cap)), sz);
+    }
+
+    growing.clear(std::memory_order_release);
+}
+
+
+void Color_Table::await_level(const uint32_t n)
+{
+    while(level_c.load(std::memory_order_acquire) <= n)
+        grow(n, true);
+}
 
 }
@@ -14,14 +14,17 @@ namespace cuttlefish
 {
 
 template <uint16_t k, bool Colored_>
-Contracted_Graph_Expander<k, Colored_>::Contracted_Graph_Expander(Discontinuity_Graph<k, Colored_>& G, P_v_t& P_v, P_e_t& P_e, const Data_Logistics& logistics):
+Contracted_Graph_Expander<k, Colored_>::Contracted_Graph_Expander(Discontinuity_Graph<k, Colored_>& G, P_v_t& P_v, P_e_t& P_e, const Data_Logistics& logistics, const Memory_Budget& budget, const bool retain_input):
       G(G)
     , P_v(P_v)
     , P_e(P_e)
     , compressed_diagonal_path(logistics.compressed_diagonal_path())
-    , M(G.vertex_part_size_upper_bound())
+    , M(G.vertex_part_size_estimate(1))
+    , buf_bytes_w(budget.buffer_bytes(Memory_Budget::Stage::expand, buf_bytes, 2 * parlay::num_workers(), min_buf_bytes, decltype(M)::bytes(G.vertex_part_size_upper_bound())))
+    , retain_input(retain_input)
 {
-    std::cerr << "Hash table capacity during expansion: " << M.capacity() << ".\n";
+    std::cerr << "Initial hash table capacity during expansion: " << M.capacity() << ".\n";
+    std::cerr << "Read-buffer size during expansion: " << buf_bytes_w << " bytes.\n";
 }
 
 
@@ -39,8 +42,8 @@ void Contracted_Graph_Expander<k, Colored_>::expand()
 
     std::vector<Padded<Buffer<Obj_Path_Info_Pair<Kmer<k>, k>>>> B_p_v(parlay::num_workers());
     std::vector<Padded<Buffer<Discontinuity_Edge<k>>>> B_e(parlay::num_workers());
-    constexpr std::size_t buf_cap_p_v = 1 * 1024 * 1024 / sizeof(Obj_Path_Info_Pair<Kmer<k>, k>);   // 1 MB read-capacity.
-    constexpr std::size_t buf_cap_e = 1 * 1024 * 1024 / sizeof(Discontinuity_Edge<k>);  // 1 MB read-capacity.
+    const std::size_t buf_cap_p_v = buf_bytes_w / sizeof(Obj_Path_Info_Pair<Kmer<k>, k>);
+    const std::size_t buf_cap_e = buf_bytes_w / sizeof(Discontinuity_Edge<k>);
     parlay::parallel_for(0, parlay::num_workers(),
         [&](const auto i) { B_p_v[i].unwrap().resize_uninit(buf_cap_p_v), B_e[i].unwrap().resize_uninit(buf_cap_e); });
 
@@ -51,7 +54,7 @@ void Contracted_Graph_Expander<k, Colored_>::expand()
         std::cerr << "\rPart: " << i;
 
         auto t_s = now();
-        M.clear();
+        M.clear(G.vertex_part_size_estimate(i));
         auto t_e = now();
         map_clr_time += duration(t_e - t_s);
 
@@ -156,15 +159,8 @@ void Contracted_Graph_Expander<k, Colored_>::expand()
 
     const auto t_s = now();
 
-    // Remove the vertices' path-information buckets.
-    parlay::parallel_for(1, P_v.size(), [&](const auto i){ P_v[i].unwrap().remove(); });
-
-    // Remove the edge-matrix.
-    parlay::parallel_for(1, v_part_c + 1,
-    [&](const auto j)
-    {
-        parlay::parallel_for(0, j + 1, [&](const auto i){ G.E().remove_block(i, j); }, 1);
-    }, 1);
+    if(!retain_input)
+        remove_input(G, P_v, compressed_diagonal_path);
 
     const auto t_e = now();
     const auto rm_time = duration(t_e - t_s);
@@ -180,6 +176,30 @@ void Contracted_Graph_Expander<k, Colored_>::expand()
 }
 
 
+template <uint16_t k, bool Colored_>
+void Contracted_Graph_Expander<k, Colored_>::remove_input(Discontinuity_Graph<k, Colored_>& G, P_v_t& P_v, const std::string& diagonal_path)
+{
+    const auto v_part_c = G.E().vertex_part_count();
+
+    // Remove the vertices' path-information buckets.
+    parlay::parallel_for(1, P_v.size(), [&](const auto i){ P_v[i].unwrap().remove(); });
+
+    // Remove the edge-matrix, and the contracted diagonal blocks if not consumed already.
+    parlay::parallel_for(1, v_part_c + 1,
+    [&](const auto j)
+    {
+        parlay::parallel_for(0, j + 1, [&](const auto i){ G.E().remove_block(i, j); }, 1);
+
+        const std::string d_j_path(diagonal_path + "/" + std::to_string(j));
+        if(file_exists(d_j_path) && !remove_file(d_j_path))
+        {
+            std::cerr << "Error removing contracted edge block at " << d_j_path << ". Aborting.\n";
+            std::exit(EXIT_FAILURE);
+        }
+    }, 1);
+}
+
+
 template <uint16_t k, bool Colored_>
 void Contracted_Graph_Expander<k, Colored_>::expand_diagonal_block(const std::size_t i)
 {
@@ -197,7 +217,7 @@ void Contracted_Graph_Expander<k, Colored_>::expand_diagonal_block(const std::si
     parlay::par_do(
         [&]()
         {
-            if(!input || !remove_file(d_i_path))
+            if(!input || (!retain_input && !remove_file(d_i_path)))
             {
                 std::cerr << "Error reading / removing of contracted edge block from " << d_i_path << ". Aborting.\n";
                 std::exit(EXIT_FAILURE);
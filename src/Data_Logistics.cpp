@@ -96,3 +96,27 @@ const std::string Data_Logistics::unitig_coord_buckets_path() const
 {
     return params.working_dir_path() + filename(params.output_prefix()) + cuttlefish::file_ext::unitig_coord_bucket_ext;
 }
+
+
+const std::string Data_Logistics::unitig_end_buckets_path() const
+{
+    return params.working_dir_path() + filename(params.output_prefix()) + cuttlefish::file_ext::unitig_end_bucket_ext;
+}
+
+
+const std::string Data_Logistics::path_cover_segments_path() const
+{
+    return params.working_dir_path() + filename(params.output_prefix()) + cuttlefish::file_ext::path_cover_seg_ext;
+}
+
+
+const std::string Data_Logistics::phase_manifest_path() const
+{
+    return params.working_dir_path() + filename(params.output_prefix()) + cuttlefish::file_ext::phase_manifest_ext;
+}
+
+
+const std::string Data_Logistics::checkpoint_path() const
+{
+    return params.working_dir_path() + filename(params.output_prefix()) + cuttlefish::file_ext::checkpoint_ext;
+}
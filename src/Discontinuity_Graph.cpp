@@ -11,8 +11,9 @@ namespace cuttlefish
 
 
 template <uint16_t k, bool Colored_>
-Discontinuity_Graph<k, Colored_>::Discontinuity_Graph(const Build_Params& params, const Data_Logistics& logistics):
+Discontinuity_Graph<k, Colored_>::Discontinuity_Graph(const Build_Params& params, const uint64_t graph_count, const Data_Logistics& logistics, const Memory_Budget& budget):
       min_len(params.min_len())
+    , graph_count(graph_count)
     , E_(params.vertex_part_count(), logistics.edge_matrix_path())
     , lmtigs(logistics.lmtig_buckets_path(), params.lmtig_bucket_count(), parlay::num_workers(), Colored_)
     , phantom_edge_count_(0)
@@ -20,10 +21,16 @@ Discontinuity_Graph<k, Colored_>::Discontinuity_Graph(const Build_Params& params
 {
     if constexpr(Colored_)
     {
+        typedef Ext_Mem_Bucket<Vertex_Color_Mapping> bucket_t;
+
+        // Small mappings are kept in memory, within a sixteenth of the budget
+        // of the subgraphs-stage where they are produced.
+        const auto mem_bytes = budget.buffer_bytes(Memory_Budget::Stage::subgraphs, vertex_color_pref_mem_bytes, 16 * lmtigs.bucket_count(), bucket_t::in_memory_bytes);
+
         vertex_color_map_.reserve(lmtigs.bucket_count());
         vertex_color_map_.emplace_back(std::string());
         for(std::size_t b = 1; b < lmtigs.bucket_count(); ++b)
-            vertex_color_map_.emplace_back(logistics.lmtig_buckets_path() + "/" + std::to_string(b) + ".col");
+            vertex_color_map_.emplace_back(bucket_t(logistics.lmtig_buckets_path() + "/" + std::to_string(b) + ".col", bucket_t::in_memory_bytes, mem_bytes));
     }
 }
 
@@ -31,6 +38,7 @@ Discontinuity_Graph<k, Colored_>::Discontinuity_Graph(const Build_Params& params
 template <uint16_t k, bool Colored_>
 Discontinuity_Graph<k, Colored_>::Discontinuity_Graph(cereal::BinaryInputArchive& archive):
       min_len()
+    , graph_count()
     , E_(archive)
     , lmtigs(archive)
     , max_source_id_()
@@ -39,6 +47,17 @@ Discontinuity_Graph<k, Colored_>::Discontinuity_Graph(cereal::BinaryInputArchive
 }
 
 
+template <uint16_t k, bool Colored_>
+std::size_t Discontinuity_Graph<k, Colored_>::vertex_color_map_mem_bytes() const
+{
+    std::size_t bytes = 0;
+    for(const auto& b : vertex_color_map_)
+        bytes += b.unwrap().max_mem_elems * sizeof(Vertex_Color_Mapping);
+
+    return bytes;
+}
+
+
 template <uint16_t k, bool Colored_>
 uint64_t Discontinuity_Graph<k, Colored_>::phantom_edge_upper_bound() const
 {
@@ -46,11 +65,20 @@ uint64_t Discontinuity_Graph<k, Colored_>::phantom_edge_upper_bound() const
 }
 
 
+template <uint16_t k, bool Colored_>
+void Discontinuity_Graph<k, Colored_>::close_lmtigs()
+{
+    lmtigs.close();
+
+    if constexpr(Colored_)
+        parlay::parallel_for(1, vertex_color_map_.size(), [&](const auto b){ vertex_color_map_[b].unwrap().serialize(); });
+}
+
+
 template <uint16_t k, bool Colored_>
 void Discontinuity_Graph<k, Colored_>::close()
 {
     E_.close();
-    lmtigs.close();
 }
 
 
@@ -59,15 +87,31 @@ std::size_t Discontinuity_Graph<k, Colored_>::vertex_part_size_upper_bound() con
 {
     std::size_t bound = 0;
     for(std::size_t j = 1; j <= E_.vertex_part_count(); ++j)
-        // Each *original* edge from the non-diagonal blocks of column `j` corresponds to a
-        // unique vertex of partition `j`, and in the worst-case, each original edge from the
-        // diagonal block corresponds to two unique vertices.
-        bound = std::max(bound, E_.col_size(j) + E_.block_size(j, j));
+        bound = std::max(bound, vertex_part_size_upper_bound(j));
 
     return bound;
 }
 
 
+template <uint16_t k, bool Colored_>
+std::size_t Discontinuity_Graph<k, Colored_>::vertex_part_size_upper_bound(const std::size_t j) const
+{
+    // Each *original* edge from the non-diagonal blocks of column `j` corresponds to a
+    // unique vertex of partition `j`, and in the worst-case, each original edge from the
+    // diagonal block corresponds to two unique vertices.
+    return E_.col_size(j) + E_.block_size(j, j);
+}
+
+
+template <uint16_t k, bool Colored_>
+std::size_t Discontinuity_Graph<k, Colored_>::vertex_part_size_estimate(const std::size_t j) const
+{
+    // The bound counts the incidences of the edges to partition `j`, and a
+    // discontinuity vertex typically has edges at both its sides.
+    return (vertex_part_size_upper_bound(j) + 1) / 2;
+}
+
+
 template <uint16_t k, bool Colored_>
 bool Discontinuity_Graph<k, Colored_>::is_discontinuity(const char* const seq) const
 {
@@ -79,9 +123,7 @@ bool Discontinuity_Graph<k, Colored_>::is_discontinuity(const char* const seq) c
     min_it_t::minimizer(seq, min_len, min_seed, min_l, h_l, idx_l);
     min_it_t::minimizer(seq + 1, min_len, min_seed, min_r, h_r, idx_r);
 
-    // const auto graph_id = [&](const auto h){ return h & (params.subgraph_count() - 1); };
-    // TODO: update.
-    const auto graph_id = [&](const auto h){ return h & (128 * 128 - 1); };
+    const auto graph_id = [&](const auto h){ return h & (graph_count - 1); };
     return graph_id(h_l) != graph_id(h_r);
 }
 
@@ -17,16 +17,20 @@ namespace cuttlefish
 {
 
 template <uint16_t k, bool Colored_>
-Discontinuity_Graph_Contractor<k, Colored_>::Discontinuity_Graph_Contractor(Discontinuity_Graph<k, Colored_>& G, P_v_t& P_v, const Data_Logistics& logistics):
+Discontinuity_Graph_Contractor<k, Colored_>::Discontinuity_Graph_Contractor(Discontinuity_Graph<k, Colored_>& G, P_v_t& P_v, const Data_Logistics& logistics, const Memory_Budget& budget):
       G(G)
     , P_v(P_v)
     , compressed_diagonal_path(logistics.compressed_diagonal_path())
-    , M(G.vertex_part_size_upper_bound())
+    , M(G.vertex_part_size_estimate(G.E().vertex_part_count()))
+    , buf_cap(budget.buffer_bytes(Memory_Budget::Stage::contract, buf_bytes, parlay::num_workers(), min_buf_bytes, decltype(M)::bytes(G.vertex_part_size_upper_bound()) + 2 * read_ahead_bytes) / sizeof(Discontinuity_Edge<k>))
+    , D_j(parlay::num_workers())
     , D_c(parlay::num_workers())
+    , N(0)
     , phantom_count_(0)
     , icc_count(0)
 {
-    std::cerr << "Hash table capacity during contraction: " << M.capacity() << ".\n";
+    std::cerr << "Initial hash table capacity during contraction: " << M.capacity() << ".\n";
+    std::cerr << "Edge-read buffer capacity during contraction: " << buf_cap << ".\n";
 }
 
 
@@ -43,15 +47,21 @@ void Discontinuity_Graph_Contractor<k, Colored_>::contract()
     // TODO: document the phases.
 
     std::vector<Padded<Buffer<Discontinuity_Edge<k>>>> B(parlay::num_workers());    // Worker-local edge-read buffers.
-    constexpr std::size_t buf_cap = 1 * 1024 * 1024 / sizeof(Discontinuity_Edge<k>);    // 1 MB read-capacity.
     parlay::parallel_for(0, B.size(), [&](const auto w){ B[w].unwrap().resize_uninit(buf_cap); });
 
+    // The partitions are pipelined: the leading edges of partition `j - 1` are
+    // read ahead from disk while `j` is being contracted.
+    G.E().read_ahead_column(G.E().vertex_part_count(), read_ahead_bytes);
+
     for(auto j = G.E().vertex_part_count(); j >= 1; --j)
     {
         std::cerr << "\rPart: " << j;
 
+        if(j > 1)
+            G.E().read_ahead_column(j - 1, read_ahead_bytes);
+
         auto t_s = now();
-        M.clear();
+        M.clear(G.vertex_part_size_estimate(j)); // Only the prefix of the table expected for the partition is used; it overflows on demand.
         auto t_e = now();
         map_clr_time += duration(t_e - t_s);
 
@@ -59,7 +69,7 @@ void Discontinuity_Graph_Contractor<k, Colored_>::contract()
             [&]()
             {
                 const auto t_s = now();
-                contract_diagonal_block(j, B[parlay::worker_id()].unwrap());
+                contract_diagonal_block(j, B);
                 const auto t_e = now();
                 diag_comp_time += duration(t_e - t_s);
             }
@@ -137,7 +147,7 @@ void Discontinuity_Graph_Contractor<k, Colored_>::contract()
 
             if(!M.find(e.x()))  // `e.x()` has a false-phantom edge.
             {
-                assert(D.contains(e.x()) && D[e.x()].v() == e.y());
+                assert(N.find(e.x()));
                 phantom_count_++;
                 G.add_edge(e.x(), inv_side(e.s_x()));
                 M.insert(e.x(), Other_End(Discontinuity_Graph<k, Colored_>::phi(), side_t::back, inv_side(e.s_x()), true, 1, false));
@@ -145,7 +155,7 @@ void Discontinuity_Graph_Contractor<k, Colored_>::contract()
 
             if(!M.find(e.y()))  // `e.y()` has a false-phantom edge.
             {
-                assert(D.contains(e.y()) && D[e.y()].v() == e.x());
+                assert(N.find(e.y()));
                 phantom_count_++;
                 G.add_edge(e.y(), inv_side(e.s_y()));
                 M.insert(e.y(), Other_End(Discontinuity_Graph<k, Colored_>::phi(), side_t::back, inv_side(e.s_y()), true, 1, false));
@@ -213,73 +223,105 @@ void Discontinuity_Graph_Contractor<k, Colored_>::contract()
 
 
 template <uint16_t k, bool Colored_>
-void Discontinuity_Graph_Contractor<k, Colored_>::contract_diagonal_block(const std::size_t j, Buffer<Discontinuity_Edge<k>>& buf)
+void Discontinuity_Graph_Contractor<k, Colored_>::contract_diagonal_block(const std::size_t j, std::vector<Padded<Buffer<Discontinuity_Edge<k>>>>& B)
 {
-    D_j.clear();
-    D.clear();
-
-    constexpr std::size_t buf_cap = 1 * 1024 * 1024 / sizeof(Discontinuity_Edge<k>);
-    buf.reserve_uninit(buf_cap);
-    std::size_t read;
-    while((read = G.E().read_block_buffered(j, j, buf, buf_cap)) > 0)
-        for(std::size_t i = 0; i < read; ++i)
+    std::for_each(D_j.begin(), D_j.end(), [](auto& v){ v.unwrap().clear(); });
+    std::for_each(D_c.begin(), D_c.end(), [](auto& v){ v.unwrap().clear(); });
+
+    // Each edge-endpoint reserves an index; a vertex gets the index of its
+    // first endpoint to be linked. The indices are thus unique, but sparse.
+    const auto idx_c = 2 * G.E().block_size(j, j);
+    assert(idx_c < (1lu << 40));
+
+    N.clear(idx_c); // The table grows to the largest diagonal block.
+
+    V.reserve_uninit(idx_c);
+    mark.reserve_uninit(idx_c);
+    A.reserve_uninit(2 * idx_c);
+    J.reserve_uninit(2 * idx_c);
+    parlay::parallel_for(0, idx_c, [&](const std::size_t i){ mark[i] = 0; A[2 * i] = A[2 * i + 1] = Chain_Link(); });
+
+    std::atomic_uint64_t idx_beg(0);    // Beginning index to reserve for the next chunk of edges read.
+    const auto link_diagonal_edges = [&](auto)
+    {
+        auto& buf = B[parlay::worker_id()].unwrap();
+        std::size_t read;
+        while((read = G.E().read_block_buffered(j, j, buf, buf_cap)) > 0)
         {
-            const auto& e = buf[i];
-            const auto end_x = D.find(e.x());
-            const auto end_y = D.find(e.y());
-
-            const auto& u  = (end_x != D.end() ? end_x->second.v() : e.x());
-            const auto s_u = (end_x != D.end() ? end_x->second.s_v() : e.s_x());
-            const auto w_u = (end_x != D.end() ? end_x->second.w() : 0);
-            const auto& v  = (end_y != D.end() ? end_y->second.v() : e.y());
-            const auto s_v = (end_y != D.end() ? end_y->second.s_v() : e.s_y());
-            const auto w_v = (end_y != D.end() ? end_y->second.w() : 0);
-            const auto w   = w_u + e.w() + w_v;
-
-            assert(G.E().partition(u) == j);
-            assert(G.E().partition(v) == j);
-
-            // When adding an `{u, v}` edge, if an `{u, v}` edge already exists,
-            // then it's an Isolated Cordless Cycle (ICC). In this case, if `u ≠ v`,
-            // then the current contracted form of the ICC resides entirely in this
-            // diagonal block. Otherwise, the ICC has already been contracted down
-            // to a single vertex that has a self-loop right now.
-            // In both cases, form a meta-vertex with `u` having rank `1`.
-            // In both cases, information-propagation through the side of `u`
-            // "facing outward" of the linearized cycle needs to be discarded, but
-            // the single lm-tig there has to be included in the maximal unitig
-            // label. This forms a tricky and cumbersome special case.
-
-            if(CF_UNLIKELY(u == v)) // The ICC has already been contracted to a single vertex.
-            {
-                assert(e.x() == e.y() && e.x() == u); assert(e.w() > 1);
-                D.insert_or_assign(u, Other_End(Discontinuity_Graph<k, Colored_>::phi(), side_t::back, side_t::front, true, 1, false, true));
-                form_meta_vertex(u, j, side_t::front, 1, w, true);
-                icc_count++;
-            }
-            else if(CF_UNLIKELY(u == e.y() && v == e.x()))  // The currently contracted form of the actual ICC resides in this diagonal block.
-            {
-                assert(e.x() != e.y());
-                assert(inv_side(s_u) == e.s_y()); assert(inv_side(s_v) == e.s_x());
+            const auto i_0 = idx_beg.fetch_add(2 * read);
+            for(std::size_t i = 0; i < read; ++i)
+                link_diagonal_edge(buf[i], i_0 + 2 * i);
+        }
+    };
 
-                D.insert_or_assign(u, Other_End(Discontinuity_Graph<k, Colored_>::phi(), side_t::back, inv_side(s_u), true, 1, false, true));
-                D.insert_or_assign(v, Other_End(Discontinuity_Graph<k, Colored_>::phi(), side_t::back, inv_side(s_v), true, 1, false, true));
-                form_meta_vertex(u, j, inv_side(s_u), 1, true); // Propagation needs to go through `s_u`, since `u` has already been connected to the other cycle members through that side.
-                icc_count++;
+    parlay::parallel_for(0, parlay::num_workers(), link_diagonal_edges, 1);
+    assert(idx_beg == idx_c);
+
+    jump_chains(idx_c);
+
+
+    // Each non-cycle vertex is linked to the endpoint of its chain having the
+    // smaller label; the edge from the other endpoint compresses the chain.
+    std::vector<Padded<std::vector<std::size_t>>> C(parlay::num_workers());    // `C[t]` contains the cycle-vertices found by worker `t`.
+    const auto link_to_chain_end = [&](const std::size_t i)
+    {
+        if(mark[i] == 0)
+            return;
+
+        std::size_t end[2];     // Indices of the endpoints of the chain, through each side of the vertex.
+        side_t s_end[2];    // Sides of the endpoints through which the chain enters them.
+        weight_t w_end[2];  // Weights of the chain-segments to the endpoints.
+        for(std::size_t s = 0; s < 2; ++s)
+        {
+            const auto& l = J[2 * i + s];
+            if(!l.present)  // The vertex itself is the endpoint through this side.
+                end[s] = i, s_end[s] = (s == 0 ? side_t::back : side_t::front), w_end[s] = 0;
+            else if(!l.is_end)  // The vertex is in a cycle.
+            {
+                C[parlay::worker_id()].unwrap().push_back(i);
+                return;
             }
             else
+                end[s] = l.v, s_end[s] = l.side(), w_end[s] = l.w;
+        }
+
+        assert(end[0] != end[1]);
+        const std::size_t s = (V[end[0]] < V[end[1]] ? 0 : 1);  // Side of the vertex towards its designated chain-endpoint.
+        if(end[s] == i)
+            return;
+
+        auto& D = (end[1 - s] == i ? D_c : D_j)[parlay::worker_id()].unwrap();
+        D.emplace_back(V[end[s]], s_end[s], V[i], s == 0 ? side_t::front : side_t::back, w_end[s], 0, 0, false, false, side_t::unspecified);
+    };
+
+    parlay::parallel_for(0, idx_c, link_to_chain_end);
+
+
+    // Isolated Cordless Cycles (ICC) reside entirely in a diagonal block. Each
+    // is linearized into a meta-vertex with a rank-1 vertex, discarding the
+    // information-propagation through its side facing outward of the cycle.
+    auto& D_icc = D_j[parlay::worker_id()].unwrap();
+    for(const auto& c_w : C)
+        for(const auto i : c_w.unwrap())
+            if(mark[i] == 1)    // Not visited yet.
             {
-                D.insert_or_assign(u, Other_End(v, s_v, s_u, false, w, true, true));
-                D.insert_or_assign(v, Other_End(u, s_u, s_v, false, w, true, true));
-                D_j.emplace_back(u, s_u, v, s_v, w, w == 1 ? e.b() : 0, w == 1 ? e.b_idx() : 0, false, false, side_t::unspecified);
+                linearize_cycle(i, D_icc);
+                form_meta_vertex(V[i], j, side_t::front, 1, true);
+                icc_count++;
             }
-    }
 
 
+    // The new edges are recorded such that the chain-compressing ones are at
+    // the end: the expansion traverses them in reverse, and these ensure that
+    // the designated endpoint of each chain has path-info before its other
+    // edges are expanded.
     std::filesystem::create_directories(compressed_diagonal_path);
     const auto d_j_path = compressed_diagonal_path + "/" + std::to_string(j);
     std::ofstream output(d_j_path);
-    output.write(reinterpret_cast<const char*>(D_j.data()), D_j.size() * sizeof(Discontinuity_Edge<k>));
+    for(const auto* const D : {&D_j, &D_c})
+        for(const auto& d : *D)
+            output.write(reinterpret_cast<const char*>(d.unwrap().data()), d.unwrap().size() * sizeof(Discontinuity_Edge<k>));
+
     if(!output)
     {
         std::cerr << "Error writing compressed diagonal edge block at " << d_j_path << ". Aborting.\n";
@@ -287,24 +329,117 @@ void Discontinuity_Graph_Contractor<k, Colored_>::contract_diagonal_block(const
     }
 
     output.close();
+}
 
 
-    std::for_each(D_c.begin(), D_c.end(), [](auto& v){ v.unwrap().clear(); });
-    const auto& kv = D.values();
-    const auto collect_compressed_diagonal_chains =
+template <uint16_t k, bool Colored_>
+inline std::size_t Discontinuity_Graph_Contractor<k, Colored_>::vertex_idx(const Kmer<k>& v, const std::size_t i)
+{
+    std::size_t* p_i;
+    if(!N.insert(v, i, p_i))
+        return *p_i;
+
+    V[i] = v;
+    mark[i] = 1;
+    return i;
+}
+
+
+template <uint16_t k, bool Colored_>
+inline void Discontinuity_Graph_Contractor<k, Colored_>::link_diagonal_edge(const Discontinuity_Edge<k>& e, const std::size_t i)
+{
+    const auto i_x = vertex_idx(e.x(), i);
+    const auto i_y = (e.y() == e.x() ? i_x : vertex_idx(e.y(), i + 1));
+
+    // Each side of a vertex has at most one edge, so the links of an entry are
+    // written by at most one worker each.
+    A[2 * i_x + (e.s_x() == side_t::back)] = Chain_Link(i_y, e.w(), e.s_y());
+    A[2 * i_y + (e.s_y() == side_t::back)] = Chain_Link(i_x, e.w(), e.s_x());
+}
+
+
+template <uint16_t k, bool Colored_>
+void Discontinuity_Graph_Contractor<k, Colored_>::jump_chains(const std::size_t idx_c)
+{
+    parlay::parallel_for(0, idx_c,
+    [&](const std::size_t i)
+    {
+        if(mark[i] == 0)
+            return;
+
+        for(std::size_t s = 0; s < 2; ++s)
+        {
+            auto l = A[2 * i + s];
+            if(l.present)
+                l.is_end = !A[2 * l.v + (1 - l.s)].present;
+
+            J[2 * i + s] = l;
+        }
+    });
+
+
+    // After round `r`, each link spans at least `2^r` edges or reaches the
+    // end of its chain. Rounds update the links in place: a link read mid-
+    // round is still a valid one, and spans at least as far as it did at the
+    // round's beginning. Links in cycles never reach an end.
+    std::size_t round_c = 1;
+    while((1lu << (round_c - 1)) < idx_c)
+        round_c++;
+
+    std::vector<Padded<std::size_t>> pending(parlay::num_workers());    // `pending[t]` is the count of links not reaching an end yet, found by worker `t`.
+    for(std::size_t r = 0; r < round_c; ++r)
+    {
+        std::for_each(pending.begin(), pending.end(), [](auto& p){ p.unwrap() = 0; });
+
+        parlay::parallel_for(0, idx_c,
         [&](const std::size_t i)
         {
-            const auto& u = kv[i].first;
-            const auto& end = kv[i].second;
-            if(!end.is_phi())   // Not an ICC.
+            if(mark[i] == 0)
+                return;
+
+            for(std::size_t s = 0; s < 2; ++s)
             {
-                assert(D.find(end.v()) != D.end());
-                if(u < end.v() && D[end.v()].v() == u)
-                    D_c[parlay::worker_id()].unwrap().emplace_back(u, end.s_u(), end.v(), end.s_v(), end.w(), 0, 0, false, false, side_t::unspecified);
+                const auto l = Chain_Link::load(J[2 * i + s]);
+                if(!l.present || l.is_end)
+                    continue;
+
+                const auto l_next = Chain_Link::load(J[2 * l.v + (1 - l.s)]);
+                assert(l_next.present);
+                Chain_Link::store(J[2 * i + s], Chain_Link(l_next.v, l.w + l_next.w, l_next.side(), l_next.is_end));
+                if(!l_next.is_end)
+                    pending[parlay::worker_id()].unwrap()++;
             }
-        };
+        });
 
-    parlay::parallel_for(0, D.size(), collect_compressed_diagonal_chains);
+        std::size_t p = 0;
+        std::for_each(pending.cbegin(), pending.cend(), [&](const auto& p_w){ p += p_w.unwrap(); });
+        if(p == 0)
+            break;
+    }
+}
+
+
+template <uint16_t k, bool Colored_>
+void Discontinuity_Graph_Contractor<k, Colored_>::linearize_cycle(const std::size_t r, std::vector<Discontinuity_Edge<k>>& D)
+{
+    // The traversal exits `r` through its back, and ends on re-entering it.
+    std::size_t i = r;
+    side_t s = side_t::back;
+    weight_t w = 0;
+    mark[r] = 2;
+    while(true)
+    {
+        const auto& l = A[2 * i + (s == side_t::back)];
+        assert(l.present);
+        if(l.v == r)
+            break;
+
+        i = l.v, w += l.w;
+        assert(mark[i] == 1);
+        mark[i] = 2;
+        D.emplace_back(V[r], side_t::back, V[i], l.side(), w, 0, 0, false, false, side_t::unspecified);
+        s = inv_side(l.side());
+    }
 }
 
 
@@ -0,0 +1,450 @@
+
+#include "Edge_Block.hpp"
+#include "lz4.h"
+
+#include <cstring>
+#include <utility>
+#include <fcntl.h>
+
+
+namespace cuttlefish
+{
+
+template <uint16_t k>
+Edge_Block<k>::Edge_Block(const std::string& file_path, const std::size_t buf_sz):
+      file_path(file_path)
+    , max_buf_bytes(buf_sz)
+    , max_buf_elems(max_buf_bytes / sizeof(edge_t))
+    , flushed(0)
+    , bytes_(0)
+    , buf_w_local(parlay::num_workers())
+    , scratch(parlay::num_workers())
+    , fd(-1)
+    , read_frame(0)
+    , read_bufs_pending(true)
+    , ra_frame_c(0)
+    , ra_pending(0)
+    , ra_state(ra_ready)
+{
+    assert(file_path.empty() || max_buf_elems > 0);
+
+    if(!file_path.empty())
+        open_file(true);
+
+
+    std::for_each(buf_w_local.begin(), buf_w_local.end(), [&](auto& v){ v.unwrap().reserve(max_buf_elems); });
+}
+
+
+template <uint16_t k>
+Edge_Block<k>::Edge_Block(Edge_Block&& rhs):
+      file_path(std::move(rhs.file_path))
+    , max_buf_bytes(rhs.max_buf_bytes)
+    , max_buf_elems(rhs.max_buf_elems)
+    , flushed(rhs.flushed)
+    , bytes_(rhs.bytes_)
+    , frames(std::move(rhs.frames))
+    , buf_w_local(std::move(rhs.buf_w_local))
+    , scratch(std::move(rhs.scratch))
+    , fd(rhs.fd)
+    , read_frame(rhs.read_frame)
+    , read_bufs_pending(rhs.read_bufs_pending)
+    , ra_buf(std::move(rhs.ra_buf))
+    , ra_frame_c(rhs.ra_frame_c)
+    , ra_pending(rhs.ra_pending.load())
+    , ra_req(std::move(rhs.ra_req))
+    , ra_state(rhs.ra_state.load())
+{
+    rhs.fd = -1;
+}
+
+
+template <uint16_t k>
+Edge_Block<k>::~Edge_Block()
+{
+    if(fd >= 0)
+    {
+        sync();
+        wait_read_ahead();
+        ::close(fd);
+    }
+}
+
+
+template <uint16_t k>
+void Edge_Block<k>::open_file(const bool truncate)
+{
+    fd = ::open(file_path.c_str(), O_RDWR | O_CREAT | (truncate ? O_TRUNC : 0), 0644);
+    if(fd < 0)
+    {
+        std::cerr << "Error opening edge-block at " << file_path << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+}
+
+
+template <uint16_t k>
+void Edge_Block<k>::flush(const std::size_t w)
+{
+    auto& buf = buf_w_local[w].unwrap();
+    assert(buf.size() <= max_buf_elems);
+
+    if(buf.empty())
+        return;
+
+    // The frame-buffer `out[cur]` was last written two flushes back, and that
+    // write has been waited on in the last flush.
+    auto& s = scratch[w].unwrap();
+    auto& out = s.out[s.cur];
+    s.packed.reserve_uninit(buf.size() * edge_t::max_packed_bytes());
+    const auto packed_bytes = edge_t::pack(buf.data(), buf.size(), s.packed.data());
+
+    const auto max_cmp_bytes = LZ4_compressBound(packed_bytes);
+    out.reserve_uninit(max_cmp_bytes);
+    auto bytes = LZ4_compress_default(reinterpret_cast<const char*>(s.packed.data()), reinterpret_cast<char*>(out.data()), packed_bytes, max_cmp_bytes);
+    if(bytes <= 0 || static_cast<std::size_t>(bytes) >= packed_bytes) // Incompressible frame; it is kept packed.
+    {
+        std::swap(s.packed, out);
+        bytes = packed_bytes;
+    }
+
+    lock_.lock();
+    const auto off = bytes_;
+    frames.push_back({off, static_cast<uint32_t>(bytes), static_cast<uint32_t>(packed_bytes), static_cast<uint32_t>(buf.size())});
+    bytes_ += bytes;
+    flushed += buf.size();
+    lock_.unlock();
+
+    auto& io = Async_IO::get();
+    if(!io.wait(s.req))
+    {
+        std::cerr << "Error writing to edge-block at " << file_path << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    io.write(s.req, fd, out.data(), bytes, off);
+    s.cur ^= 1;
+
+    buf.clear();
+}
+
+
+template <uint16_t k>
+void Edge_Block<k>::sync() const
+{
+    auto& io = Async_IO::get();
+    for(auto& s : scratch)
+        if(!io.wait(s.unwrap().req))
+        {
+            std::cerr << "Error writing to edge-block at " << file_path << ". Aborting.\n";
+            std::exit(EXIT_FAILURE);
+        }
+}
+
+
+template <uint16_t k>
+void Edge_Block<k>::close()
+{
+    for(std::size_t w = 0; w < buf_w_local.size(); ++w)
+    {
+        flush(w);
+        force_free(buf_w_local[w].unwrap());
+    }
+
+    sync();
+    for(auto& s_w : scratch)
+    {
+        auto& s = s_w.unwrap();
+        s.packed.free(), s.out[0].free(), s.out[1].free();
+    }
+}
+
+
+template <uint16_t k>
+void Edge_Block<k>::read(uint8_t* buf, std::size_t bytes, off_t off) const
+{
+    while(bytes > 0)
+    {
+        const auto r = ::pread(fd, buf, bytes, off);
+        if(r <= 0)
+        {
+            std::cerr << "Error reading from edge-block at " << file_path << ". Aborting.\n";
+            std::exit(EXIT_FAILURE);
+        }
+
+        buf += r, bytes -= r, off += r;
+    }
+}
+
+
+template <uint16_t k>
+std::size_t Edge_Block<k>::decode(const std::size_t f_beg, const std::size_t f_end, edge_t* const E) const
+{
+    auto& s = scratch[parlay::worker_id()].unwrap();
+    std::size_t edge_c = 0;
+
+    // The frames are contiguous in the block-file, and are read in batches of
+    // a bounded size.
+    for(std::size_t b = f_beg; b < f_end; )
+    {
+        const bool staged = (b < ra_frame_c);  // Whether the frame has been read ahead.
+        const bool from_ra = (staged && claim_read_ahead());    // Whether the batch is decoded from the read-ahead.
+        const auto e_max = (staged ? std::min(f_end, ra_frame_c) : f_end);  // Staged and unstaged frames are not batched together.
+        const auto off = (from_ra ? 0 : frames[b].off);  // Byte-offset of the batch-buffer in the block-file.
+        const uint8_t* in;  // The batch-buffer.
+        std::size_t e = b + 1;
+        if(from_ra)
+        {
+            e = e_max;
+            in = ra_buf.data();
+        }
+        else
+        {
+            while(e < e_max && frames[e].off + frames[e].bytes - off <= read_bytes)
+                e++;
+
+            const auto bytes = frames[e - 1].off + frames[e - 1].bytes - off;
+            s.in.reserve_uninit(bytes);
+            read(s.in.data(), bytes, off);
+            in = s.in.data();
+        }
+
+        for(std::size_t f = b; f < e; ++f)
+        {
+            const auto& frame = frames[f];
+            const uint8_t* packed = in + (frame.off - off);
+            if(frame.packed_bytes > frame.bytes)
+            {
+                s.packed.reserve_uninit(frame.packed_bytes);
+                const auto packed_bytes = LZ4_decompress_safe(reinterpret_cast<const char*>(packed), reinterpret_cast<char*>(s.packed.data()), frame.bytes, frame.packed_bytes);
+                if(packed_bytes != static_cast<int>(frame.packed_bytes))
+                {
+                    std::cerr << "Error decompressing a frame of edge-block at " << file_path << ". Aborting.\n";
+                    std::exit(EXIT_FAILURE);
+                }
+
+                packed = s.packed.data();
+            }
+
+            const auto unpacked_bytes = edge_t::unpack(packed, frame.edge_c, E + edge_c);
+            assert(unpacked_bytes == frame.packed_bytes);
+            (void)unpacked_bytes;
+            edge_c += frame.edge_c;
+        }
+
+        if(staged && ra_pending.fetch_sub(e - b) == e - b)   // The read-ahead has been consumed.
+            ra_buf.free();
+
+        b = e;
+    }
+
+    return edge_c;
+}
+
+
+template <uint16_t k>
+std::size_t Edge_Block<k>::copy_bufs(edge_t* const E) const
+{
+    auto cur_end = E;
+    for(const auto& buf_w : buf_w_local)
+    {
+        const auto& b = buf_w.unwrap();
+        if(CF_LIKELY(!b.empty()))   // Conditional to avoid UB on `nullptr` being passed to `memcpy`.
+            std::memcpy(static_cast<void*>(cur_end), static_cast<const void*>(b.data()), b.size() * sizeof(edge_t));
+        cur_end += b.size();
+    }
+
+    return cur_end - E;
+}
+
+
+template <uint16_t k>
+void Edge_Block<k>::free_read_scratch() const
+{
+    auto& s = scratch[parlay::worker_id()].unwrap();
+    s.in.free(), s.packed.free();
+}
+
+
+template <uint16_t k>
+void Edge_Block<k>::load(std::vector<edge_t>& v) const
+{
+    sync();
+
+    v.resize(size());
+    load(v.data());
+}
+
+
+template <uint16_t k>
+std::size_t Edge_Block<k>::load(edge_t* const b) const
+{
+    sync();
+
+    const auto file_sz = decode(0, frames.size(), b);
+    assert(file_sz == flushed);
+    const auto sz = file_sz + copy_bufs(b + file_sz);
+    free_read_scratch();
+
+    return sz;
+}
+
+
+template <uint16_t k>
+std::size_t Edge_Block<k>::read_buffered(Buffer<edge_t>& buf, const std::size_t n) const
+{
+    assert(buf.capacity() >= n);
+
+    sync();
+
+    // Whole frames are reserved, at least one if any remains.
+    lock_.lock();
+    const auto f_beg = read_frame;
+    std::size_t to_read = 0;
+    while(read_frame < frames.size() && (read_frame == f_beg || to_read + frames[read_frame].edge_c <= n))
+        to_read += frames[read_frame++].edge_c;
+    const auto f_end = read_frame;
+    lock_.unlock();
+
+    if(f_end > f_beg)
+    {
+        buf.reserve_uninit(to_read);
+        return decode(f_beg, f_end, buf.data());
+    }
+
+    // Reading from the file has been depleted.
+    free_read_scratch();
+
+    bool to_copy = false;
+    lock_.lock();
+
+    if(read_bufs_pending)
+        read_bufs_pending = false,
+        to_copy = true;
+
+    lock_.unlock();
+
+    if(to_copy) // Whether edges are pending in the worker-local buffers.
+    {
+        buf.reserve_uninit(size() - flushed);
+        return copy_bufs(buf.data());
+    }
+
+    return 0;
+}
+
+
+template <uint16_t k>
+void Edge_Block<k>::wait_read_ahead() const
+{
+    if(!Async_IO::get().wait(ra_req))
+    {
+        std::cerr << "Error reading from edge-block at " << file_path << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+}
+
+
+template <uint16_t k>
+bool Edge_Block<k>::claim_read_ahead() const
+{
+    auto s = ra_state.load(std::memory_order_acquire);
+    if(s == ra_issued && ra_state.compare_exchange_strong(s, ra_claimed, std::memory_order_acq_rel))
+    {
+        wait_read_ahead();
+        ra_state.store(ra_ready, std::memory_order_release);
+        return true;
+    }
+
+    return s == ra_ready;
+}
+
+
+template <uint16_t k>
+void Edge_Block<k>::reset_read()
+{
+    read_frame = 0;
+    read_bufs_pending = true;
+
+    if(ra_frame_c > 0 && ra_pending < ra_frame_c)   // The read-ahead has been consumed, at least partly.
+    {
+        wait_read_ahead();
+        ra_buf.free();
+        ra_frame_c = ra_pending = 0;
+    }
+}
+
+
+template <uint16_t k>
+std::size_t Edge_Block<k>::read_ahead(const std::size_t max_bytes)
+{
+    if(frames.empty() || read_frame > 0 || ra_frame_c > 0 || frames[0].bytes > max_bytes)
+        return 0;
+
+    sync();
+
+    std::size_t f = 1;
+    while(f < frames.size() && frames[f].off + frames[f].bytes <= max_bytes)
+        f++;
+
+    const auto bytes = frames[f - 1].off + frames[f - 1].bytes;
+    ra_buf.reserve_uninit(bytes);
+    ra_frame_c = f;
+    ra_pending = f;
+    ra_state = ra_issued;
+    Async_IO::get().read(ra_req, fd, ra_buf.data(), bytes, 0);
+
+    return bytes;
+}
+
+
+template <uint16_t k>
+void Edge_Block<k>::remove()
+{
+    sync();
+    wait_read_ahead();
+    ra_buf.free();
+    ra_frame_c = ra_pending = 0;
+
+    if(!file_path.empty())
+    {
+        const auto closed = (fd < 0 || ::close(fd) == 0);
+        fd = -1;
+        if(!closed || !remove_file(file_path))
+        {
+            std::cerr << "Error removing file at " << file_path << ". Aborting.\n";
+            std::exit(EXIT_FAILURE);
+        }
+    }
+
+
+    force_free(frames);
+    std::for_each(buf_w_local.begin(), buf_w_local.end(), [](auto& w_buf){ force_free(w_buf.unwrap()); });
+    for(auto& s_w : scratch)
+    {
+        auto& s = s_w.unwrap();
+        s.packed.free(), s.out[0].free(), s.out[1].free(), s.in.free();
+    }
+}
+
+
+template <uint16_t k>
+std::size_t Edge_Block<k>::RSS() const
+{
+    std::size_t bytes = frames.capacity() * sizeof(Frame) + ra_buf.capacity();
+    std::for_each(buf_w_local.cbegin(), buf_w_local.cend(), [&](const auto& b){ bytes += b.unwrap().capacity() * sizeof(edge_t); });
+    std::for_each(scratch.cbegin(), scratch.cend(), [&](const auto& s_w)
+    {
+        const auto& s = s_w.unwrap();
+        bytes += s.packed.capacity() + s.out[0].capacity() + s.out[1].capacity() + s.in.capacity();
+    });
+
+    return bytes;
+}
+
+}
+
+
+
+// Template instantiations for the required instances.
+ENUMERATE(INSTANCE_COUNT, INSTANTIATE, cuttlefish::Edge_Block)
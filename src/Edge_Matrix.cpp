@@ -140,6 +140,17 @@ void Edge_Matrix<k>::reset_read()
 }
 
 
+template <uint16_t k>
+void Edge_Matrix<k>::read_ahead_column(const std::size_t j, const std::size_t max_bytes)
+{
+    assert(j >= 1 && j <= vertex_part_count_);
+
+    std::size_t bytes = edge_matrix[j][j].read_ahead(max_bytes);
+    for(std::size_t i = 0; i < j && bytes < max_bytes; ++i)
+        bytes += edge_matrix[i][j].read_ahead(max_bytes - bytes);
+}
+
+
 template <uint16_t k>
 std::size_t Edge_Matrix<k>::row_size(const std::size_t i) const
 {
@@ -2,6 +2,7 @@
 #include "Graph_Partitioner.hpp"
 #include "Subgraphs_Manager.hpp"
 #include "Minimizer_Iterator.hpp"
+#include "Minimizer_Batch.hpp"
 #include "DNA_Utility.hpp"
 #include "Spin_Lock.hpp"
 #include "globals.hpp"
@@ -431,7 +432,7 @@ uint64_t Graph_Partitioner<k, Is_FASTQ_, Colored_>::process_chunk(chunk_t* chunk
     uint64_t chunk_bytes = 0;   // Count of bytes in the chunk.
 
     // Minimizer_Iterator<const char*, k - 1, true> min_it(l_, min_seed);   // `l`-minimizer iterator for `(k - 1)`-mers.
-    Min_Iterator<k - 1> min_it(l_); // `l`-minimizer iterator for `(k - 1)`-mers.
+    Minimizer_Batch min_batch(k - 1, l_);   // Batch `l`-minimizer engine for `(k - 1)`-mers.
 
     const auto t_0 = timer::now();
     auto& parsed_chunk = parsed_chunk_w[parlay::worker_id()].unwrap();
@@ -500,6 +501,8 @@ uint64_t Graph_Partitioner<k, Is_FASTQ_, Colored_>::process_chunk(chunk_t* chunk
                 continue;
             }
 
+            std::size_t frag_end;   // Non-inclusive end-index of the fragment, i.e. its length.
+            for(frag_end = k + 1; DNA_Utility::is_DNA_base(frag[frag_end]); ++frag_end);
 
             // minimizer_t cur_min;    // Minimizer of the current super (k - 1)-mer in the iteration.
             // minimizer_t next_min;   // Minimizer of the next super (k - 1)-mer in the iteration.
@@ -515,20 +518,19 @@ uint64_t Graph_Partitioner<k, Is_FASTQ_, Colored_>::process_chunk(chunk_t* chunk
 
             // min_it.reset(frag, seq_len - frag_beg); // The fragment length is an estimate; upper-bound to be exact.
             // min_it.value_at(cur_min, cur_min_off, cur_h);
-            min_it.reset(frag);
-            cur_h = min_it.hash();
+            min_batch.reset(frag, frag_end);
+            cur_h = min_batch.hash(0);
             cur_g = subgraphs.graph_ID(cur_h);
             prev_g = subgraphs.graph_count();   // To deal with false-positive `-Wmaybe-uninitialized` later on.
 
-            while(DNA_Utility::is_DNA_base(frag[frag_len]))
+            while(frag_len < frag_end)
             {
                 const auto len = km1_mer_idx + (k - 1); // Length of the current super (k - 1)-mer.
 
-                min_it.advance(frag[frag_len]);
                 km1_mer_idx++, frag_len++;
 
                 // min_it.value_at(next_min, next_min_off, next_h);
-                next_h = min_it.hash();
+                next_h = min_batch.hash(frag_len - (k - 1));
                 next_g = subgraphs.graph_ID(next_h);
 /*                  assert(next_min_off >= cur_sup_km1_mer_off + km1_mer_idx);
 
@@ -7,8 +7,8 @@
 namespace cuttlefish
 {
 
-HyperLogLog::HyperLogLog():
-      M_w(parlay::num_workers())
+HyperLogLog::HyperLogLog(const bool shared):
+      M_w(shared ? 1 : parlay::num_workers())
 {
     static_assert(m >= 128);
     static_assert((1lu << log_m) == m);
@@ -24,7 +24,7 @@ uint64_t HyperLogLog::estimate() const
     std::memset(M, 0, m);
 
     for(std::size_t i = 0; i < m; ++i)
-        for(std::size_t w_id = 0; w_id < parlay::num_workers(); ++w_id)
+        for(std::size_t w_id = 0; w_id < M_w.size(); ++w_id)
             M[i] = std::max(M[i], M_w[w_id].unwrap()[i]);
 
 
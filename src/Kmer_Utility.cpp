@@ -1,5 +1,106 @@
-
 #include "Kmer_Utility.hpp"
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CF_X86
+#endif
+
 
 constexpr uint8_t Kmer_Utility::REVERSE_COMPLEMENT_BYTE[256];
+
+
+void Kmer_Utility::encode_checked_words_scalar(const char* const label, const std::size_t word_c, uint64_t* const words)
+{
+    for(std::size_t i = 0; i < word_c; ++i)
+        words[word_c - 1 - i] = encode_checked<32>(label + 32 * i);
+}
+
+
+namespace
+{
+
+#ifdef CF_X86
+
+// The vectorized encoders map each base `b` to `((b >> 2) ^ (b >> 1)) & 0b11`
+// like `DNA_Utility::map_base_unchecked`; the 16-bit lane shifts do not leak
+// into the two retained bits. The 2-bit codes of each four consecutive bases
+// are then packed into a byte, with the first base at its most significant
+// bits, by two multiply-adds: with weights `(4, 1)` over the byte-pairs, and
+// with `(16, 1)` over the resulting 16-bit pairs.
+
+
+// Returns the encoding of the 16 bases at `label`, with the first base at
+// the most significant bits.
+__attribute__((target("sse4.1")))
+inline uint32_t encode_16_sse4(const char* const label)
+{
+    const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(label));
+    const __m128i c = _mm_and_si128(_mm_xor_si128(_mm_srli_epi16(x, 2), _mm_srli_epi16(x, 1)), _mm_set1_epi8(0b11));
+    const __m128i q = _mm_madd_epi16(_mm_maddubs_epi16(c, _mm_set1_epi16(0x0104)), _mm_set1_epi32(0x00010010));
+    const __m128i p = _mm_shuffle_epi8(q, _mm_setr_epi8(0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1));
+
+    return __builtin_bswap32(static_cast<uint32_t>(_mm_cvtsi128_si32(p)));
+}
+
+
+__attribute__((target("sse4.1")))
+void encode_checked_words_sse4(const char* const label, const std::size_t word_c, uint64_t* const words)
+{
+    for(std::size_t i = 0; i < word_c; ++i)
+    {
+        const auto b = label + 32 * i;
+        words[word_c - 1 - i] = (static_cast<uint64_t>(encode_16_sse4(b)) << 32) | encode_16_sse4(b + 16);
+    }
+}
+
+
+__attribute__((target("avx2")))
+void encode_checked_words_avx2(const char* const label, const std::size_t word_c, uint64_t* const words)
+{
+    const __m256i mask = _mm256_set1_epi8(0b11);
+    const __m256i pair_w = _mm256_set1_epi16(0x0104);
+    const __m256i quad_w = _mm256_set1_epi32(0x00010010);
+    const __m256i gather = _mm256_setr_epi8(0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                            0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+
+    for(std::size_t i = 0; i < word_c; ++i)
+    {
+        const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(label + 32 * i));
+        const __m256i c = _mm256_and_si256(_mm256_xor_si256(_mm256_srli_epi16(x, 2), _mm256_srli_epi16(x, 1)), mask);
+        const __m256i q = _mm256_madd_epi16(_mm256_maddubs_epi16(c, pair_w), quad_w);
+        const __m256i p = _mm256_shuffle_epi8(q, gather);   // Bytes 0-3 of each 128-bit lane.
+
+        const uint64_t lo = static_cast<uint32_t>(_mm256_cvtsi256_si32(p));
+        const uint64_t hi = static_cast<uint32_t>(_mm256_extract_epi32(p, 4));
+        words[word_c - 1 - i] = __builtin_bswap64(lo | (hi << 32));
+    }
+}
+
+#endif
+
+
+// Returns the label-encoder best suited for the CPU.
+auto select_encoder()
+{
+#ifdef CF_X86
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2"))
+        return encode_checked_words_avx2;
+
+    if(__builtin_cpu_supports("sse4.1"))
+        return encode_checked_words_sse4;
+#endif
+
+    return Kmer_Utility::encode_checked_words_scalar;
+}
+
+
+const auto encode_checked_words_ = select_encoder();    // The label-encoder dispatched to.
+
+}
+
+
+void Kmer_Utility::encode_checked_words(const char* const label, const std::size_t word_c, uint64_t* const words)
+{
+    encode_checked_words_(label, word_c, words);
+}
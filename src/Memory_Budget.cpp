@@ -0,0 +1,76 @@
+
+#include "Memory_Budget.hpp"
+#include "Build_Params.hpp"
+#include "parlay/parallel.h"
+
+#include <algorithm>
+
+
+namespace cuttlefish
+{
+
+Memory_Budget::Memory_Budget(const std::size_t max_memory, const bool strict):
+      total_bytes_(max_memory * 1024lu * 1024lu * 1024lu)
+    , strict_(strict)
+{}
+
+
+Memory_Budget::Memory_Budget(const Build_Params& params):
+    // Only an explicitly specified limit is enforced, so that the default
+    // invocation keeps the preferred configurations.
+    Memory_Budget(params.max_memory(), params.strict_memory() && params.max_memory_specified())
+{}
+
+
+std::size_t Memory_Budget::stage_bytes(const Stage s) const
+{
+    return static_cast<std::size_t>(total_bytes_ * share[static_cast<std::size_t>(s)]);
+}
+
+
+std::size_t Memory_Budget::buffer_bytes(const Stage s, const std::size_t pref_bytes, const std::size_t count, const std::size_t min_bytes, const std::size_t reserved) const
+{
+    if(!strict_ || count == 0)
+        return pref_bytes;
+
+    const auto budget = stage_bytes(s);
+    const auto avail = (budget > reserved ? budget - reserved : 0);
+    const auto fit_bytes = avail / count;
+
+    return std::max(std::min(pref_bytes, fit_bytes), std::min(pref_bytes, min_bytes));
+}
+
+
+std::size_t Memory_Budget::worker_count(const Stage s, const std::size_t per_worker_bytes, const std::size_t reserved) const
+{
+    const std::size_t w_c = parlay::num_workers();
+    if(!strict_ || per_worker_bytes == 0)
+        return w_c;
+
+    const auto budget = stage_bytes(s);
+    const auto avail = (budget > reserved ? budget - reserved : 0);
+
+    return std::max(std::min(w_c, avail / per_worker_bytes), static_cast<std::size_t>(1));
+}
+
+
+const char* Memory_Budget::name(const Stage s)
+{
+    switch(s)
+    {
+    case Stage::partition:
+        return "partition";
+    case Stage::subgraphs:
+        return "subgraphs";
+    case Stage::contract:
+        return "contract";
+    case Stage::expand:
+        return "expand";
+    case Stage::collate:
+        return "collate";
+    }
+
+    return "";
+}
+
+}
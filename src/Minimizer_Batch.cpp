@@ -0,0 +1,206 @@
+
+#include "Minimizer_Batch.hpp"
+#include "Minimizer_Utility.hpp"
+#include "DNA_Utility.hpp"
+#include "wyhash/wyhash.h"
+
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CF_X86
+#endif
+
+
+Minimizer_Batch::Minimizer_Batch(const uint16_t k, const uint16_t l):
+      k(k)
+    , l(l)
+    , w(k - l + 1)
+    , lmer_mask(l == 32 ? ~0lu : (1lu << (2 * l)) - 1)
+    , seq(nullptr)
+    , kmer_c(0)
+    , batch_beg(0)
+    , batch_end(0)
+    , lmer_f(batch_sz + w - 1)
+    , lmer_r(batch_sz + w - 1)
+    , H(batch_sz + w - 1)
+    , M(batch_sz)
+{
+    assert(l <= k && l <= 32);
+
+    for(auto& t : T)
+        t.resize(batch_sz + w - 1);
+}
+
+
+void Minimizer_Batch::reset(const char* const seq, const std::size_t len)
+{
+    assert(len >= k);
+
+    this->seq = seq;
+    kmer_c = len - k + 1;
+    batch_beg = batch_end = 0;
+}
+
+
+void Minimizer_Batch::compute_batch(const std::size_t b)
+{
+    const auto c = std::min(batch_sz, kmer_c - b);  // Number of k-mers in the batch.
+    const auto n = c + w - 1;   // Number of l-mers in the batch.
+    const char* const s = seq + b;
+
+    // The sequence has only DNA bases, so the bases are mapped unchecked, and
+    // complemented through their 2-bit inversion.
+    const auto comp_shift = 2 * (l - 1);
+    const auto lmer_mask = this->lmer_mask;
+    uint64_t f_ = 0, r_ = 0;
+    for(std::size_t i = 0; i + 1 < l; ++i)
+    {
+        assert(DNA_Utility::is_DNA_base(s[i]));
+        const uint64_t base = DNA_Utility::map_base_unchecked(s[i]);
+        f_ = (f_ << 2) | base;
+        r_ = (r_ >> 2) | ((base ^ 0b11) << comp_shift);
+    }
+
+    const auto f = lmer_f.data(), r = lmer_r.data();
+    for(std::size_t i = 0; i < n; ++i)
+    {
+        assert(DNA_Utility::is_DNA_base(s[i + l - 1]));
+        const uint64_t base = DNA_Utility::map_base_unchecked(s[i + l - 1]);
+        f_ = (f_ << 2) | base;  // The bases past the l-mer are masked off only when stored.
+        r_ = (r_ >> 2) | ((base ^ 0b11) << comp_shift);
+        f[i] = f_ & lmer_mask, r[i] = r_;
+    }
+
+    hash_lmers(f, r, n, H.data());
+
+    // Sliding-min by doubling: after the pass with stride `p`, `H_p[i]` is the
+    // minimum of the hashes `[i, i + 2p)`. The passes are branch-free, and so
+    // vectorize. With `p` the largest power of 2 not exceeding `w`, the window
+    // `[j, j + w)` is covered by `[j, j + p)` and `[j + w - p, j + w)`.
+    const uint64_t* H_p = H.data();
+    auto H_next = T[0].data();
+    std::size_t p = 1;
+    for(; 2 * p <= w; p *= 2)
+    {
+        const auto m = n - (2 * p - 1);
+        for(std::size_t i = 0; i < m; ++i)
+            H_next[i] = (H_p[i] < H_p[i + p] ? H_p[i] : H_p[i + p]);
+
+        H_p = H_next;
+        H_next = (H_next == T[0].data() ? T[1].data() : T[0].data());
+    }
+
+    const auto M_ = M.data();
+    const auto H_r = H_p + (w - p);
+    for(std::size_t j = 0; j < c; ++j)
+        M_[j] = (H_p[j] < H_r[j] ? H_p[j] : H_r[j]);
+
+    batch_beg = b;
+    batch_end = b + c;
+}
+
+
+void Minimizer_Batch::hash_lmers_scalar(const uint64_t* const f, const uint64_t* const r, const std::size_t n, uint64_t* const h)
+{
+    for(std::size_t i = 0; i < n; ++i)
+        h[i] = std::min(Minimizer_Utility::hash(f[i]), Minimizer_Utility::hash(r[i]));
+}
+
+
+namespace
+{
+
+#if defined(CF_X86) && !defined(CF_DEVELOP_MODE)
+
+// The AVX-512 kernel evaluates `wyhash` over 8-byte keys with seed `0`, i.e.
+// `Minimizer_Utility::hash`, on eight l-mers at a time. The 64 x 64 -> 128-bit
+// multiplications are composed from four 32 x 32 -> 64-bit ones. The zero-
+// masking forms of the intrinsics are used with all the lanes enabled: the
+// unmasked ones pass an undefined pass-through vector, which GCC flags with
+// `-Wmaybe-uninitialized`.
+
+constexpr __mmask8 all_lanes = 0xff;    // Mask enabling all the 64-bit lanes.
+
+
+// Replaces `a` and `b` with the low and the high 64 bits of their 128-bit
+// product, per 64-bit lane.
+__attribute__((target("avx512f")))
+inline void mum_avx512(__m512i& a, __m512i& b)
+{
+    const __m512i lo_32 = _mm512_set1_epi64(0xffffffff);
+
+    const __m512i a_h = _mm512_maskz_srli_epi64(all_lanes, a, 32), b_h = _mm512_maskz_srli_epi64(all_lanes, b, 32);
+    const __m512i ll = _mm512_maskz_mul_epu32(all_lanes, a, b), lh = _mm512_maskz_mul_epu32(all_lanes, a, b_h);
+    const __m512i hl = _mm512_maskz_mul_epu32(all_lanes, a_h, b), hh = _mm512_maskz_mul_epu32(all_lanes, a_h, b_h);
+
+    // The cross-sums can not overflow: (2^32 - 1)^2 + 2 (2^32 - 1) < 2^64.
+    const __m512i t = _mm512_add_epi64(lh, _mm512_maskz_srli_epi64(all_lanes, ll, 32));
+    const __m512i u = _mm512_add_epi64(hl, _mm512_and_si512(t, lo_32));
+    a = _mm512_mask_blend_epi32(0xaaaa, ll, _mm512_maskz_slli_epi64(all_lanes, u, 32));
+    b = _mm512_add_epi64(hh, _mm512_add_epi64(_mm512_maskz_srli_epi64(all_lanes, t, 32), _mm512_maskz_srli_epi64(all_lanes, u, 32)));
+}
+
+
+// Returns the `wyhash` values of the eight 8-byte keys in `x`. `seed` is the
+// mixed seed, and `s_0` and `s_1` are the first two secrets.
+__attribute__((target("avx512f")))
+inline __m512i wyhash_8_avx512(const __m512i x, const __m512i seed, const __m512i s_0, const __m512i s_1, const __m512i len)
+{
+    __m512i a = _mm512_xor_si512(_mm512_maskz_ror_epi64(all_lanes, x, 32), s_1);
+    __m512i b = _mm512_xor_si512(x, seed);
+    mum_avx512(a, b);
+
+    a = _mm512_xor_si512(_mm512_xor_si512(a, s_0), len);
+    b = _mm512_xor_si512(b, s_1);
+    mum_avx512(a, b);
+
+    return _mm512_xor_si512(a, b);
+}
+
+
+__attribute__((target("avx512f")))
+void hash_lmers_avx512(const uint64_t* const f, const uint64_t* const r, const std::size_t n, uint64_t* const h)
+{
+    const auto secret = Minimizer_Utility::wy_salt;
+    const __m512i seed = _mm512_set1_epi64(_wymix(secret[0], secret[1]));
+    const __m512i s_0 = _mm512_set1_epi64(secret[0]);
+    const __m512i s_1 = _mm512_set1_epi64(secret[1]);
+    const __m512i len = _mm512_set1_epi64(sizeof(uint64_t));
+
+    std::size_t i = 0;
+    for(; i + 8 <= n; i += 8)
+    {
+        const __m512i h_f = wyhash_8_avx512(_mm512_loadu_si512(f + i), seed, s_0, s_1, len);
+        const __m512i h_r = wyhash_8_avx512(_mm512_loadu_si512(r + i), seed, s_0, s_1, len);
+        _mm512_storeu_si512(h + i, _mm512_maskz_min_epu64(all_lanes, h_f, h_r));
+    }
+
+    Minimizer_Batch::hash_lmers_scalar(f + i, r + i, n - i, h + i);
+}
+
+#endif
+
+
+// Returns the l-mer hasher best suited for the CPU.
+auto select_hasher()
+{
+#if defined(CF_X86) && !defined(CF_DEVELOP_MODE)
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx512f"))
+        return hash_lmers_avx512;
+#endif
+
+    return Minimizer_Batch::hash_lmers_scalar;
+}
+
+
+const auto hash_lmers_ = select_hasher();   // The l-mer hasher dispatched to.
+
+}
+
+
+void Minimizer_Batch::hash_lmers(const uint64_t* const f, const uint64_t* const r, const std::size_t n, uint64_t* const h)
+{
+    hash_lmers_(f, r, n, h);
+}
@@ -0,0 +1,192 @@
+
+#include "Path_Cover.hpp"
+#include "DNA_Utility.hpp"
+#include "FASTA_Record.hpp"
+#include "globals.hpp"
+#include "parlay/parallel.h"
+
+#include <cstring>
+#include <cstdlib>
+#include <iostream>
+#include <cassert>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+
+namespace cuttlefish
+{
+
+template <uint16_t k>
+Path_Cover<k>::Path_Cover(const Unitig_Links<k>& links, const std::string& seg_path):
+      links(links)
+    , seg_path(seg_path)
+    , seg(nullptr)
+    , seg_sz(0)
+    , path_c(0)
+    , cycle_c(0)
+{}
+
+
+template <uint16_t k>
+Path_Cover<k>::~Path_Cover()
+{
+    if(seg != nullptr)
+        ::munmap(const_cast<char*>(seg), seg_sz);
+}
+
+
+template <uint16_t k>
+void Path_Cover<k>::index_segments()
+{
+    const int fd = ::open(seg_path.c_str(), O_RDONLY);
+    struct stat st;
+    if(fd < 0 || ::fstat(fd, &st) != 0)
+    {
+        std::cerr << "Error opening the unitig segments at " << seg_path << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    seg_sz = st.st_size;
+    if(seg_sz > 0)
+    {
+        void* const m = ::mmap(nullptr, seg_sz, PROT_READ, MAP_SHARED, fd, 0);
+        if(m == MAP_FAILED)
+        {
+            std::cerr << "Error mapping the unitig segments at " << seg_path << ". Aborting.\n";
+            std::exit(EXIT_FAILURE);
+        }
+
+        seg = static_cast<const char*>(m);
+    }
+
+    ::close(fd);
+
+    // The file is split into chunks, and each worker indexes the `S`-lines
+    // beginning in its chunks.
+    off.assign(links.size(), seg_sz);
+    const std::size_t chunk_c = parlay::num_workers() * 8;
+    const std::size_t chunk_sz = (seg_sz + chunk_c - 1) / chunk_c;
+    parlay::parallel_for(0, chunk_c,
+    [&](const std::size_t c)
+    {
+        const auto end = std::min(seg_sz, (c + 1) * chunk_sz);
+        auto pos = std::min(seg_sz, c * chunk_sz);
+        if(pos > 0 && seg[pos - 1] != '\n')
+        {
+            const auto nl = static_cast<const char*>(std::memchr(seg + pos, '\n', seg_sz - pos));
+            pos = (nl == nullptr ? seg_sz : nl - seg + 1);
+        }
+
+        while(pos < end)
+        {
+            const auto nl = static_cast<const char*>(std::memchr(seg + pos, '\n', seg_sz - pos));
+            const std::size_t line_end = (nl == nullptr ? seg_sz : nl - seg);
+            if(seg[pos] == 'S')
+            {
+                uint64_t u = 0;
+                auto p = pos + 2;
+                for(; p < line_end && seg[p] != '\t'; ++p)
+                    u = u * 10 + (seg[p] - '0');
+
+                assert(u < off.size());
+                off[u] = p + 1;
+            }
+
+            pos = line_end + 1;
+        }
+    }, 1);
+}
+
+
+template <uint16_t k>
+std::string_view Path_Cover<k>::label(const uint64_t u) const
+{
+    assert(off[u] < seg_sz);
+    const auto beg = seg + off[u];
+    const auto nl = static_cast<const char*>(std::memchr(beg, '\n', seg_sz - off[u]));
+    return std::string_view(beg, (nl == nullptr ? seg + seg_sz : nl) - beg);
+}
+
+
+template <uint16_t k>
+uint64_t Path_Cover<k>::exit_end(uint64_t e) const
+{
+    while(M[e ^ 1] != Unitig_Links<k>::unmatched)
+        e = M[e ^ 1];
+
+    return e ^ 1;
+}
+
+
+template <uint16_t k>
+void Path_Cover<k>::extract_path(const uint64_t e_0, std::string& buf, op_buf_t& op)
+{
+    buf.clear();
+    auto e = e_0;   // The end through which the traversal enters the current unitig.
+    while(true)
+    {
+        const auto u = (e >> 1);
+        const auto l = label(u);
+        assert(l.size() >= k);
+        const std::size_t skip = (buf.empty() ? 0 : k - 1);   // Overlap with the preceding unitig.
+
+        // The unitig is spelled forward iff it is entered through its front.
+        if((e & 1) == 0)
+            buf.append(l.cbegin() + skip, l.cend());
+        else
+            for(auto i = l.size() - skip; i > 0; --i)
+                buf.push_back(DNA_Utility::complement(l[i - 1]));
+
+        covered[u] = true;
+
+        e = M[e ^ 1];
+        if(e == Unitig_Links<k>::unmatched || e == e_0)
+            break;
+    }
+
+    op += FASTA_Record(path_c++, buf);
+}
+
+
+template <uint16_t k>
+void Path_Cover<k>::extract(Streaming_File_Sink& sink, const Output_Format format)
+{
+    links.match(M);
+    index_segments();
+
+    const auto n = links.size();
+    covered.assign(n, false);
+    std::vector<Padded<op_buf_t>> op_buf(parlay::num_workers(), op_buf_t(sink, format));
+    std::vector<Padded<std::string>> buf(parlay::num_workers());
+
+    // A path is extracted from its end with the smaller identifier.
+    parlay::parallel_for(0, n,
+    [&](const uint64_t u)
+    {
+        auto& op = op_buf[parlay::worker_id()].unwrap();
+        auto& b = buf[parlay::worker_id()].unwrap();
+        for(const auto e : {2 * u, 2 * u + 1})
+            if(M[e] == Unitig_Links<k>::unmatched && e < exit_end(e))
+                extract_path(e, b, op);
+    });
+
+    // The rest of the unitigs form cycles, each of which is broken at the
+    // first of its unitigs to be found.
+    auto& op = op_buf.front().unwrap();
+    auto& b = buf.front().unwrap();
+    for(uint64_t u = 0; u < n; ++u)
+        if(!covered[u])
+            extract_path(2 * u, b, op),
+            cycle_c++;
+
+    parlay::parallel_for(0, op_buf.size(), [&](const std::size_t w){ op_buf[w].unwrap().close(); }, 1);
+}
+
+}
+
+
+
+// Template-instantiations for the required instances.
+ENUMERATE(INSTANCE_COUNT, INSTANTIATE, cuttlefish::Path_Cover)
@@ -0,0 +1,123 @@
+
+#include "Phase_Manifest.hpp"
+#include "Build_Params.hpp"
+#include "utility.hpp"
+#include "parlay/parallel.h"
+
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <filesystem>
+#include <cstdlib>
+
+
+namespace cuttlefish
+{
+
+Phase_Manifest::Phase_Manifest(const std::string& file_path, const Build_Params& params, const uint64_t graph_count):
+      file_path_(file_path)
+    , config(configuration(params, graph_count))
+    , phase_(Phase::none)
+    , output_bytes_(0)
+{}
+
+
+nlohmann::ordered_json Phase_Manifest::configuration(const Build_Params& params, const uint64_t graph_count)
+{
+    nlohmann::ordered_json c;
+
+    c["input"] = params.sequence_input().seqs();
+    c["k"] = params.k();
+    c["read graph"] = params.is_read_graph();
+    c["cutoff"] = params.cutoff();
+    c["color"] = params.color();
+    c["minimizer length"] = params.min_len();
+    c["subgraph count"] = graph_count;
+    c["vertex-partition count"] = params.vertex_part_count();
+    c["lm-tig bucket count"] = params.lmtig_bucket_count();
+    c["worker count"] = parlay::num_workers();  // The checkpointed buckets have worker-local buffers.
+
+    return c;
+}
+
+
+Phase_Manifest::Phase Phase_Manifest::load()
+{
+    if(!file_exists(file_path_))
+        return phase_ = Phase::none;
+
+    nlohmann::ordered_json manifest;
+    std::ifstream input(file_path_);
+    input >> manifest;
+    if(input.fail())
+    {
+        std::cerr << "Error loading the phase manifest from file " << file_path_ << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    if(manifest[config_field] != config)
+    {
+        std::cerr << "The phase manifest at " << file_path_ << " is from a construction with a different configuration; it can not be resumed. Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    const auto p = manifest[phase_field].get<std::string>();
+    for(const auto q : {Phase::none, Phase::subgraphs, Phase::contract, Phase::expand, Phase::collate})
+        if(p == name(q))
+        {
+            phase_ = q;
+            output_bytes_ = manifest[output_field].get<uint64_t>();
+            return phase_;
+        }
+
+    std::cerr << "Unknown phase " << p << " in the phase manifest at " << file_path_ << ". Aborting.\n";
+    std::exit(EXIT_FAILURE);
+}
+
+
+void Phase_Manifest::record(const Phase p, const uint64_t output_bytes)
+{
+    phase_ = p;
+    output_bytes_ = output_bytes;
+
+    nlohmann::ordered_json manifest;
+    manifest[config_field] = config;
+    manifest[phase_field] = name(phase_);
+    manifest[output_field] = output_bytes_;
+
+    // Write to a temporary file first, so that an interruption here does not
+    // leave behind a partial manifest.
+    const auto temp_path = file_path_ + ".tmp";
+    std::ofstream output(temp_path);
+    output << std::setw(4) << manifest << "\n";
+    output.close();
+
+    std::error_code ec;
+    if(!output || (std::filesystem::rename(temp_path, file_path_, ec), ec))
+    {
+        std::cerr << "Error writing the phase manifest to file " << file_path_ << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+}
+
+
+const char* Phase_Manifest::name(const Phase p)
+{
+    switch(p)
+    {
+    case Phase::none:
+        return "none";
+    case Phase::subgraphs:
+        return "subgraphs";
+    case Phase::contract:
+        return "contract";
+    case Phase::expand:
+        return "expand";
+    case Phase::collate:
+        return "collate";
+    }
+
+    return "";
+}
+
+}
@@ -0,0 +1,334 @@
+
+#include "Streaming_File_Sink.hpp"
+#include "parlay/parallel.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <cstdlib>
+#include <cerrno>
+#include <cassert>
+#include <chrono>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <zlib.h>
+
+
+Streaming_File_Sink::Streaming_File_Sink():
+      fd(-1)
+    , off(0)
+    , bgzf(false)
+    , stop(false)
+{}
+
+
+Streaming_File_Sink::~Streaming_File_Sink()
+{
+    if(fd >= 0)
+        close();
+}
+
+
+void Streaming_File_Sink::open(const std::string& path, const bool bgzf)
+{
+    assert(fd < 0);
+
+    path_ = path;
+    fd = ::open(path_.c_str(), O_WRONLY | O_CREAT, 0644);
+    struct stat st;
+    if(fd < 0 || ::fstat(fd, &st) != 0)
+    {
+        std::cerr << "Error opening output file at " << path_ << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    off = st.st_size;
+    this->bgzf = bgzf;
+
+    const auto slot_c = bufs_per_worker * parlay::num_workers();
+    slot.resize(slot_c);
+    free_q.reset(slot_c);
+    write_q.reset(slot_c);
+    for(std::size_t i = 0; i < slot_c; ++i)
+        free_q.push(i);
+
+    batch.reserve(max_batch_sz);
+    stop.store(false, std::memory_order_relaxed);
+    writer = std::thread(&Streaming_File_Sink::run, this);
+}
+
+
+void Streaming_File_Sink::Slot_Queue::reset(const std::size_t n)
+{
+    std::size_t cap = 1;
+    while(cap < n)
+        cap <<= 1;
+
+    mask = cap - 1;
+    cell = std::make_unique<Cell[]>(cap);
+    for(std::size_t i = 0; i < cap; ++i)
+        cell[i].seq.store(i, std::memory_order_relaxed);
+
+    tail.store(0, std::memory_order_relaxed);
+    head.store(0, std::memory_order_relaxed);
+}
+
+
+void Streaming_File_Sink::Slot_Queue::push(const uint32_t idx)
+{
+    auto pos = tail.load(std::memory_order_relaxed);
+    while(true)
+    {
+        auto& c = cell[pos & mask];
+        const auto seq = c.seq.load(std::memory_order_acquire);
+        if(seq == pos)
+        {
+            if(tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            {
+                c.idx = idx;
+                c.seq.store(pos + 1, std::memory_order_release);
+                return;
+            }
+        }
+        else    // The queue holds all the slot indices at most, so a cell found full is being popped.
+            pos = tail.load(std::memory_order_relaxed);
+    }
+}
+
+
+bool Streaming_File_Sink::Slot_Queue::pop(uint32_t& idx)
+{
+    auto pos = head.load(std::memory_order_relaxed);
+    while(true)
+    {
+        auto& c = cell[pos & mask];
+        const auto seq = c.seq.load(std::memory_order_acquire);
+        if(seq == pos + 1)
+        {
+            if(head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            {
+                idx = c.idx;
+                c.seq.store(pos + mask + 1, std::memory_order_release);
+                return true;
+            }
+        }
+        else if(seq < pos + 1)
+            return false;
+        else
+            pos = head.load(std::memory_order_relaxed);
+    }
+}
+
+
+void Streaming_File_Sink::submit(std::string& buf)
+{
+    if(buf.empty())
+        return;
+
+    if(bgzf)
+    {
+        // The compressed content is handed over instead, and the buffer keeps
+        // the capacity of the worker's compression space.
+        thread_local std::string z;
+        compress_bgzf(buf, z);
+        buf.swap(z);
+        z.clear();
+    }
+
+    const auto cap = buf.capacity();
+    uint32_t idx;
+    while(!free_q.pop(idx))
+        std::this_thread::yield();
+
+    buf.swap(slot[idx]);
+    write_q.push(idx);
+
+    // Slots are populated lazily, from the first buffers submitted to them.
+    assert(buf.empty());
+    if(buf.capacity() < cap)
+        buf.reserve(cap);
+}
+
+
+void Streaming_File_Sink::run()
+{
+    constexpr std::size_t spin_c = 64; // Number of yields of the idle writer before it sleeps.
+    constexpr auto nap = std::chrono::microseconds(100);    // Sleep duration of the idle writer.
+
+    std::size_t idle_c = 0; // Number of consecutive empty polls of the queue.
+    uint32_t idx;
+    while(true)
+    {
+        // `stop` is read before polling, so that the submissions preceding it
+        // are seen in the poll.
+        const bool to_stop = stop.load(std::memory_order_acquire);
+        while(batch.size() < max_batch_sz && write_q.pop(idx))
+            batch.push_back(idx);
+
+        if(batch.empty())
+        {
+            if(to_stop)
+                return;
+
+            if(++idle_c < spin_c)
+                std::this_thread::yield();
+            else
+                std::this_thread::sleep_for(nap);
+
+            continue;
+        }
+
+        idle_c = 0;
+        write_batch();
+        for(const auto i : batch)
+            slot[i].clear(),
+            free_q.push(i);
+
+        batch.clear();
+    }
+}
+
+
+void Streaming_File_Sink::write_batch()
+{
+    std::vector<iovec> iov;
+    iov.reserve(std::min(batch.size(), max_batch_sz));
+
+    for(std::size_t b = 0; b < batch.size(); )
+    {
+        iov.clear();
+        std::size_t bytes = 0;
+        for(; b < batch.size() && iov.size() < max_batch_sz; ++b)
+            iov.push_back({slot[batch[b]].data(), slot[batch[b]].size()}),
+            bytes += slot[batch[b]].size();
+
+        // Short writes are resumed from the first unwritten byte.
+        std::size_t i = 0;
+        while(bytes > 0)
+        {
+            const auto n = ::pwritev(fd, iov.data() + i, static_cast<int>(iov.size() - i), off);
+            if(n < 0 && errno == EINTR)
+                continue;
+
+            if(n <= 0)
+            {
+                std::cerr << "Error writing to output file at " << path_ << ". Aborting.\n";
+                std::exit(EXIT_FAILURE);
+            }
+
+            off += n, bytes -= n;
+            for(std::size_t w = n; w > 0; )
+                if(w >= iov[i].iov_len)
+                    w -= iov[i].iov_len, i++;
+                else
+                {
+                    iov[i].iov_base = static_cast<char*>(iov[i].iov_base) + w;
+                    iov[i].iov_len -= w;
+                    w = 0;
+                }
+        }
+    }
+}
+
+
+void Streaming_File_Sink::compress_bgzf(const std::string& in, std::string& out) const
+{
+    out.clear();
+    for(std::size_t i = 0; i < in.size(); i += bgzf_max_input_sz)
+    {
+        const auto len = std::min(bgzf_max_input_sz, in.size() - i);
+        if(!append_bgzf_block(in.data() + i, len, bgzf_level, out) && !append_bgzf_block(in.data() + i, len, Z_NO_COMPRESSION, out))
+        {
+            std::cerr << "Error compressing output for file at " << path_ << ". Aborting.\n";
+            std::exit(EXIT_FAILURE);
+        }
+    }
+}
+
+
+bool Streaming_File_Sink::append_bgzf_block(const char* const in, const std::size_t len, const int level, std::string& out)
+{
+    // A deflate stream, set up once per thread for a compression level.
+    struct Deflater
+    {
+        z_stream strm{};
+        bool ok = false;
+
+        explicit Deflater(const int level):
+            ok(deflateInit2(&strm, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) == Z_OK)  // Raw deflate; the gzip wrapper is written here.
+        {}
+
+        ~Deflater() { if(ok) deflateEnd(&strm); }
+    };
+
+    thread_local Deflater def_compressed(bgzf_level);
+    thread_local Deflater def_stored(Z_NO_COMPRESSION);
+    assert(level == bgzf_level || level == Z_NO_COMPRESSION);
+    auto& d = (level == Z_NO_COMPRESSION ? def_stored : def_compressed);
+    if(!d.ok)
+        return false;
+
+    const auto beg = out.size();
+    out.resize(beg + bgzf_max_block_sz);
+    auto const blk = reinterpret_cast<uint8_t*>(out.data() + beg);
+
+    auto& strm = d.strm;
+    if(deflateReset(&strm) != Z_OK)
+        return out.resize(beg), false;
+
+    strm.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in));
+    strm.avail_in = len;
+    strm.next_out = blk + bgzf_header_sz;
+    strm.avail_out = bgzf_max_block_sz - bgzf_header_sz - bgzf_footer_sz;
+    const auto ret = deflate(&strm, Z_FINISH);
+    const std::size_t c_len = strm.total_out;
+    if(ret != Z_STREAM_END)
+        return out.resize(beg), false;
+
+    const std::size_t blk_sz = bgzf_header_sz + c_len + bgzf_footer_sz;
+    const auto put_le = [](uint8_t* p, uint64_t v, std::size_t bytes){ for(std::size_t i = 0; i < bytes; ++i) p[i] = (v >> (8 * i)) & 0xff; };
+
+    // gzip header with the BGZF extra subfield `BC`, recording the block size.
+    constexpr uint8_t header[bgzf_header_sz - 2] = {0x1f, 0x8b, 8, 4, 0, 0, 0, 0, 0, 0xff, 6, 0, 'B', 'C', 2, 0};
+    std::memcpy(blk, header, sizeof(header));
+    put_le(blk + sizeof(header), blk_sz - 1, 2);
+
+    put_le(blk + bgzf_header_sz + c_len, crc32(crc32(0, Z_NULL, 0), reinterpret_cast<const Bytef*>(in), len), 4);
+    put_le(blk + bgzf_header_sz + c_len + 4, len, 4);
+
+    out.resize(beg + blk_sz);
+    return true;
+}
+
+
+void Streaming_File_Sink::close(const bool final)
+{
+    stop.store(true, std::memory_order_release);
+    if(writer.joinable())
+        writer.join();
+
+    if(bgzf && final && fd >= 0)
+    {
+        // The end-of-file marker of BGZF: an empty block. It is written only
+        // once, as the file may be reopened to append more blocks.
+        std::string eof;
+        append_bgzf_block(nullptr, 0, bgzf_level, eof);
+        slot.resize(1);
+        slot[0].swap(eof);
+        batch.assign(1, 0);
+        write_batch();
+        batch.clear();
+    }
+
+    if(fd >= 0 && ::close(fd) != 0)
+    {
+        std::cerr << "Error closing output file at " << path_ << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    fd = -1;
+    std::vector<std::string>().swap(slot);
+    std::vector<uint32_t>().swap(batch);
+}
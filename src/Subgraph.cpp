@@ -17,7 +17,7 @@ namespace cuttlefish
 
 
 template <uint16_t k, bool Colored_>
-Subgraph<k, Colored_>::Subgraph(const Super_Kmer_Bucket<Colored_>& B, Discontinuity_Graph<k, Colored_>& G, op_buf_t& op_buf, Subgraphs_Scratch_Space<k, Colored_>& space):
+Subgraph<k, Colored_>::Subgraph(const Super_Kmer_Bucket<Colored_>& B, Discontinuity_Graph<k, Colored_>& G, op_buf_t& op_buf, Subgraphs_Scratch_Space<k, Colored_>& space, const std::size_t sz_est):
       B(B)
     , work_space(space)
     , M(space.map())
@@ -37,6 +37,7 @@ Subgraph<k, Colored_>::Subgraph(const Super_Kmer_Bucket<Colored_>& B, Discontinu
     , op_buf(op_buf)
 {
     M.clear();
+    ht_router::reserve(M, sz_est);
 }
 
 
@@ -44,7 +45,45 @@ template <uint16_t k, bool Colored_>
 void Subgraph<k, Colored_>::construct()
 {
     typename Super_Kmer_Bucket<Colored_>::Iterator super_kmer_it(B);    // Iterator over the weak super k-mers inducing this graph.
+    construct(super_kmer_it, M, kmer_count_, edge_c);
+}
+
+
+template <uint16_t k, bool Colored_>
+void Subgraph<k, Colored_>::Part::construct(const Super_Kmer_Bucket<Colored_>& B, const std::size_t chunk_beg, const std::size_t chunk_end, const std::size_t sz_est)
+{
+    ht_router::reserve(M, sz_est);
+    typename Super_Kmer_Bucket<Colored_>::Iterator super_kmer_it(B, chunk_beg, chunk_end);
+    Subgraph::construct(super_kmer_it, M, kmer_count_, edge_c);
+}
+
+
+template <uint16_t k, bool Colored_>
+void Subgraph<k, Colored_>::construct(std::vector<Part>& P)
+{
+    assert(!Colored_);
+
+    if constexpr(!Colored_)
+    {
+        for(auto& p : P)
+        {
+            kmer_count_ += p.kmer_count_;
+            edge_c += p.edge_c;
+            for(const auto& v : p.M)
+                ht_router::merge(M, v.first, v.second);
+
+            force_free(p.M);
+        }
 
+        ht_router::flush_updates(M);
+    }
+}
+
+
+template <uint16_t k, bool Colored_>
+template <typename T_ht_>
+void Subgraph<k, Colored_>::construct(typename Super_Kmer_Bucket<Colored_>::Iterator& super_kmer_it, T_ht_& HT, uint64_t& kmer_c, uint64_t& e_c)
+{
     typedef typename decltype(super_kmer_it)::label_unit_t label_unit_t;
     const auto word_count = super_kmer_it.super_kmer_word_count();  // Fixed number of words in a super k-mer label.
 
@@ -59,7 +98,7 @@ void Subgraph<k, Colored_>::construct()
         const auto len = att.len();
         assert(len >= k);
         assert(len < 2 * (k - 1));
-        kmer_count_ += len - (k - 1);
+        kmer_c += len - (k - 1);
 
         if constexpr(Colored_)
         {
@@ -82,10 +121,10 @@ void Subgraph<k, Colored_>::construct()
             if(CF_UNLIKELY(kmer_idx > 0 && v.canonical() == pred_v))    // Counter overcounting of self-loops.
                 (is_canonical ? front : back) = base_t::E;
 
-            edge_c += (succ_base != base_t::E);
+            e_c += (succ_base != base_t::E);
 
             // Update hash table with the neighborhood info.
-            ht_router::update(M, v.canonical(),
+            ht_router::update(HT, v.canonical(),
                                  front, back,
                                  kmer_idx == 0 && att.left_discontinuous() ? v.entrance_side() : side_t::unspecified,
                                  kmer_idx + k == len && att.right_discontinuous() ? v.exit_side() : side_t::unspecified,
@@ -104,7 +143,7 @@ void Subgraph<k, Colored_>::construct()
         }
     }
 
-    ht_router::flush_updates(M);
+    ht_router::flush_updates(HT);
 }
 
 
@@ -344,29 +383,56 @@ if constexpr(Colored_)
 template <uint16_t k, bool Colored_>
 void Subgraph<k, Colored_>::semi_sort_color_rels(const color_rel_t* const x, color_rel_t* const y, const std::size_t sz)
 {
-    auto& count_map = work_space.count_map();
-    count_map.clear();
-
-    // TODO: skip `x`; add and use ext-mem-bucket iterator.
+    // The relationships are partitioned with a counting sort on the lowest
+    // bits of their vertices, with the partition count scaled to the size so
+    // that the partitions are small. Each partition is then sorted per the
+    // vertices, with the partitioning and the sorts both being stable.
+    uint32_t digit_bits = 0;
+    while(digit_bits < max_digit_bits && (sz >> (digit_bits + 4)) > 0)
+        digit_bits++;
+
+    const uint64_t mask = (uint64_t(1) << digit_bits) - 1;
+    const auto digit = [mask](const color_rel_t& r){ return r.first.data()[0] & mask; };
+
+    auto& count = work_space.count_arr();
+    count.assign(mask + 1, 0);
     for(std::size_t i = 0; i < sz; ++i)
-        count_map[x[i].first]++;
+        count[digit(x[i])]++;
 
     uint32_t pref_sum = 0;
-    for(auto& kmer_count : count_map)
+    for(auto& c : count)
     {
-        const auto temp = kmer_count.second;
-        kmer_count.second = pref_sum;
+        const auto temp = c;
+        c = pref_sum;
         pref_sum += temp;
     }
 
-
     for(std::size_t i = 0; i < sz; ++i)
     {
-        auto& off = count_map[x[i].first];
+        auto& off = count[digit(x[i])];
         assert(off < sz);
         y[off] = x[i];
         off++;
     }
+
+    // `count[p]` is the end of the `p`'th partition now.
+    const auto less = [](const color_rel_t& a, const color_rel_t& b){ return a.first < b.first; };
+    for(std::size_t p = 0, b = 0; p <= mask; b = count[p++])
+    {
+        const std::size_t e = count[p];
+        if(e - b <= insertion_sort_threshold)
+            for(auto i = b + 1; i < e; ++i)
+            {
+                const auto r = y[i];
+                auto j = i;
+                for(; j > b && less(r, y[j - 1]); --j)
+                    y[j] = y[j - 1];
+
+                y[j] = r;
+            }
+        else
+            std::stable_sort(y + b, y + e, less);
+    }
 }
 
 
@@ -405,7 +471,8 @@ if constexpr(Colored_)
     auto& color_rel = work_space.color_rel_arr();
     auto& color_rel_collated = work_space.color_rel_collate_arr();
     auto& C = work_space.color_map();
-    auto& color_bucket = work_space.color_repo().bucket();
+    auto& color_repo = work_space.color_repo();
+    auto& color_bucket = color_repo.bucket();
 
     std::vector<source_id_t> src;   // Sources of the current vertex.
 
@@ -414,11 +481,18 @@ if constexpr(Colored_)
         const auto t_0 = timer::now();
         auto& color_rel_bucket = color_rel_bucket_arr[b];
         const auto color_rel_c = color_rel_bucket.size();
-        color_rel.reserve_uninit(color_rel_c);
-        color_rel_bucket.load(color_rel.data());
+
+        // The bucket is read in-place if it has not been flushed to disk.
+        const color_rel_t* rel = color_rel_bucket.in_memory_data();
+        if(rel == nullptr)
+        {
+            color_rel.reserve_uninit(color_rel_c);
+            color_rel_bucket.load(color_rel.data());
+            rel = color_rel.data();
+        }
 
         color_rel_collated.reserve_uninit(color_rel_c);
-        semi_sort_color_rels(color_rel.data(), color_rel_collated.data(), color_rel_c);
+        semi_sort_color_rels(rel, color_rel_collated.data(), color_rel_c);
 
         const auto t_1 = timer::now();
         t_sort += timer::duration(t_1 - t_0);
@@ -439,8 +513,8 @@ if constexpr(Colored_)
                 // This is required to deduplicate relations, if the latter color-set sort does not deduplicate them.
                 // This works because: super k-mers from some source going into the same subgraph bucket cluster
                 // together due to the partitioning policy (and its buffering scheme). Hence color-relations from
-                // those super k-mers cluster together in the relationship list. This list is semi-sorted with
-                // counting sort, which is stable, and hence the clusters are retained in the sorted output.
+                // those super k-mers cluster together in the relationship list. This list is semi-sorted stably,
+                // and hence the clusters are retained in the sorted output.
                 // if(color_rel_collated[j].second != color_rel_collated[j - 1].second)
                 src.push_back(color_rel_collated[j].second);
             }
@@ -454,7 +528,7 @@ if constexpr(Colored_)
                 bvb.clear();
                 builder.process(src.data(), src.size(), bvb);
                 auto& bit_vec_words = bvb.bits();
-                color_bucket.add(bit_vec_words.data(), bit_vec_words.size());
+                color_repo.add(bit_vec_words.data(), bit_vec_words.size());
             }
         }
 
@@ -484,8 +558,9 @@ void Subgraph<k, Colored_>::attach_colors_to_vertices()
 
 
 template <uint16_t k, bool Colored_>
-Subgraphs_Scratch_Space<k, Colored_>::Subgraphs_Scratch_Space(const std::size_t max_sz, const std::string& color_rel_bucket_pref):
-      in_process_arr_(parlay::num_workers())
+Subgraphs_Scratch_Space<k, Colored_>::Subgraphs_Scratch_Space(const std::size_t max_sz, const std::string& color_rel_bucket_pref, const std::size_t color_table_cap):
+      M_c(color_table_cap)
+    , in_process_arr_(parlay::num_workers())
 {
     map_.reserve(parlay::num_workers());
     for(std::size_t i = 0; i < parlay::num_workers(); ++i)
@@ -496,7 +571,7 @@ Subgraphs_Scratch_Space<k, Colored_>::Subgraphs_Scratch_Space(const std::size_t
         color_rel_bucket_arr_.resize(parlay::num_workers());
         color_rel_arr_.resize(parlay::num_workers());
         color_rel_collate_arr_.resize(parlay::num_workers());
-        count_map_.resize(parlay::num_workers());
+        count_arr_.resize(parlay::num_workers());
 
         static_assert(is_pow_2(color_rel_bucket_c_));
         for(std::size_t w = 0; w < parlay::num_workers(); ++w)
@@ -516,6 +591,26 @@ Subgraphs_Scratch_Space<k, Colored_>::Subgraphs_Scratch_Space(const std::size_t
 }
 
 
+template <uint16_t k, bool Colored_>
+std::size_t Subgraphs_Scratch_Space<k, Colored_>::worker_bytes(const std::size_t max_sz)
+{
+    std::size_t bytes = map_bytes(max_sz);
+    if constexpr(Colored_)
+        bytes += color_rel_bucket_c_ * color_rel_buf_sz + max_sz * sizeof(in_process_t);
+
+    return bytes;
+}
+
+
+template <uint16_t k, bool Colored_>
+std::size_t Subgraphs_Scratch_Space<k, Colored_>::map_bytes(const std::size_t sz)
+{
+    // The map keeps its key-value pairs contiguously, and an 8-byte bucket per
+    // pair at its maximum load-factor 0.8.
+    return sz * (sizeof(typename map_t::value_type) + 10);
+}
+
+
 template <uint16_t k, bool Colored_>
 auto Subgraphs_Scratch_Space<k, Colored_>::map() -> map_t&
 {
@@ -569,11 +664,11 @@ auto Subgraphs_Scratch_Space<k, Colored_>::color_rel_collate_arr() -> color_rel_
 
 
 template <uint16_t k, bool Colored_>
-auto Subgraphs_Scratch_Space<k, Colored_>::count_map() -> count_map_t&
+auto Subgraphs_Scratch_Space<k, Colored_>::count_arr() -> count_arr_t&
 {
     // assert(Colored_);
-    assert(count_map_.size() == parlay::num_workers());
-    return count_map_[parlay::worker_id()].unwrap();
+    assert(count_arr_.size() == parlay::num_workers());
+    return count_arr_[parlay::worker_id()].unwrap();
 }
 
 
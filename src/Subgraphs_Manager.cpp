@@ -1,19 +1,21 @@
 
 #include "Subgraphs_Manager.hpp"
 #include "Atlas.hpp"
-#include "Spin_Lock.hpp"
+#include "Task_Pool.hpp"
 #include "Subgraph.hpp"
+#include "Color_Table.hpp"
 #include "Data_Logistics.hpp"
 #include "globals.hpp"
 #include "utility.hpp"
 #include "parlay/parallel.h"
 
-#include <array>
 #include <atomic>
 #include <cstdint>
 #include <limits>
+#include <numeric>
 #include <vector>
 #include <utility>
+#include <thread>
 #include <filesystem>
 #include <iostream>
 #include <cstdlib>
@@ -24,30 +26,49 @@ namespace cuttlefish
 {
 
 template <uint16_t k, bool Colored_>
-Subgraphs_Manager<k, Colored_>::Subgraphs_Manager(const Data_Logistics& logistics, const uint16_t l, Discontinuity_Graph<k, Colored_>& G, op_buf_list_t& op_buf):
+Subgraphs_Manager<k, Colored_>::Subgraphs_Manager(const Data_Logistics& logistics, const Memory_Budget& budget, const Atlas_Geometry& geometry, const uint16_t l, Discontinuity_Graph<k, Colored_>& G, op_buf_list_t& op_buf):
       path_pref(logistics.atlas_path())
     , color_rel_path_pref(logistics.color_rel_bucket_path())
     , l(l)
-    // , HLL(atlas_count)
+    , budget(budget)
+    , geometry(geometry)
+    , HLL(geometry.graph_count(), HyperLogLog(true))
     , G_(G)
     , trivial_mtig_count_(0)
     , icc_count_(0)
     , op_buf(op_buf)
     , color_path_pref(logistics.output_file_path())
 {
-    const auto chunk_cap = chunk_bytes / Super_Kmer_Chunk<Colored_>::record_size(k, l);
-    const auto chunk_cap_per_w = w_chunk_bytes / Super_Kmer_Chunk<Colored_>::record_size(k, l);
+    // Each atlas has a chunk and its flush-buffer, either of which may overgrow
+    // while the other is flushed, the worker-local chunks, and the chunks of
+    // its subgraphs. A subgraph's chunk is written through two compressed
+    // buffers, each about as large as the chunk at worst. These are scaled
+    // down uniformly if all the atlases do not fit in the memory budget for
+    // partitioning.
+    const auto atlas_c = geometry.atlas_count();
+    const auto pref_atlas_bytes = 2 * Atlas<Colored_>::max_chunk_growth * chunk_bytes + parlay::num_workers() * w_chunk_bytes + geometry.graph_per_atlas() * 3 * subgraph_chunk_bytes;
+    const auto atlas_bytes = budget.buffer_bytes(Memory_Budget::Stage::partition, pref_atlas_bytes, atlas_c, 0);
+    const double scale = static_cast<double>(atlas_bytes) / pref_atlas_bytes;
+
+    const auto rec_size = Super_Kmer_Chunk<Colored_>::record_size(k, l);
+    const auto cap = [&](const std::size_t pref_bytes)
+        { return std::max(std::max(static_cast<std::size_t>(pref_bytes * scale), min_chunk_bytes) / rec_size, static_cast<std::size_t>(1)); };
+    const auto chunk_cap = cap(chunk_bytes);
+    const auto chunk_cap_per_w = cap(w_chunk_bytes);
+    const auto subgraph_chunk_cap = cap(subgraph_chunk_bytes);
+
+    if(scale < 1.0)
+        std::cerr << "Super k-mer chunks are scaled down to " << (scale * 100) << "% of their preferred capacities per the memory budget.\n";
 
     const auto atlas_path_pref = logistics.atlas_path();
     std::filesystem::create_directories(atlas_path_pref);
 
-    const auto atlas_c = Atlas<Colored_>::atlas_count();
     atlas.reserve(atlas_c);
     for(std::size_t a_id = 0; a_id < atlas_c; ++a_id)
     {
         const std::string atlas_dir = atlas_path_pref + "/" + std::to_string(a_id);
         std::filesystem::create_directory(atlas_dir);
-        atlas.emplace_back(atlas_t(k, l, atlas_dir, chunk_cap, chunk_cap_per_w));
+        atlas.emplace_back(atlas_t(k, l, atlas_dir, geometry.graph_per_atlas(), chunk_cap, chunk_cap_per_w, subgraph_chunk_cap));
     }
 }
 
@@ -95,28 +116,69 @@ void Subgraphs_Manager<k, Colored_>::finalize()
 }
 
 
+template <uint16_t k, bool Colored_>
+uint64_t Subgraphs_Manager<k, Colored_>::estimate_size(const std::size_t g) const
+{
+    assert(g < HLL.size());
+    return HLL[g].unwrap().estimate() << log_HLL_sample_gap;
+}
+
+
 template <uint16_t k, bool Colored_>
 uint64_t Subgraphs_Manager<k, Colored_>::estimate_size_max() const
 {
-/*
     uint64_t max_est = 0;
-    for(std::size_t g_id = 0; g_id < graph_count_; ++g_id)
-        max_est = std::max(max_est, HLL[g_id].unwrap().estimate());
+    for(std::size_t g = 0; g < HLL.size(); ++g)
+        max_est = std::max(max_est, estimate_size(g));
 
     return max_est;
-*/
-    return 0;   // TODO: temporary.
 }
 
 
 template <uint16_t k, bool Colored_>
 void Subgraphs_Manager<k, Colored_>::process()
 {
-    Subgraphs_Scratch_Space<k, Colored_> subgraphs_space(estimate_size_max() * 1.10, color_rel_path_pref);
+    std::vector<std::pair<uint64_t, uint64_t>> A(graph_count());
+    std::vector<uint64_t> sz_est(A.size()); // Estimated sizes of the subgraphs.
+    parlay::parallel_for(0, A.size(),
+    [&](const auto g){
+        const auto a_id = geometry.atlas_ID(g);
+        const auto g_id = geometry.graph_ID(g);
+        const auto& b = atlas[a_id].unwrap().bucket(g_id);
+        A[g] = {b.bytes(), g};
+        sz_est[g] = estimate_size(g) * 1.10;
+    });
+
+    std::sort(A.begin(), A.end(), std::greater<>());
+
+    const uint64_t max_sz_est = *std::max_element(sz_est.cbegin(), sz_est.cend());
+
+    constexpr auto stage = Memory_Budget::Stage::subgraphs;
+    std::size_t color_table_cap = 0;
+    std::size_t color_repo_worker_bytes = 0;
+    if constexpr(Colored_)  // The color-table is allowed one of four equal shares of the budget, and the in-memory color-repository a sixteenth.
+        color_table_cap = budget.buffer_bytes(stage, Color_Table::default_capacity() * Color_Table::bytes_per_entry(), 4, 0) / Color_Table::bytes_per_entry(),
+        color_repo_worker_bytes = budget.buffer_bytes(stage, Color_Repo::pref_worker_mem_bytes, 16 * parlay::num_workers(), 0);
+
+    // Splitting a subgraph's construction is allowed only if all the workers
+    // fit in the budget with the maps of the parts as well: the parts of a
+    // split subgraph have about as many vertices as the subgraph in total, and
+    // each worker has at most one split subgraph pending.
+    typedef Subgraphs_Scratch_Space<k, Colored_> space_t;
+    const auto worker_bytes = space_t::worker_bytes(max_sz_est) + read_ahead_bytes;
+    const auto color_bytes = color_table_cap * Color_Table::bytes_per_entry() +
+                             color_repo_worker_bytes * parlay::num_workers() + G_.vertex_color_map_mem_bytes();
+    const bool split_allowed = (!Colored_ && parlay::num_workers() > 1 &&
+                                budget.worker_count(stage, worker_bytes + space_t::map_bytes(max_sz_est), color_bytes) == parlay::num_workers());
+    const auto worker_c = (split_allowed ? parlay::num_workers() : budget.worker_count(stage, worker_bytes, color_bytes));
+    if(worker_c < parlay::num_workers())
+        std::cerr << "Processing at most " << worker_c << " subgraphs simultaneously per the memory budget.\n";
+
+    Subgraphs_Scratch_Space<k, Colored_> subgraphs_space(max_sz_est, color_rel_path_pref, color_table_cap);
     force_free(HLL);
 
     if constexpr(Colored_)
-        subgraphs_space.color_repo().init(color_path_pref + ".col");
+        subgraphs_space.color_repo().init(color_path_pref + ".col", color_repo_worker_bytes);
 
     std::atomic_uint64_t solved = 0;
 
@@ -144,15 +206,90 @@ void Subgraphs_Manager<k, Colored_>::process()
     std::vector<Padded<double[4]>> color_time(parlay::num_workers());   // Time taken in various steps of coloring.
     std::for_each(color_time.begin(), color_time.end(), [&](auto& c){ std::memset(c.unwrap(), 0, 4 * sizeof(double)); });
 
-    const auto process_graph = [&](const std::size_t g)
+    // Subgraphs are dealt to the workers' task-queues in decreasing order of
+    // size, and idle workers steal from the others. The construction of an
+    // oversized subgraph is split into parts over ranges of its super k-mer
+    // chunks, which are shared through a separate pool so that idle workers
+    // can help with them. Parts carry their own maps, so they can be run by
+    // any worker; these are pre-sized to an even share of the subgraph's
+    // estimated size. The color-set hashes of
+    // vertices depend on the order of their super k-mers, so colored
+    // subgraphs are not split.
+    typedef typename Subgraph<k, Colored_>::Part part_t;
+    struct Split_Graph
     {
-        const auto a_id = Atlas<Colored_>::atlas_ID(g);
-        const auto g_id = Atlas<Colored_>::graph_ID(g);
+        const Super_Kmer_Bucket<Colored_>* B;   // Bucket of the subgraph.
+        std::vector<part_t> P;  // Parts of the subgraph.
+        std::vector<std::size_t> chunk_beg; // Chunk-ranges of the parts: the `i`'th part is `[chunk_beg[i], chunk_beg[i + 1])`.
+        std::size_t part_sz_est;    // Estimated number of vertices in each part.
+        std::atomic_size_t pending; // Number of parts yet to be constructed.
+    };
+
+    typedef std::pair<Split_Graph*, std::size_t> part_task_t;
+    Task_Pool<std::size_t> graph_pool(worker_c);
+    Task_Pool<part_task_t> part_pool(worker_c);
+    for(std::size_t i = 0; i < A.size(); ++i)
+        graph_pool.push(i % worker_c, A[i].second);
+
+    const auto sum_bytes = std::accumulate(A.cbegin(), A.cend(), 0lu, [](const auto s, const auto& a){ return s + a.first; });
+    const auto split_bytes = std::max(sum_bytes / (split_factor * worker_c), min_split_bytes);  // Subgraphs larger than this are split.
+    std::atomic_uint64_t split_c = 0;   // Number of split subgraphs.
+
+    const auto construct_part = [&](const part_task_t& t)
+    {
+        auto& S = *t.first;
+        const auto i = t.second;
+        S.P[i].construct(*S.B, S.chunk_beg[i], S.chunk_beg[i + 1], S.part_sz_est);
+        S.pending--;
+    };
+
+    const auto process_graph = [&](const std::size_t g, const std::size_t w)
+    {
+        // The bucket of the worker's next subgraph is read ahead while this
+        // one is processed; if that subgraph is stolen, the thief gets the
+        // read-ahead.
+        std::size_t g_next;
+        if(graph_pool.peek(w, g_next))
+            atlas[geometry.atlas_ID(g_next)].unwrap().bucket(geometry.graph_ID(g_next)).read_ahead(read_ahead_bytes);
+
+        const auto a_id = geometry.atlas_ID(g);
+        const auto g_id = geometry.graph_ID(g);
         auto& b = atlas[a_id].unwrap().bucket(g_id);
 
         const auto t_0 = timer::now();
-        Subgraph<k, Colored_> sub_dBG(b, G_, op_buf[parlay::worker_id()].unwrap(), subgraphs_space);
-        sub_dBG.construct();
+        Subgraph<k, Colored_> sub_dBG(b, G_, op_buf[parlay::worker_id()].unwrap(), subgraphs_space, sz_est[g]);
+        if(split_allowed && b.bytes() > split_bytes && b.chunk_count() > 1)
+        {
+            const auto part_c = std::min(b.chunk_count(), worker_c);
+            Split_Graph S;
+            S.B = &b;
+            S.P.resize(part_c);
+            S.chunk_beg.resize(part_c + 1);
+            for(std::size_t i = 0; i <= part_c; ++i)
+                S.chunk_beg[i] = (b.chunk_count() * i) / part_c;
+            S.part_sz_est = sz_est[g] / part_c;
+            S.pending = part_c;
+
+            for(std::size_t i = 1; i < part_c; ++i)
+                part_pool.push(w, {&S, i});
+
+            S.P[0].construct(b, S.chunk_beg[0], S.chunk_beg[1], S.part_sz_est);
+            S.pending--;
+
+            // Help with the pending parts, of this or of other split subgraphs.
+            // If none is left in the pool, the last ones are running elsewhere.
+            part_task_t t;
+            while(S.pending > 0)
+                if(part_pool.next(w, t))
+                    construct_part(t);
+                else
+                    std::this_thread::yield();
+
+            sub_dBG.construct(S.P);
+            split_c++;
+        }
+        else
+            sub_dBG.construct();
         const auto t_1 = timer::now();
         if constexpr(!Colored_)
             b.remove();
@@ -219,45 +356,33 @@ void Subgraphs_Manager<k, Colored_>::process()
     };
 
 
-    std::array<std::pair<uint64_t, uint64_t>, Atlas<Colored_>::graph_count()> A;
-    parlay::parallel_for(0, A.size(),
-    [&](const auto g){
-        const auto a_id = Atlas<Colored_>::atlas_ID(g);
-        const auto g_id = Atlas<Colored_>::graph_ID(g);
-        const auto& b = atlas[a_id].unwrap().bucket(g_id);
-        A[g] = {b.bytes(), g};
-    });
-
-    std::sort(A.begin(), A.end(), std::greater<>());
-    std::size_t next_g = 0;
-    Spin_Lock g_lock;
-    parlay::parallel_for(0, parlay::num_workers(),
-    [&](auto)
+    parlay::parallel_for(0, worker_c,
+    [&](const std::size_t w)
     {
         if constexpr(Colored_)
             subgraphs_space.bv().resize_init(((G().max_source_id() + 1) + 63) / 64);
 
+        part_task_t t;
+        std::size_t g;
         while(true)
-        {
-            g_lock.lock();
-
-            if(next_g == A.size())
-            {
-                g_lock.unlock();
+            if(part_pool.next(w, t))
+                construct_part(t);
+            else if(graph_pool.next(w, g))
+                process_graph(g, w);
+            else
                 break;
-            }
-
-            const auto g = A[next_g++].second;
-            g_lock.unlock();
-
-            process_graph(g);
-        }
     }, 1);
 
     std::cerr << "\n";
+    if(split_c > 0)
+        std::cerr << "Split the construction of " << split_c << " oversized subgraphs.\n";
 
     if constexpr(Colored_)
-        subgraphs_space.color_repo().close();
+    {
+        auto& color_repo = subgraphs_space.color_repo();
+        color_repo.close();
+        color_repo.finalize(color_path_pref + ".col", G_.max_source_id() + 1);
+    }
 
     const auto sum_time = [&](const std::vector<Padded<double>>& T)
         { double t = 0; std::for_each(T.cbegin(), T.cend(), [&t](const auto& v){ t += v.unwrap(); }); return t; };
@@ -1,11 +1,16 @@
 
 #include "Super_Kmer_Bucket.hpp"
+#include "utility.hpp"
 
 #include <cstddef>
 #include <cstdint>
 #include <cstdlib>
 #include <iostream>
+#include <algorithm>
+#include <thread>
 #include <cassert>
+#include <unistd.h>
+#include <fcntl.h>
 
 
 namespace cuttlefish
@@ -13,11 +18,14 @@ namespace cuttlefish
 
 template <bool Colored_>
 Super_Kmer_Bucket<Colored_>::Super_Kmer_Bucket(const uint16_t k, const uint16_t l, const std::string& path, const std::size_t chunk_cap):
-      path_(path)
-    , output(path_, std::ios::binary)
+      k(k)
+    , l(l)
+    , path_(path)
+    , output(path_)
     , size_(0)
     , chunk_cap(chunk_cap)
     , chunk(k, l, chunk_cap)
+    , cmp_cur(0)
     , bytes_(0)
     , compressed_bytes_(0)
 {}
@@ -28,9 +36,14 @@ void Super_Kmer_Bucket<Colored_>::flush_chunk()
 {
     if(!chunk.empty())
     {
-        assert(output);
+        assert(output.is_open());
         // chunk.serialize(output);
-        cmp_bytes.push_back(chunk.serialize_compressed(output));
+        // The writer returns once the write from the other buffer completes.
+        auto& buf = (cmp_cur == 0 ? cmp_buf : chunk.compression_buffer());
+        cmp_bytes.push_back(chunk.compress(buf));
+        output.write(buf.data(), cmp_bytes.back().first + cmp_bytes.back().second);
+        cmp_cur ^= 1;
+
         chunk_sz.push_back(chunk.size());
 
         bytes_ += chunk.bytes();
@@ -46,20 +59,99 @@ void Super_Kmer_Bucket<Colored_>::close()
 {
     flush_chunk();
     output.close();
+
+    cmp_buf.free(), chunk.compression_buffer().free();
+}
+
+
+template <bool Colored_>
+void Super_Kmer_Bucket<Colored_>::read_ahead(const std::size_t max_bytes)
+{
+    auto& ra = read_ahead_;
+    uint8_t s = Read_Ahead::none;
+    if(chunk_sz.empty() || !ra.state.compare_exchange_strong(s, Read_Ahead::issuing))
+        return;
+
+    std::size_t bytes = 0;
+    std::size_t c = 0;
+    for(; c < chunk_count(); ++c)
+    {
+        const std::size_t b = cmp_bytes[c].first + cmp_bytes[c].second;
+        if(c > 0 && bytes + b > max_bytes)
+            break;
+
+        bytes += b;
+    }
+
+    ra.fd = ::open(path_.c_str(), O_RDONLY);
+    if(ra.fd < 0)
+    {
+        std::cerr << "Error opening super k-mer bucket at " << path_ << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    ra.chunk_c = c;
+    ra.buf.reserve_uninit(bytes);
+    Async_IO::get().read(ra.req, ra.fd, ra.buf.data(), bytes, 0);
+
+    ra.state.store(Read_Ahead::issued, std::memory_order_release);
+}
+
+
+template <bool Colored_>
+bool Super_Kmer_Bucket<Colored_>::claim_read_ahead(Buffer<uint8_t>& buf, std::size_t& chunk_c) const
+{
+    auto& ra = read_ahead_;
+    uint8_t s;
+    while(true)
+    {
+        s = ra.state.load(std::memory_order_acquire);
+        if(s == Read_Ahead::issuing)    // The issuer is about done.
+            std::this_thread::yield();
+        else if(s == Read_Ahead::claimed)
+            return false;
+        else if(ra.state.compare_exchange_weak(s, Read_Ahead::claimed, std::memory_order_acq_rel))
+            break;
+    }
+
+    if(s == Read_Ahead::none)
+        return false;
+
+    const auto ok = Async_IO::get().wait(ra.req);
+    ::close(ra.fd);
+    ra.fd = -1;
+    if(!ok)
+    {
+        std::cerr << "Error reading from super k-mer bucket at " << path_ << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    buf = std::move(ra.buf);
+    chunk_c = ra.chunk_c;
+    return true;
 }
 
 
 template <bool Colored_>
 void Super_Kmer_Bucket<Colored_>::remove()
 {
+    {   // An unclaimed read-ahead is dropped.
+        Buffer<uint8_t> buf;
+        std::size_t chunk_c;
+        claim_read_ahead(buf, chunk_c);
+    }
+
+    // A pending write may be from the chunk's compression-buffer.
+    if(output.is_open())
+        output.close();
+
     chunk.free();
     force_free(chunk_sz);
     force_free(cmp_bytes);
 
-    if(output.is_open())
-        output.close();
+    cmp_buf.free();
 
-    if(!output || !remove_file(path_))
+    if(!remove_file(path_))
     {
         std::cerr << "Error removing file at " << path_ << ". Aborting.\n";
         std::exit(EXIT_FAILURE);
@@ -70,13 +162,88 @@ void Super_Kmer_Bucket<Colored_>::remove()
 template <bool Colored_>
 Super_Kmer_Bucket<Colored_>::Iterator::Iterator(const Super_Kmer_Bucket& B):
       B(B)
-    , input(B.path_, std::ios::in | std::ios::binary)
+    , fd(-1)
+    , chunk(B.chunk)
     , idx(0)
+    , end_idx(B.size())
     , chunk_start_idx(0)
     , chunk_end_idx(0)
     , chunk_id(0)
+    , chunk_end_id(B.chunk_count())
+    , chunk_off(0)
+    , cmp_cur(0)
+    , staged_c(0)
 {
-    assert(input);
+    open();
+    B.claim_read_ahead(staged, staged_c);
+}
+
+
+template <bool Colored_>
+Super_Kmer_Bucket<Colored_>::Iterator::Iterator(const Super_Kmer_Bucket& B, const std::size_t chunk_beg, const std::size_t chunk_end):
+      B(B)
+    , fd(-1)
+    , chunk(range_chunk)
+    , idx(0)
+    , end_idx(0)
+    , chunk_start_idx(0)
+    , chunk_end_idx(0)
+    , chunk_id(chunk_beg)
+    , chunk_end_id(chunk_end)
+    , chunk_off(0)
+    , cmp_cur(0)
+    , staged_c(0)
+{
+    open();
+    if(chunk_beg == 0)
+        B.claim_read_ahead(staged, staged_c);
+
+    assert(chunk_beg <= chunk_end && chunk_end <= B.chunk_count());
+
+    std::size_t off = 0;    // Byte-offset of the range in the bucket-file.
+    for(std::size_t c = 0; c < chunk_beg; ++c)
+        idx += B.chunk_sz[c],
+        off += B.cmp_bytes[c].first + B.cmp_bytes[c].second;
+
+    std::size_t max_chunk_sz = 1;
+    end_idx = idx;
+    for(std::size_t c = chunk_beg; c < chunk_end; ++c)
+        end_idx += B.chunk_sz[c],
+        max_chunk_sz = std::max(max_chunk_sz, static_cast<std::size_t>(B.chunk_sz[c]));
+
+    chunk_start_idx = chunk_end_idx = idx;
+    range_chunk = chunk_t(B.k, B.l, max_chunk_sz);
+    chunk_off = off;
+}
+
+
+template <bool Colored_>
+Super_Kmer_Bucket<Colored_>::Iterator::~Iterator()
+{
+    Async_IO::get().wait(fetch_req);    // The iteration may have stopped short.
+    if(fd >= 0)
+        ::close(fd);
+}
+
+
+template <bool Colored_>
+void Super_Kmer_Bucket<Colored_>::Iterator::open()
+{
+    fd = ::open(B.path_.c_str(), O_RDONLY);
+    if(fd < 0)
+    {
+        std::cerr << "Error opening super k-mer bucket at " << B.path_ << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+}
+
+
+template <bool Colored_>
+void Super_Kmer_Bucket<Colored_>::Iterator::fetch(const std::size_t c, const off_t off, const uint8_t b)
+{
+    const auto bytes = B.cmp_bytes[c].first + B.cmp_bytes[c].second;
+    cmp_buf[b].reserve_uninit(bytes);
+    Async_IO::get().read(fetch_req, fd, cmp_buf[b].data(), bytes, off);
 }
 
 
@@ -84,12 +251,44 @@ Super_Kmer_Bucket<Colored_>::Iterator::Iterator(const Super_Kmer_Bucket& B):
 template <bool Colored_>
 std::size_t Super_Kmer_Bucket<Colored_>::Iterator::read_chunk()
 {
-    assert(chunk_end_idx < B.size());
-    assert(chunk_id < B.chunk_sz.size());
+    assert(chunk_end_idx < end_idx);
+    assert(chunk_id < chunk_end_id);
     const auto super_kmers_to_read = B.chunk_sz[chunk_id];
+    const auto cmp_bytes = B.cmp_bytes[chunk_id];
+    const auto next_off = chunk_off + cmp_bytes.first + cmp_bytes.second;
+    const bool has_next = (chunk_id + 1 < chunk_end_id);
+
+    if(chunk_id < staged_c) // The chunk has been read ahead.
+    {
+        // The chunk after the read-ahead ones is prefetched into the current
+        // buffer, which is what the next read uses.
+        if(chunk_id + 1 == staged_c && has_next)
+            fetch(chunk_id + 1, next_off, cmp_cur);
+
+        chunk.decompress(staged.data() + chunk_off, super_kmers_to_read, cmp_bytes);
+        if(chunk_id + 1 == staged_c)
+            staged.free();
+    }
+    else
+    {
+        if(!fetch_req.in_flight())  // Only the first chunk is not prefetched, if not read ahead.
+            fetch(chunk_id, chunk_off, cmp_cur);
+
+        if(!Async_IO::get().wait(fetch_req))
+        {
+            std::cerr << "Error reading from super k-mer bucket at " << B.path_ << ". Aborting.\n";
+            std::exit(EXIT_FAILURE);
+        }
+
+        if(has_next)
+            fetch(chunk_id + 1, next_off, cmp_cur ^ 1);
+
+        // chunk.deserialize(input, super_kmers_to_read);
+        chunk.decompress(cmp_buf[cmp_cur].data(), super_kmers_to_read, cmp_bytes);
+        cmp_cur ^= 1;
+    }
 
-    // B.chunk.deserialize(input, super_kmers_to_read);
-    B.chunk.deserialize_decompressed(input, super_kmers_to_read, B.cmp_bytes[chunk_id]);
+    chunk_off = next_off;
     chunk_id++;
 
     return super_kmers_to_read;
@@ -99,7 +298,7 @@ std::size_t Super_Kmer_Bucket<Colored_>::Iterator::read_chunk()
 template <bool Colored_>
 std::size_t Super_Kmer_Bucket<Colored_>::RSS() const
 {
-    return chunk.RSS() + memory::RSS(chunk_sz) + memory::RSS(cmp_bytes);
+    return chunk.RSS() + cmp_buf.RSS() + memory::RSS(chunk_sz) + memory::RSS(cmp_bytes);
 }
 
 }
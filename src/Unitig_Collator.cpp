@@ -15,7 +15,11 @@
 #include <algorithm>
 #include <filesystem>
 #include <iostream>
+#include <cerrno>
 #include <cassert>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
 
 
 // TODO: use more efficient data structures throughout the collator.
@@ -25,14 +29,19 @@ namespace cuttlefish
 {
 
 template <uint16_t k, bool Colored_>
-Unitig_Collator<k, Colored_>::Unitig_Collator(Discontinuity_Graph<k, Colored_>& G, P_e_t& P_e, const Data_Logistics& logistics, op_buf_list_t& op_buf, const std::size_t gmtig_bucket_count):
+Unitig_Collator<k, Colored_>::Unitig_Collator(Discontinuity_Graph<k, Colored_>& G, P_e_t& P_e, const Data_Logistics& logistics, const Memory_Budget& budget, op_buf_list_t& op_buf, const std::size_t gmtig_bucket_count, const bool retain_input, const bool positional_op):
       G(G)
     , P_e(P_e)
     , lmtig_buckets_path(logistics.lmtig_buckets_path())
     , unitig_coord_buckets_path(logistics.unitig_coord_buckets_path())
+    , budget(budget)
     , max_unitig_bucket_count(gmtig_bucket_count)
     , op_buf(op_buf)
     , phantom_c_(0)
+    , retain_input(retain_input)
+    , positional_op(positional_op)
+    , op_file_path(logistics.output_file_path())
+    , binary_op(op_buf.front().unwrap().binary())
 {
      // TODO: fix better policy?
     if((max_unitig_bucket_count & (max_unitig_bucket_count - 1)) != 0)
@@ -90,12 +99,10 @@ void Unitig_Collator<k, Colored_>::map()
     std::vector<Padded<buf_t>> buf_vec(parlay::num_workers()); // Worker-local buffers to read in edge path-info.
     std::vector<Padded<v_c_map_t>> v_c_map_vec(parlay::num_workers());  // Worker-local buffers to read in vertex-color mappings.
 
-    parlay::parallel_for(0, parlay::num_workers(),
-        [&](const std::size_t w_id)
-        {
-            // TODO: no need to resize to the maximum bucket-size, as we use more suited buffer now instead of `vector`.
-            M_vec[w_id].unwrap().resize_uninit(max_bucket_sz);   // TODO: thread-local allocation suits best here.
-        }, 1);
+    // Each worker needs its DAT and its path-info buffer, both of the maximum edge-bucket size.
+    const auto worker_c = budget.worker_count(Memory_Budget::Stage::collate, max_bucket_sz * (sizeof(Path_Info<k>) + sizeof(unitig_path_info_t)));
+    if(worker_c < parlay::num_workers())
+        std::cerr << "Mapping with at most " << worker_c << " workers per the memory budget.\n";
 
 
     max_unitig_bucket.reserve(max_unitig_bucket_count);
@@ -116,9 +123,12 @@ void Unitig_Collator<k, Colored_>::map()
         auto& buf = buf_vec[w_id].unwrap();
         auto& v_c_map = v_c_map_vec[w_id].unwrap();
 
+        // TODO: no need to resize to the maximum bucket-size, as we use more suited buffer now instead of `vector`.
+        M.reserve_uninit(max_bucket_sz);    // TODO: thread-local allocation suits best here.
         const auto b_sz = load_path_info(b, M.data(), buf);
         edge_c += b_sz;
-        P_e[b].unwrap().remove();
+        if(!retain_input)
+            P_e[b].unwrap().remove();
 
 #ifndef NDEBUG
         uint64_t h = 0;
@@ -188,12 +198,15 @@ void Unitig_Collator<k, Colored_>::map()
         assert(idx == b_sz);
         assert(color_idx == v_c_map_sz);
 
-        unitig_reader.remove_files();
-        if constexpr(Colored_)
-            G.vertex_color_map(b).remove();
+        if(!retain_input)
+        {
+            unitig_reader.remove_files();
+            if constexpr(Colored_)
+                G.vertex_color_map(b).remove();
+        }
     };
 
-    parlay::parallel_for(1, P_e.size(), map_to_max_unitig_bucket, 1);
+    throttled_for(1, P_e.size(), worker_c, map_to_max_unitig_bucket);
 
     std::cerr << "Found " << edge_c << " edges.\n";
 #ifndef NDEBUG
@@ -230,16 +243,46 @@ void Unitig_Collator<k, Colored_>::reduce()
     std::vector<Padded<coord_buf_t>> U_vec(parlay::num_workers()); // Worker-local buffers for unitig coordinate information.
     std::vector<Padded<label_buf_t>> L_vec(parlay::num_workers()); // Worker-local buffers for dump-strings in buckets.
     std::vector<Padded<color_buf_t>> C_vec(parlay::num_workers()); // Worker-local buffers for colors in buckets.
+    std::vector<Padded<std::string>> O_vec(parlay::num_workers()); // Worker-local buffers for buckets' outputs, in the positional mode.
+
+    // In the positional mode, the output size of each bucket is computed
+    // beforehand, so that each bucket's output has its own pre-allocated
+    // stretch of the output file, in the order of the buckets.
+    const bool positional = (!Colored_ && positional_op);
+    std::vector<std::size_t> op_off;    // `op_off[b]` is the offset of bucket `b`'s output in the output file; `op_off[b + 1] - op_off[b]` is its size.
+    std::size_t max_op_sz = 0;  // Maximum output size of some maximal unitig bucket.
+    int fd = -1;    // Descriptor of the output file in the positional mode.
+    if(positional)
+    {
+        const auto t_s = timer::now();
 
-    parlay::parallel_for(0, parlay::num_workers(),
-        [&](const std::size_t w_id)
-        {
-            // TODO: thread-local allocations here suit best.
-            U_vec[w_id].unwrap().resize_uninit(max_max_uni_b_sz);
-            L_vec[w_id].unwrap().resize_uninit(max_max_uni_b_label_len);
-            if constexpr(Colored_)
-                C_vec[w_id].unwrap().resize_uninit(max_max_uni_b_color_c);
-        }, 1);
+        op_off.resize(max_unitig_bucket_count + 1);
+        const auto sz_worker_c = budget.worker_count(Memory_Budget::Stage::collate, max_max_uni_b_sz * sizeof(Unitig_Coord<k, Colored_>));
+        throttled_for(0, max_unitig_bucket_count, sz_worker_c,
+            [&](const std::size_t b)
+            {
+                auto& U = U_vec[parlay::worker_id()].unwrap();
+                U.reserve_uninit(max_max_uni_b_sz);
+                op_off[b + 1] = output_size(b, U.data());
+            });
+
+        op_off[0] = 0;
+        for(std::size_t b = 0; b < max_unitig_bucket_count; ++b)
+            max_op_sz = std::max(max_op_sz, op_off[b + 1]),
+            op_off[b + 1] += op_off[b];
+
+        const auto [op_fd, base] = preallocate_output(op_off.back());
+        fd = op_fd;
+        std::for_each(op_off.begin(), op_off.end(), [base = base](auto& off){ off += base; });
+
+        std::cerr << "Positional output of " << (op_off.back() - op_off.front()) << " bytes laid out. Time taken: " << timer::duration(timer::now() - t_s) << "s.\n";
+    }
+
+    // Each worker needs its coordinate, dump-string, and color buffers, of the largest bucket's sizes; and its output buffer in the positional mode.
+    const auto w_bytes = max_max_uni_b_sz * sizeof(Unitig_Coord<k, Colored_>) + max_max_uni_b_label_len + max_max_uni_b_color_c * sizeof(Unitig_Color) + max_op_sz;
+    const auto worker_c = budget.worker_count(Memory_Budget::Stage::collate, w_bytes);
+    if(worker_c < parlay::num_workers())
+        std::cerr << "Reducing with at most " << worker_c << " workers per the memory budget.\n";
 
     // TODO: add per-worker progress tracker.
 
@@ -247,110 +290,261 @@ void Unitig_Collator<k, Colored_>::reduce()
     [&](const std::size_t b)
     {
         const auto w_id = parlay::worker_id();
+
+        // TODO: thread-local allocations here suit best.
+        U_vec[w_id].unwrap().reserve_uninit(max_max_uni_b_sz);
+        L_vec[w_id].unwrap().reserve_uninit(max_max_uni_b_label_len);
+        if constexpr(Colored_)
+            C_vec[w_id].unwrap().reserve_uninit(max_max_uni_b_color_c);
+
         auto const U = U_vec[w_id].unwrap().data(); // Coordinate info of the unitigs.
         auto const L = L_vec[w_id].unwrap().data();   // Dump-strings of the unitig labels.
         auto const C = C_vec[w_id].unwrap().data(); // Colors of the unitigs.
-        auto& output = op_buf[w_id].unwrap();   // Output buffer for the maximal unitigs.
 
-        const auto b_sz = max_unitig_bucket[b].unwrap().load_coords(U);
-        const auto len = max_unitig_bucket[b].unwrap().load_labels(L);
-        const auto color_c = (Colored_ ? max_unitig_bucket[b].unwrap().load_colors(C) : 0);
-        max_unitig_bucket[b].unwrap().remove();
-        (void)len; (void)color_c;
+        if(positional)
+        {
+            auto& output = O_vec[w_id].unwrap();    // Output of the bucket.
+            output.clear();
+            output.reserve(max_op_sz);
 
-        std::sort(U, U + b_sz);
+            reduce_bucket(b, U, L, C,
+                [&](const Maximal_Unitig& m_tig)
+                {
+                    const FASTA_Record rec(0, std::string_view(m_tig.data(), m_tig.size()));
+                    if(binary_op)
+                        rec.append_binary(output);
+                    else
+                    {
+                        rec.append_header(output);
+                        output.push_back('\n');
+                        rec.append_seq(output);
+                        output.push_back('\n');
+                    }
+                });
 
-        Maximal_Unitig m_tig(*this);
-        std::size_t i, j;
-        for(i = 0; i < b_sz; i = j)
-        {
-            m_tig.clear();
+            if(output.size() != op_off[b + 1] - op_off[b])
+            {
+                // A mismatch would overwrite the neighbouring buckets' regions of the output.
+                std::cerr << "Output of maximal unitig bucket " << b << " is " << output.size() << " bytes; expected " << (op_off[b + 1] - op_off[b]) << " bytes. Aborting.\n";
+                std::exit(EXIT_FAILURE);
+            }
 
-            const bool is_cycle = U[i].is_cycle();
-            const std::size_t s = i;
-            std::size_t e = s;
+            write_output(fd, output.data(), output.size(), op_off[b]);
+            return;
+        }
 
-            // Find the current maximal unitig's stretch in the bucket.
-            while(e < b_sz && U[e].p() == U[s].p())
+        auto& output = op_buf[w_id].unwrap();   // Output buffer for the maximal unitigs.
+        reduce_bucket(b, U, L, C,
+            [&](const Maximal_Unitig& m_tig)
             {
-                assert(U[e].o() != side_t::unspecified); assert(U[e].is_cycle() == is_cycle);
+                // TODO: decide record-ID choice.
+                // TODO: this forms a parallel-scaling bottleneck due to the shared sink of the buffers.
+                if constexpr(!Colored_)
+                    output += FASTA_Record(0, std::string_view(m_tig.data(), m_tig.size()));
+                else
+                    output.template operator+=<true>(FASTA_Record(0, std::string_view(m_tig.data(), m_tig.size()), m_tig.color()));
+            });
+    };
 
-                assert(U[e].label_idx() + U[e].label_len() <= len);
-                if constexpr(Colored_)
-                    assert(U[e].color_idx() + U[e].color_c() <= color_c);
+    std::cerr << "Peak-RAM before collation: " << process_peak_memory() / (1024.0 * 1024.0 * 1024.0) << "\n";
+    throttled_for(0, max_unitig_bucket_count, worker_c, collate_max_unitig_bucket);
+    std::cerr << "Peak-RAM after collation:  " << process_peak_memory() / (1024.0 * 1024.0 * 1024.0) << "\n";
 
-                e++;
-            }
+    if(positional && ::close(fd) != 0)
+    {
+        std::cerr << "Error closing output file at " << op_file_path << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+}
 
-            if(e - s == 2 && !is_cycle) // Special case for handling orientation of path-traversals in the discontinuity graph.
-            {
-                assert(U[s].r() == 0); assert(U[s + 1].r() == 0);
 
-                const std::string_view u0(L + U[s].label_idx(), U[s].label_len());
-                const std::string_view u1(L + U[s + 1].label_idx(), U[s + 1].label_len());
+template <uint16_t k, bool Colored_>
+template <typename F_>
+void Unitig_Collator<k, Colored_>::reduce_bucket(const std::size_t b, Unitig_Coord<k, Colored_>* const U, char* const L, Unitig_Color* const C, F_ emit)
+{
+    const auto b_sz = max_unitig_bucket[b].unwrap().load_coords(U);
+    const auto len = max_unitig_bucket[b].unwrap().load_labels(L);
+    const auto color_c = (Colored_ ? max_unitig_bucket[b].unwrap().load_colors(C) : 0);
+    max_unitig_bucket[b].unwrap().remove();
+    (void)len; (void)color_c;
 
-                const bool rc_0 = (U[s].o() == side_t::front);
-                bool rc_1 = (U[s + 1].o() == side_t::front);
-                rc_1 = !rc_1;
+    std::sort(U, U + b_sz);
 
-                if constexpr(!Colored_)
-                {
-                    m_tig.init(u0, rc_0);
-                    m_tig.append(u1, rc_1);
-                }
-                else
-                {
-                    m_tig.init(u0, rc_0, C + U[s].color_idx(), U[s].color_c());
-                    m_tig.append(u1, rc_1, C + U[s + 1].color_idx(), U[s + 1].color_c());
-                }
-            }
-            else
-                for(j = s; j < e; ++j)
-                {
-                    const std::string_view u(L + U[j].label_idx(), U[j].label_len());
-                    const bool rc = (U[j].o() == side_t::front);
+    Maximal_Unitig m_tig(*this);
+    std::size_t i, j;
+    for(i = 0; i < b_sz; i = j)
+    {
+        m_tig.clear();
 
-                    if constexpr(!Colored_)
-                        m_tig.empty() ?
-                            m_tig.init(u, rc) :
-                            m_tig.append(u, rc);
-                    else
-                        m_tig.empty() ?
-                            m_tig.init(u, rc, C + U[j].color_idx(), U[j].color_c()) :
-                            m_tig.append(u, rc, C + U[j].color_idx(), U[j].color_c());
-                }
+        const bool is_cycle = U[i].is_cycle();
+        const std::size_t s = i;
+        std::size_t e = s;
+
+        // Find the current maximal unitig's stretch in the bucket.
+        while(e < b_sz && U[e].p() == U[s].p())
+        {
+            assert(U[e].o() != side_t::unspecified); assert(U[e].is_cycle() == is_cycle);
+
+            assert(U[e].label_idx() + U[e].label_len() <= len);
+            if constexpr(Colored_)
+                assert(U[e].color_idx() + U[e].color_c() <= color_c);
 
+            e++;
+        }
 
-            // Cyclic maximal unitig traversals start and end at the same vertex, so one copy needs to be removed.
-            if(is_cycle)
-                m_tig.pop_back();
+        if(e - s == 2 && !is_cycle) // Special case for handling orientation of path-traversals in the discontinuity graph.
+        {
+            assert(U[s].r() == 0); assert(U[s + 1].r() == 0);
 
+            const std::string_view u0(L + U[s].label_idx(), U[s].label_len());
+            const std::string_view u1(L + U[s + 1].label_idx(), U[s + 1].label_len());
 
-            // is_cycle ? m_tig.canonicalize_cycle(): m_tig.canonicalize();
+            const bool rc_0 = (U[s].o() == side_t::front);
+            bool rc_1 = (U[s + 1].o() == side_t::front);
+            rc_1 = !rc_1;
 
-            // TODO: decide record-ID choice.
             if constexpr(!Colored_)
             {
-                is_cycle ? m_tig.canonicalize_cycle(): m_tig.canonicalize();
-                output += FASTA_Record(0, std::string_view(m_tig.data(), m_tig.size()));
-                // TODO: this forms a parallel-scaling bottleneck due to the shared sink of the buffers.
+                m_tig.init(u0, rc_0);
+                m_tig.append(u1, rc_1);
             }
             else
             {
-                if(!is_cycle)
-                    m_tig.canonicalize();
+                m_tig.init(u0, rc_0, C + U[s].color_idx(), U[s].color_c());
+                m_tig.append(u1, rc_1, C + U[s + 1].color_idx(), U[s + 1].color_c());
+            }
+        }
+        else
+            for(j = s; j < e; ++j)
+            {
+                const std::string_view u(L + U[j].label_idx(), U[j].label_len());
+                const bool rc = (U[j].o() == side_t::front);
 
-                output.template operator+=<true>(FASTA_Record(0, std::string_view(m_tig.data(), m_tig.size()), m_tig.color()));
-                // TODO: this forms a parallel-scaling bottleneck due to the shared sink of the buffers.
+                if constexpr(!Colored_)
+                    m_tig.empty() ?
+                        m_tig.init(u, rc) :
+                        m_tig.append(u, rc);
+                else
+                    m_tig.empty() ?
+                        m_tig.init(u, rc, C + U[j].color_idx(), U[j].color_c()) :
+                        m_tig.append(u, rc, C + U[j].color_idx(), U[j].color_c());
             }
 
-            j = e;
+
+        // Cyclic maximal unitig traversals start and end at the same vertex, so one copy needs to be removed.
+        if(is_cycle)
+            m_tig.pop_back();
+
+
+        if constexpr(!Colored_)
+            is_cycle ? m_tig.canonicalize_cycle(): m_tig.canonicalize();
+        else
+            if(!is_cycle)
+                m_tig.canonicalize();
+
+        emit(m_tig);
+
+        j = e;
+    }
+}
+
+
+template <uint16_t k, bool Colored_>
+std::size_t Unitig_Collator<k, Colored_>::output_size(const std::size_t b, Unitig_Coord<k, Colored_>* const U) const
+{
+    assert(!Colored_);
+
+    const auto b_sz = max_unitig_bucket[b].unwrap().load_coords(U);
+    std::sort(U, U + b_sz);
+
+    // A maximal unitig's label is its first unitig's, extended with the others
+    // past their `k`-overlaps; a cyclic one drops its repeated last base.
+    const auto rec_sz = FASTA_Record(0, std::string_view()).header_size() + 2;  // Size of a FASTA record excluding its sequence; two bytes for the line-breaks.
+    std::size_t sz = 0;
+    std::size_t i, j;
+    for(i = 0; i < b_sz; i = j)
+    {
+        std::size_t len = U[i].label_len() - U[i].is_cycle();  // Length of the maximal unitig.
+        for(j = i + 1; j < b_sz && U[j].p() == U[i].p(); ++j)
+        {
+            assert(U[j].label_len() >= k);
+            len += U[j].label_len() - k;
         }
-    };
 
-    std::cerr << "Peak-RAM before collation: " << process_peak_memory() / (1024.0 * 1024.0 * 1024.0) << "\n";
-    parlay::parallel_for(0, max_unitig_bucket_count, collate_max_unitig_bucket, 1);
-    std::cerr << "Peak-RAM after collation:  " << process_peak_memory() / (1024.0 * 1024.0 * 1024.0) << "\n";
+        sz += (binary_op ? Binary_Unitig_Format::record_size(len, 0) : rec_sz + len);
+    }
+
+    return sz;
+}
+
+
+template <uint16_t k, bool Colored_>
+std::pair<int, std::size_t> Unitig_Collator<k, Colored_>::preallocate_output(const std::size_t bytes) const
+{
+    const int fd = ::open(op_file_path.c_str(), O_WRONLY | O_CREAT, 0644);
+    struct stat st;
+    if(fd < 0 || ::fstat(fd, &st) != 0)
+    {
+        std::cerr << "Error opening output file at " << op_file_path << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    const std::size_t base = st.st_size;
+    if(bytes > 0)
+    {
+        // Unsupported preallocation falls back to just extending the file.
+        const auto err = ::posix_fallocate(fd, base, bytes);
+        if(err != 0 && (err != EOPNOTSUPP || ::ftruncate(fd, base + bytes) != 0))
+        {
+            std::cerr << "Error allocating " << bytes << " bytes for output file at " << op_file_path << ". Aborting.\n";
+            std::exit(EXIT_FAILURE);
+        }
+    }
+
+    return {fd, base};
+}
+
+
+template <uint16_t k, bool Colored_>
+void Unitig_Collator<k, Colored_>::write_output(const int fd, const char* buf, const std::size_t sz, const std::size_t off) const
+{
+    std::size_t rem = sz;
+    off_t pos = off;
+    while(rem > 0)
+    {
+        const auto w = ::pwrite(fd, buf, rem, pos);
+        if(w < 0 && errno == EINTR)
+            continue;
+
+        if(w <= 0)
+        {
+            std::cerr << "Error writing to output file at " << op_file_path << ". Aborting.\n";
+            std::exit(EXIT_FAILURE);
+        }
+
+        buf += w, rem -= w, pos += w;
+    }
+}
+
+
+template <uint16_t k, bool Colored_>
+template <typename F_>
+void Unitig_Collator<k, Colored_>::throttled_for(const std::size_t beg, const std::size_t end, const std::size_t worker_c, F_ f)
+{
+    if(worker_c >= parlay::num_workers())
+    {
+        parlay::parallel_for(beg, end, f, 1);
+        return;
+    }
+
+    std::atomic_uint64_t next = beg;    // Next index to process.
+    parlay::parallel_for(0, worker_c,
+        [&](auto)
+        {
+            std::size_t i;
+            while((i = next++) < end)
+                f(i);
+        }, 1);
 }
 
 
@@ -425,11 +619,30 @@ void Unitig_Collator<k, Colored_>::emit_trivial_mtigs()
             output.template operator+=<true>(FASTA_Record(0, std::string_view(unitig.data(), uni_len), color));
         }
 
-        unitig_reader.remove_files();
-        G.vertex_color_map(P_e.size() + w).remove();
+        if(!retain_input)
+            unitig_reader.remove_files(),
+            G.vertex_color_map(P_e.size() + w).remove();
     }, 1);
 }
 
+
+template <uint16_t k, bool Colored_>
+void Unitig_Collator<k, Colored_>::remove_input()
+{
+    // The lm-tig buckets past the edge-buckets contain the trivially maximal unitigs, only in the colored case.
+    const auto bucket_c = P_e.size() + (Colored_ ? parlay::num_workers() : 0);
+    parlay::parallel_for(1, bucket_c,
+        [&](const std::size_t b)
+        {
+            if(b < P_e.size())
+                P_e[b].unwrap().remove();
+
+            Unitig_File_Reader(lmtig_buckets_path + "/" + std::to_string(b)).remove_files();
+            if constexpr(Colored_)
+                G.vertex_color_map(b).remove();
+        }, 1);
+}
+
 }
 
 
@@ -0,0 +1,234 @@
+
+#include "Unitig_Links.hpp"
+#include "globals.hpp"
+#include "parlay/parallel.h"
+#include "fmt/format.h"
+
+#include <algorithm>
+#include <cstring>
+#include <cassert>
+
+
+namespace cuttlefish
+{
+
+template <uint16_t k>
+Unitig_Links<k>::Unitig_Links(const std::string& path_pref, const std::size_t bucket_count):
+    id_c(0)
+{
+    assert(bucket_count > 0);
+
+    B.reserve(bucket_count);
+    for(std::size_t b = 0; b < bucket_count; ++b)
+        B.emplace_back(bucket_t(path_pref + "_" + std::to_string(b), 8 * 1024));
+}
+
+
+template <uint16_t k>
+uint64_t Unitig_Links<k>::add(const std::string_view& seq, const std::string_view& seq_add)
+{
+    constexpr std::size_t l = (k > 1 ? k - 1 : 1);  // Overlap length.
+    const uint64_t len = seq.size() + seq_add.size();
+    assert(len >= k);
+
+    const auto id = id_c++;
+
+    // Returns the overlap at index `pos` of the label; it may span both parts.
+    char ov[l];
+    const auto overlap_at = [&](const std::size_t pos)
+    {
+        if(pos + l <= seq.size())
+            return overlap_t(seq.data() + pos);
+
+        for(std::size_t i = 0; i < l; ++i)
+            ov[i] = (pos + i < seq.size() ? seq[pos + i] : seq_add[pos + i - seq.size()]);
+
+        return overlap_t(ov);
+    };
+
+    const auto char_at = [&](const std::size_t pos){ return pos < seq.size() ? seq[pos] : seq_add[pos - seq.size()]; };
+
+    // The front end is exited through the reverse complement of the prefix.
+    add_end(overlap_at(0).reverse_complement(), DNA_Utility::complement(DNA_Utility::map_base(char_at(k - 1))), id, len, false);
+    add_end(overlap_at(len - l), DNA_Utility::map_base(char_at(len - k)), id, len, true);
+
+    return id;
+}
+
+
+template <uint16_t k>
+void Unitig_Links<k>::add_end_edges(const uint64_t* const end, const uint8_t edges)
+{
+    Kmer<k> v;
+    std::memcpy(v.data(), end, Kmer<k>::num_words() * sizeof(uint64_t));
+
+    // The end is exited through its suffix overlap.
+    overlap_t out;
+    if constexpr(k > 1)
+        out.from_suffix(v);
+    else
+        out = v;
+
+    add_end(out, v.front(), unmatched, 0, false, edges);
+}
+
+
+template <uint16_t k>
+void Unitig_Links<k>::add_end(const overlap_t& out, const base_t ext, const uint64_t id, const uint64_t len, const bool tail, const uint8_t edges)
+{
+    const auto key = out.canonical();
+    B[key.to_u64() % B.size()].unwrap().add(End{key, id, len, tail, key == out, ext, edges});
+}
+
+
+template <uint16_t k>
+template <typename T_f_>
+void Unitig_Links<k>::for_each_overlap(T_f_ f) const
+{
+    parlay::parallel_for(0, B.size(),
+    [&](const std::size_t b)
+    {
+        std::vector<End> E;
+        B[b].unwrap().load(E);
+        std::sort(E.begin(), E.end());
+
+        // The exiting edges of each unitig-end are attached to it, and their
+        // records are dropped.
+        std::size_t n = 0;  // Number of unitig-ends collected.
+        for(std::size_t i = 0, j; i < E.size(); i = j)
+        {
+            uint8_t edges = unknown_edges;
+            for(j = i; j < E.size() && E[j].same_kmer(E[i]); ++j)
+                if(E[j].id == unmatched)
+                    edges = (edges == unknown_edges ? 0 : edges) | E[j].edges;
+
+            for(auto x = i; x < j; ++x)
+                if(E[x].id != unmatched)
+                    E[n] = E[x],
+                    E[n++].edges = edges;
+        }
+
+        E.resize(n);
+
+        for(std::size_t i = 0, j; i < E.size(); i = j)
+        {
+            std::size_t r = i;
+            for(j = i; j < E.size() && E[j].key == E[i].key; ++j)
+                r += E[j].fw;
+
+            const auto pal = (E[i].key == E[i].key.reverse_complement());
+            assert(!pal || r == j);
+            f(E, i, r, j, pal);
+        }
+    }, 1);
+}
+
+
+template <uint16_t k>
+void Unitig_Links<k>::emit(std::vector<Padded<Character_Buffer<Streaming_File_Sink>>>& op_buf, const bool gfa2) const
+{
+    std::vector<Padded<std::string>> buf(parlay::num_workers());
+    for_each_overlap(
+        [&](const std::vector<End>& E, const std::size_t i, const std::size_t r, const std::size_t j, const bool pal)
+        {
+            auto& b = buf[parlay::worker_id()].unwrap();
+
+            // The `(k + 1)`-mer spanning the ends is to be an edge as seen
+            // from both of them.
+            const auto link = [&](const End& u, const End& v){ if(u.links_to(v) && v.links_to(u)) append_link(b, u, v, gfa2); };
+            if(pal)
+                for(auto u = i; u < j; ++u)
+                    for(auto v = u; v < j; ++v)
+                        link(E[u], E[v]);
+            else
+                for(auto u = i; u < r; ++u)
+                    for(auto v = r; v < j; ++v)
+                        link(E[u], E[v]);
+
+            if(b.size() >= 64 * 1024)
+                op_buf[parlay::worker_id()].unwrap() += b,
+                b.clear();
+        });
+
+    parlay::parallel_for(0, buf.size(), [&](const std::size_t w){ op_buf[w].unwrap() += buf[w].unwrap(); }, 1);
+}
+
+
+template <uint16_t k>
+void Unitig_Links<k>::match(std::vector<uint64_t>& M) const
+{
+    M.assign(2 * size(), unmatched);
+    for_each_overlap(
+        [&](const std::vector<End>& E, const std::size_t i, const std::size_t r, const std::size_t j, const bool pal)
+        {
+            const auto end = [&](const std::size_t x){ return 2 * E[x].id + E[x].tail; };
+            const auto free = [&](const std::size_t x){ return M[end(x)] == unmatched; };
+
+            // The ends are paired greedily over the same links as in `emit`.
+            // Each end belongs to a single overlap, so the pairs are disjoint.
+            const auto pair_up =
+                [&](const std::size_t u, const std::size_t v)
+                {
+                    if(free(u) && free(v) && end(u) != end(v) && E[u].links_to(E[v]) && E[v].links_to(E[u]))
+                        M[end(u)] = end(v), M[end(v)] = end(u);
+                };
+
+            if(pal)
+                for(auto u = i; u < j; ++u)
+                    for(auto v = u + 1; v < j && free(u); ++v)
+                        pair_up(u, v);
+            else
+                for(auto u = i; u < r; ++u)
+                    for(auto v = r; v < j && free(u); ++v)
+                        pair_up(u, v);
+        });
+}
+
+
+template <uint16_t k>
+void Unitig_Links<k>::remove()
+{
+    parlay::parallel_for(0, B.size(), [&](const std::size_t b){ B[b].unwrap().remove(); }, 1);
+    force_free(B);
+}
+
+
+template <uint16_t k>
+void Unitig_Links<k>::append_link(std::string& buf, const End& u, const End& v, const bool gfa2)
+{
+    constexpr std::size_t l = (k > 1 ? k - 1 : 1);  // Overlap length.
+    const auto append = [&buf](const uint64_t x){ const fmt::format_int v(x); buf.append(v.data(), v.size()); };
+
+    // Overlap coordinates at the end `e`, on the forward strand of its unitig.
+    const auto append_range = [&](const End& e)
+    {
+        if(e.tail)
+            append(e.len - l), buf.push_back('\t'), append(e.len), buf.push_back('$');
+        else
+            buf.append("0\t"), append(l);
+    };
+
+    const char o_u = (u.tail ? '+' : '-');  // Orientation of `u` exiting through its end.
+    const char o_v = (v.tail ? '-' : '+');  // Orientation of `v` entering through its end.
+    if(!gfa2)
+    {
+        buf.append("L\t"), append(u.id), buf.push_back('\t'), buf.push_back(o_u), buf.push_back('\t');
+        append(v.id), buf.push_back('\t'), buf.push_back(o_v), buf.push_back('\t');
+    }
+    else
+    {
+        buf.append("E\t*\t"), append(u.id), buf.push_back(o_u), buf.push_back('\t');
+        append(v.id), buf.push_back(o_v), buf.push_back('\t');
+        append_range(u), buf.push_back('\t');
+        append_range(v), buf.push_back('\t');
+    }
+
+    append(l), buf.append("M\n");
+}
+
+}
+
+
+
+// Template-instantiations for the required instances.
+ENUMERATE(INSTANCE_COUNT, INSTANTIATE, cuttlefish::Unitig_Links)
@@ -7,6 +7,9 @@
 #include "Build_Params.hpp"
 #include "Validation_Params.hpp"
 #include "Application.hpp"
+#include "Binary_Unitig_Reader.hpp"
+#include "Character_Buffer.hpp"
+#include "FASTA_Record.hpp"
 #include "version.hpp"
 #include "cxxopts/cxxopts.hpp"
 
@@ -14,12 +17,14 @@
 #include <vector>
 #include <iostream>
 #include <optional>
+#include <fstream>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
   int cf_build(int argc, char** argv);
   int cf_validate(int argc, char** argv);
+  int cf_convert(int argc, char** argv);
   int print_cf_version();
 #ifdef __cplusplus
 }
@@ -65,12 +70,12 @@ int cf_build(int argc, char** argv)
         ("ref", "construct a compacted reference de Bruijn graph (for FASTA input)")
         ("c,cutoff", "frequency cutoff for (k + 1)-mers (default: refs: " + std::to_string(cuttlefish::_default::CUTOFF_FREQ_REFS) + ", reads: " + std::to_string(cuttlefish::_default::CUTOFF_FREQ_READS) + ")",
             cxxopts::value<std::optional<uint32_t>>(cutoff))
-        ("path-cover", "extract a maximal path cover of the de Bruijn graph")
+        ("path-cover", "extract a maximal path cover of the de Bruijn graph (for Cuttlefish 3: glue the maximal unitigs into a spectrum-preserving string set; uncolored only)")
         ;
 
     options.add_options("cuttlefish_3")
         ("color", "whether to color the compacted graph or not")
-        ("subgraph-count", "number of subgraphs the original de Bruijn graph is broken into",
+        ("subgraph-count", "number of subgraphs the original de Bruijn graph is broken into; needs to be a power of 2, or 0 to choose automatically",
             cxxopts::value<std::size_t>()->default_value(std::to_string(cuttlefish::_default::SUBGRAPH_COUNT)))
         ("vertex-part-count", "number of vertex-partitions in the discontinuity graph; needs to be a power of 2",
             cxxopts::value<std::size_t>()->default_value(std::to_string(cuttlefish::_default::VERTEX_PART_COUNT)))
@@ -78,11 +83,14 @@ int cf_build(int argc, char** argv)
             cxxopts::value<std::size_t>()->default_value(std::to_string(cuttlefish::_default::LMTIG_BUCKET_COUNT)))
         ("gmtig-bucket-count", "number of buckets for global maximal unitigs",
             cxxopts::value<std::size_t>()->default_value(std::to_string(cuttlefish::_default::GMTIG_BUCKET_COUNT)))
+        ("resume", "checkpoint the construction phases in the working directory, and resume an interrupted construction from its last completed phase")
+        ("positional-output", "write the maximal unitigs in parallel to pre-computed positions in the output file (uncolored only)")
+        ("gzip", "compress the output in the BGZF (blocked gzip) format, in parallel")
         ;
 
     std::optional<uint16_t> format_code;
     options.add_options("cuttlefish_1")
-        ("f,format", "output format (0: FASTA, 1: GFA 1.0, 2: GFA 2.0, 3: GFA-reduced)",
+        ("f,format", "output format (0: FASTA, 1: GFA 1.0, 2: GFA 2.0, 3: GFA-reduced, 4: binary)",
             cxxopts::value<std::optional<uint16_t>>(format_code))
         ("track-short-seqs", "track existence of sequences shorter than k bases")
         ("poly-N-stretch", "includes information of polyN stretches in the tiling output")
@@ -122,6 +130,9 @@ int cf_build(int argc, char** argv)
         const auto vertex_part_count = result["vertex-part-count"].as<std::size_t>();
         const auto lmtig_bucket_count = result["lmtig-bucket-count"].as<std::size_t>();
         const auto gmtig_bucket_count = result["gmtig-bucket-count"].as<std::size_t>();
+        const auto resume = result["resume"].as<bool>();
+        const auto positional_output = result["positional-output"].as<bool>();
+        const auto gzip_output = result["gzip"].as<bool>();
         const auto vertex_db = result["vertex-set"].as<std::string>();
         const auto edge_db = result["edge-set"].as<std::string>();
         const auto thread_count = result["threads"].as<uint16_t>();
@@ -146,7 +157,7 @@ int cf_build(int argc, char** argv)
                                     seqs, lists, dirs,
                                     k, cutoff,
                                     color,
-                                    subgraph_count, vertex_part_count, lmtig_bucket_count, gmtig_bucket_count,
+                                    subgraph_count, vertex_part_count, lmtig_bucket_count, gmtig_bucket_count, resume, positional_output, gzip_output,
                                     vertex_db, edge_db, thread_count, max_memory, strict_memory,
                                     idx, min_len,
                                     output_file, format, track_short_seqs, poly_n_stretch, working_dir,
@@ -267,6 +278,75 @@ int cf_validate(int argc, char** argv)
 }
 */
 
+
+// Driver function for converting a binary compacted de Bruijn graph to FASTA.
+int cf_convert(int argc, char** argv)
+{
+    cxxopts::Options options("cuttlefish convert", "Convert a compacted de Bruijn graph in the binary unitig format to FASTA");
+    options.add_options()
+        ("i,input", "binary unitig file",
+            cxxopts::value<std::string>())
+        ("o,output", "output FASTA file",
+            cxxopts::value<std::string>())
+        ("h,help", "print usage");
+
+    try
+    {
+        auto result = options.parse(argc, argv);
+        if(result.count("help"))
+        {
+            std::cout << options.help() << std::endl;
+            return 0;
+        }
+
+        const auto input_file = result["input"].as<std::string>();
+        const auto output_file = result["output"].as<std::string>();
+
+        const cuttlefish::Binary_Unitig_Reader reader(input_file);
+        std::ofstream output(output_file);
+        if(!output)
+        {
+            std::cerr << "Error opening output file " << output_file << ". Aborting.\n";
+            std::exit(EXIT_FAILURE);
+        }
+
+        {
+            Character_Buffer<std::ofstream> buf(output);
+            std::string label;
+            std::vector<cuttlefish::Unitig_Color> color;
+            for(std::size_t i = 0; i < reader.size(); ++i)
+            {
+                reader.label(i, label);
+                if(!reader.colored())
+                    buf += FASTA_Record(i, label);
+                else
+                {
+                    color.assign(reader.color(i), reader.color(i) + reader.color_count(i));
+                    buf.operator+=<true>(FASTA_Record(i, label, color));
+                }
+            }
+        }
+
+        output.close();
+        if(!output)
+        {
+            std::cerr << "Error writing output file " << output_file << ". Aborting.\n";
+            std::exit(EXIT_FAILURE);
+        }
+
+        std::cout << "Converted " << reader.size() << " unitigs (k = " << reader.k() << ") to " << output_file << ".\n";
+    }
+    catch(const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        std::cerr << std::endl << "Usage :" << std::endl;
+        std::cerr << options.help() << std::endl;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+
 int print_cf_version()
 {
     std::cout << "cuttlefish " VERSION << std::endl;
@@ -7,9 +7,17 @@
 #include "Discontinuity_Graph_Contractor.hpp"
 #include "Contracted_Graph_Expander.hpp"
 #include "Unitig_Collator.hpp"
+#include "Binary_Unitig_Format.hpp"
+#include "Path_Cover.hpp"
 #include "globals.hpp"
 #include "profile.hpp"
 #include "parlay/parallel.h"
+#include "cereal/archives/binary.hpp"
+
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+#include <cstdlib>
 
 
 namespace cuttlefish
@@ -19,95 +27,224 @@ template <uint16_t k>
 dBG_Contractor<k>::dBG_Contractor(const Build_Params& params):
       params(params)
     , logistics(params)
-    , op_buf(parlay::num_workers(), op_buf_t(output_sink.sink()))
+    , budget(params)
+    , geometry(Atlas_Geometry::choose(params.subgraph_count(), input_bytes(logistics), parlay::num_workers()))
+    , op_sink_path(params.path_cover() ? logistics.path_cover_segments_path() : logistics.output_file_path())
+    , op_buf(parlay::num_workers(), op_buf_t(output_sink.sink(), params.path_cover() ? Output_Format::gfa1 : params.output_format()))
 {
     Edge_Frequency::set_edge_threshold(params.cutoff());
     std::cerr << "Edge frequency cutoff: " << params.cutoff() << ".\n";
+    std::cerr << "Memory budget: " << budget.total_bytes() / (1024 * 1024) << " MB" << (budget.strict() ? "" : " (soft)") << ".\n";
+    std::cerr << "Subgraph count: " << geometry.graph_count() << " (" << geometry.atlas_count() << " atlases of " << geometry.graph_per_atlas() << ").\n";
 }
 
 
 template <uint16_t k>
-template <bool Colored_>
-void dBG_Contractor<k>::construct()
+uint64_t dBG_Contractor<k>::input_bytes(const Data_Logistics& logistics)
 {
-    // Clear the output file and initialize the output sink.
-    const auto op_file_path = logistics.output_file_path();
-    clear_file(op_file_path);
-    output_sink.init_sink(op_file_path);
+    uint64_t bytes = 0;
+    for(const auto& path : logistics.input_paths_collection())
+        bytes += file_size(path);
 
-    Discontinuity_Graph<k, Colored_> gamma(params, logistics);  // The discontinuity graph.
+    return bytes;
+}
 
-    const auto t_0 = timer::now();
-    decltype(timer::now()) t_part;
 
+template <uint16_t k>
+template <bool Colored_>
+void dBG_Contractor<k>::construct()
 {
-    Subgraphs_Manager<k, Colored_> G(logistics, params.min_len(), gamma, op_buf);
+    typedef Phase_Manifest::Phase Phase;
 
-    if(params.is_read_graph())
+    Phase_Manifest manifest(logistics.phase_manifest_path(), params, geometry.graph_count());
+    const auto done = (params.resume() ? manifest.load() : Phase::none);    // Last completed phase.
+    if(done == Phase::collate)
     {
-        EXECUTE("partition", (Graph_Partitioner<k, true, Colored_>(G, logistics, params.min_len())).partition)
+        std::cerr << "The construction has been completed already, per the phase manifest at " << manifest.file_path() << ".\n";
+        return;
     }
+
+    if(done != Phase::none)
+        std::cerr << "Resuming the construction past its " << Phase_Manifest::name(done) << " phase.\n";
+
+    // Clear the output file and initialize the output sink. A resumed
+    // construction retains the output from its completed phases only. Path
+    // covers are extracted from the maximal unitigs staged in the working
+    // directory.
+    const auto op_file_path = logistics.output_file_path();
+    const auto path_cover = params.path_cover();
+    if(done == Phase::none)
+        clear_file(op_sink_path);
     else
     {
-        EXECUTE("partition", (Graph_Partitioner<k, false, Colored_>(G, logistics, params.min_len())).partition)
+        std::error_code ec;
+        std::filesystem::resize_file(op_sink_path, manifest.output_bytes(), ec);
+        if(ec)
+        {
+            std::cerr << "Error restoring the output file " << op_sink_path << ". Aborting.\n";
+            std::exit(EXIT_FAILURE);
+        }
     }
 
-    G.finalize();
+    output_sink.init_sink(op_sink_path, params.gzip_output() && !path_cover);
 
-    t_part = timer::now();
-    std::cerr << "Sequence splitting into subgraphs completed. Time taken: " << timer::duration(t_part - t_0) << " seconds.\n";
+    // GFA output and path covers identify the maximal unitigs as segments,
+    // and link them once they are all output.
+    const auto gfa = op_buf.front().unwrap().gfa();
+    const auto gfa2 = (params.output_format() == Output_Format::gfa2);
+    if(gfa)
+    {
+        links = (done == Phase::none ?
+                    std::make_unique<Unitig_Links<k>>(logistics.unitig_end_buckets_path(), params.gmtig_bucket_count()) :
+                    std::make_unique<Unitig_Links<k>>());
+        std::for_each(op_buf.begin(), op_buf.end(), [&](auto& b){ b.unwrap().set_segment_registry(links.get()); });
+
+        if(done == Phase::none && !path_cover)
+        {
+            auto header = Unitig_Links<k>::header(gfa2);
+            output_sink.sink().submit(header);
+        }
+    }
+
+    const auto gamma_p = (done == Phase::none ?
+                            std::make_unique<Discontinuity_Graph<k, Colored_>>(params, geometry.graph_count(), logistics, budget) :
+                            restore<Colored_>(done));
+    auto& gamma = *gamma_p; // The discontinuity graph.
 
+    auto t_s = timer::now();
+
+    if(done < Phase::subgraphs)
     {
-        EXECUTE("subgraphs", G.process)
+        decltype(timer::now()) t_part;
 
-        std::cerr << "Trivial maximal unitig count: " << G.trivial_mtig_count() << ".\n";
-        std::cerr << "Trivial ICC count: " << G.icc_count() << ".\n";
-    }
-}
+        {
+            Subgraphs_Manager<k, Colored_> G(logistics, budget, geometry, params.min_len(), gamma, op_buf);
 
-    const auto t_subg = timer::now();
-    std::cerr << "Subgraphs construction and contraction completed. Time taken: " << timer::duration(t_subg - t_part) << " seconds.\n";
+            if(params.is_read_graph())
+            {
+                EXECUTE("partition", (Graph_Partitioner<k, true, Colored_>(G, logistics, params.min_len())).partition)
+            }
+            else
+            {
+                EXECUTE("partition", (Graph_Partitioner<k, false, Colored_>(G, logistics, params.min_len())).partition)
+            }
 
-    std::cerr << "Edge-matrix size: " << gamma.E().size() << "\n";
-    std::cerr << "Phantom edge upper-bound: " << gamma.phantom_edge_upper_bound() << "\n";
-    std::cerr << "Expecting at most " << ((gamma.E().row_size(0) + gamma.phantom_edge_upper_bound()) / 2) << " more non-DCC maximal unitigs\n";
+            G.finalize();
 
-    open_p_v();
+            t_part = timer::now();
+            std::cerr << "Sequence splitting into subgraphs completed. Time taken: " << timer::duration(t_part - t_s) << " seconds.\n";
 
-    {
-        Discontinuity_Graph_Contractor<k, Colored_> contractor(gamma, P_v, logistics);
-        EXECUTE("contract", contractor.contract)
+            {
+                EXECUTE("subgraphs", G.process)
+
+                std::cerr << "Trivial maximal unitig count: " << G.trivial_mtig_count() << ".\n";
+                std::cerr << "Trivial ICC count: " << G.icc_count() << ".\n";
+            }
+        }
 
-        gamma.close();
+        gamma.close_lmtigs();
+        checkpoint(manifest, Phase::subgraphs, gamma);
+
+        t_s = timer::now();
+        std::cerr << "Subgraphs construction and contraction completed. Time taken: " << timer::duration(t_s - t_part) << " seconds.\n";
     }
 
-    const auto t_c = timer::now();
-    std::cerr << "Discontinuity-graph contraction completed. Time taken: " << timer::duration(t_c - t_subg) << " seconds.\n";
+    if(done < Phase::contract)
+    {
+        std::cerr << "Edge-matrix size: " << gamma.E().size() << "\n";
+        std::cerr << "Phantom edge upper-bound: " << gamma.phantom_edge_upper_bound() << "\n";
+        std::cerr << "Expecting at most " << ((gamma.E().row_size(0) + gamma.phantom_edge_upper_bound()) / 2) << " more non-DCC maximal unitigs\n";
 
-    open_p_e();
+        open_p_v();
 
+        {
+            Discontinuity_Graph_Contractor<k, Colored_> contractor(gamma, P_v, logistics, budget);
+            EXECUTE("contract", contractor.contract)
+
+            gamma.close();
+        }
+
+        checkpoint(manifest, Phase::contract, gamma);
+
+        const auto t_c = timer::now();
+        std::cerr << "Discontinuity-graph contraction completed. Time taken: " << timer::duration(t_c - t_s) << " seconds.\n";
+        t_s = t_c;
+    }
+
+    if(done < Phase::expand)
     {
-        Contracted_Graph_Expander<k, Colored_> expander(gamma, P_v, P_e, logistics);
-        EXECUTE("expand", expander.expand)
+        open_p_e();
+
+        {
+            Contracted_Graph_Expander<k, Colored_> expander(gamma, P_v, P_e, logistics, budget, params.resume());
+            EXECUTE("expand", expander.expand)
+        }
+
+        checkpoint(manifest, Phase::expand, gamma);
+
+        const auto t_e = timer::now();
+        std::cerr << "Expansion of contracted graph completed. Time taken: " << timer::duration(t_e - t_s) << " seconds.\n";
+        t_s = t_e;
     }
 
-    force_free(P_v);
+    // With checkpoints, the expansion input is retained till the expansion is
+    // recorded complete; it may also be left over from an interruption past
+    // that.
+    if(params.resume())
+        Contracted_Graph_Expander<k, Colored_>::remove_input(gamma, P_v, logistics.compressed_diagonal_path());
 
-    const auto t_e = timer::now();
-    std::cerr << "Expansion of contracted graph completed. Time taken: " << timer::duration(t_e - t_c) << " seconds.\n";
+    force_free(P_v);
 
     {
-        Unitig_Collator<k, Colored_> collator(gamma, P_e, logistics, op_buf, params.gmtig_bucket_count());
+        // The positional output is laid out past the end of the output file,
+        // so the pending output needs to be written out beforehand.
+        const auto positional_op = (!Colored_ && params.positional_output() && !params.gzip_output() && !gfa);
+        if(positional_op)
+            flush_output();
+
+        Unitig_Collator<k, Colored_> collator(gamma, P_e, logistics, budget, op_buf, params.gmtig_bucket_count(), params.resume(), positional_op);
         EXECUTE("collate", collator.collate)
-    }
 
-    // Flush data and close the output sink.
-    parlay::parallel_for(0, parlay::num_workers(),
-                        [&](const std::size_t idx){ op_buf[idx].unwrap().close(); }, 1);
-    output_sink.close_sink();
+        if(gfa && !path_cover)
+        {
+            EXECUTE("link", links->emit, op_buf, gfa2)
+            std::cerr << "Segment count: " << links->size() << ".\n";
+        }
+
+        // Flush data and close the output sink.
+        parlay::parallel_for(0, parlay::num_workers(),
+                            [&](const std::size_t idx){ op_buf[idx].unwrap().close(); }, 1);
+        output_sink.close_sink();
+
+        if(path_cover)
+        {
+            clear_file(op_file_path);
+            output_sink.init_sink(op_file_path, params.gzip_output());
+
+            Path_Cover<k> cover(*links, op_sink_path);
+            EXECUTE("cover", cover.extract, output_sink.sink(), params.output_format())
+            output_sink.close_sink();
+
+            std::cerr << "Path cover: " << cover.path_count() << " paths (" << cover.cycle_count() << " broken cycles) over " << links->size() << " maximal unitigs.\n";
+        }
+
+        if(params.output_format() == Output_Format::bin)
+            Binary_Unitig_Format::finalize(op_file_path, k, Colored_);
+
+        checkpoint(manifest, Phase::collate, gamma);
+        if(params.resume())
+            collator.remove_input();
+
+        if(gfa)
+            links->remove(),
+            links.reset();
+
+        if(path_cover)
+            remove_file(op_sink_path);
+    }
 
     const auto t_uc = timer::now();
-    std::cerr << "Unitigs-collation completed. Time taken: " << timer::duration(t_uc - t_e) << " seconds.\n";
+    std::cerr << "Unitigs-collation completed. Time taken: " << timer::duration(t_uc - t_s) << " seconds.\n";
 
     force_free(P_e);
 }
@@ -120,6 +257,92 @@ void dBG_Contractor<k>::construct()
 }
 
 
+template <uint16_t k>
+const std::string dBG_Contractor<k>::checkpoint_path(const Phase_Manifest::Phase p) const
+{
+    return logistics.checkpoint_path() + "_" + Phase_Manifest::name(p);
+}
+
+
+template <uint16_t k>
+uint64_t dBG_Contractor<k>::flush_output()
+{
+    parlay::parallel_for(0, parlay::num_workers(),
+                        [&](const std::size_t idx){ op_buf[idx].unwrap().close(); }, 1);
+    output_sink.close_sink(false);
+
+    const auto bytes = file_size(op_sink_path);
+    output_sink.init_sink(op_sink_path, params.gzip_output() && !params.path_cover());
+
+    return bytes;
+}
+
+
+template <uint16_t k>
+template <bool Colored_>
+void dBG_Contractor<k>::checkpoint(Phase_Manifest& manifest, const Phase_Manifest::Phase p, Discontinuity_Graph<k, Colored_>& gamma)
+{
+    if(!params.resume())
+        return;
+
+    const auto prev = manifest.phase();
+
+    // The output is closed already when the construction is complete.
+    const auto op_bytes = (p == Phase_Manifest::Phase::collate ? file_size(logistics.output_file_path()) : flush_output());
+
+    if(p != Phase_Manifest::Phase::collate)
+    {
+        // The checkpoint is written to a temporary file first, as the manifest
+        // refers to it only once complete.
+        const auto path = checkpoint_path(p);
+        const auto temp_path = path + ".tmp";
+        std::ofstream output(temp_path, std::ios::binary);
+        {
+            cereal::BinaryOutputArchive archive(output);
+            archive(gamma, P_v, P_e);
+            if(links)
+                archive(*links);
+        }
+        output.close();
+
+        std::error_code ec;
+        if(!output || (std::filesystem::rename(temp_path, path, ec), ec))
+        {
+            std::cerr << "Error writing checkpoint to " << path << ". Aborting.\n";
+            std::exit(EXIT_FAILURE);
+        }
+    }
+
+    manifest.record(p, op_bytes);
+    std::cerr << "Checkpointed the " << Phase_Manifest::name(p) << " phase.\n";
+
+    if(prev != Phase_Manifest::Phase::none)
+        remove_file(checkpoint_path(prev));
+}
+
+
+template <uint16_t k>
+template <bool Colored_>
+std::unique_ptr<Discontinuity_Graph<k, Colored_>> dBG_Contractor<k>::restore(const Phase_Manifest::Phase p)
+{
+    const auto path = checkpoint_path(p);
+    std::ifstream input(path, std::ios::binary);
+    if(!input)
+    {
+        std::cerr << "Error opening checkpoint at " << path << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    cereal::BinaryInputArchive archive(input);
+    auto gamma = std::make_unique<Discontinuity_Graph<k, Colored_>>(archive);
+    archive(P_v, P_e);
+    if(links)
+        archive(*links);
+
+    return gamma;
+}
+
+
 template <uint16_t k>
 void dBG_Contractor<k>::open_p_v()
 {
@@ -10,6 +10,7 @@ extern "C" {
 #endif
     int cf_build(int argc, char** argv);
     int cf_validate(int argc, char** argv);
+    int cf_convert(int argc, char** argv);
     int print_cf_version();
 #ifdef __cplusplus
 }
@@ -19,10 +20,11 @@ extern "C" {
 void display_help_message()
 {
     print_cf_version();
-    std::cout << "Supported commands: `build`, `help`, `version`.\n";
+    std::cout << "Supported commands: `build`, `convert`, `help`, `version`.\n";
 
     std::cout << "Usage:\n";
     std::cout << "\tcuttlefish build [options]\n";
+    std::cout << "\tcuttlefish convert [options]\n";
 }
 
 
@@ -45,6 +47,8 @@ int main(int argc, char** argv)
 
         if(command == "build")
             return cf_build(argc - 1, argv + 1);
+        else if(command == "convert")
+            return cf_convert(argc - 1, argv + 1);
         // else if(command == "validate")
         //     return cf_validate(argc - 1, argv + 1);
         else if(command == "help")
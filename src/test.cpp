@@ -1194,6 +1194,86 @@ void iterate_subgraphs(const std::string& bin_dir, const std::size_t bin_c)
 #include <memory>
 #include <functional>
 #include "rapidgzip/ParallelGzipReader.hpp"
+#include "Kmer_Utility.hpp"
+#include "Minimizer_Batch.hpp"
+#include "Minimizer_Iterator.hpp"
+#include <random>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+
+// Checks that the vectorized label-encoding is byte-identical to the scalar
+// encoding over `trial_c` random labels, with placeholder and lower-case bases.
+bool check_vectorized_label_encoding(const std::size_t trial_c)
+{
+    constexpr char base[] = "ACGTacgtNn";
+    constexpr std::size_t max_word_c = 16;
+
+    std::mt19937_64 rng(trial_c);
+    std::vector<char> label(32 * max_word_c);
+    std::vector<uint64_t> simd_enc(max_word_c), scalar_enc(max_word_c);
+
+    for(std::size_t t = 0; t < trial_c; ++t)
+    {
+        const std::size_t word_c = 1 + rng() % max_word_c;
+        std::for_each(label.begin(), label.end(), [&](auto& b){ b = base[rng() % (sizeof(base) - 1)]; });
+
+        Kmer_Utility::encode_checked_words(label.data(), word_c, simd_enc.data());
+        Kmer_Utility::encode_checked_words_scalar(label.data(), word_c, scalar_enc.data());
+        if(std::memcmp(simd_enc.data(), scalar_enc.data(), word_c * sizeof(uint64_t)) != 0)
+        {
+            std::cerr << "Vectorized label-encoding mismatches the scalar encoding at trial " << t << ".\n";
+            return false;
+        }
+    }
+
+    std::cerr << "Vectorized label-encoding matches the scalar encoding over " << trial_c << " labels.\n";
+    return true;
+}
+
+
+// Checks that the batch minimizer engine computes the same minimizer hashes
+// for the `k`-mers as `Min_Iterator`, with minimizer size `l`, over `trial_c`
+// random sequences.
+template <uint16_t k>
+bool check_batch_minimizers(const uint16_t l, const std::size_t trial_c)
+{
+    constexpr char base[] = "ACGTacgt";
+    constexpr std::size_t max_len = 5000;
+
+    std::mt19937_64 rng(trial_c);
+    std::string seq;
+    Min_Iterator<k> min_it(l);
+    Minimizer_Batch min_batch(k, l);
+
+    for(std::size_t t = 0; t < trial_c; ++t)
+    {
+        const std::size_t len = k + rng() % max_len;
+        seq.resize(len);
+        std::for_each(seq.begin(), seq.end(), [&](auto& b){ b = base[rng() % (sizeof(base) - 1)]; });
+
+        min_it.reset(seq.c_str());
+        min_batch.reset(seq.c_str(), len);
+        for(std::size_t i = 0; ; ++i)
+        {
+            if(min_batch.hash(i) != min_it.hash())
+            {
+                std::cerr << "Batch minimizer mismatches the iterator at k-mer " << i << " of trial " << t << ".\n";
+                return false;
+            }
+
+            if(i + k == len)
+                break;
+
+            min_it.advance(seq[i + k]);
+        }
+    }
+
+    std::cerr << "Batch minimizers match the iterator over " << trial_c << " sequences.\n";
+    return true;
+}
 
 
 int main(int argc, char** argv)
@@ -1260,6 +1340,10 @@ int main(int argc, char** argv)
     // const std::string bin_dir(argv[1]);
     // const std::size_t bin_c(std::atoi(argv[2]));
     // iterate_subgraphs<k>(bin_dir, bin_c);
+
+    // check_vectorized_label_encoding(1000000);
+
+    // check_batch_minimizers<30>(atoi(argv[1]), 10000);
     // cuttlefish::Parser(argv[1], std::atoi(argv[2])).parse();
 /*
 	auto file_reader = std::make_unique<StandardFileReader>(argv[1]);